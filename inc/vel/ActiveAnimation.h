@@ -1,6 +1,7 @@
 #pragma once
 
 #include <string>
+#include <vector>
 
 #include "vel/Animation.h"
 
@@ -10,6 +11,7 @@ namespace vel
 	struct ActiveAnimation
 	{
 		Animation*							animation; // pointer to animation held by current scene
+		std::vector<Channel*>				channels; // per armature bone, null when the animation doesn't animate it
 		std::string							animationName; // name relative to armature, no armature prefix
 		double								blendTime; // in ms
 		bool								repeat; // whether or not this animation should loop
@@ -2,6 +2,8 @@
 
 #include <optional>
 #include <string>
+#include <atomic>
+#include <cstdint>
 
 #include "glm/glm.hpp"
 #include "btBulletCollisionCommon.h"
@@ -13,6 +15,7 @@
 #include "vel/Mesh.h"
 #include "vel/Transform.h"
 #include "vel/Renderable.h"
+#include "vel/sac_handle.h"
 
 
 namespace vel
@@ -24,6 +27,8 @@ namespace vel
 	class Actor
 	{
 	private:
+		static std::atomic<uint32_t>					simulationVersion; // see getSimulationVersion()
+
 		bool											deleted;
 		bool											visible;
 		std::string										name;
@@ -34,13 +39,17 @@ namespace vel
 		ArmatureBone*									parentArmatureBone;
 		std::vector<Actor*>								childActors;
 		Armature*										armature;
-		std::vector<std::pair<size_t, std::string>>		activeBones; // the bones from the armature that are actually used by the mesh, 
+		std::vector<std::pair<size_t, Name>>			activeBones; // the bones from the armature that are actually used by the mesh, 
 																	// the glue between an armature and a mesh (index is mesh bone index, value is armature bone index)
 																	// TODO: could this be part of Renderable instead...?
 																				
 
 		std::optional<Renderable>						tempRenderable;
 		std::optional<Renderable*>						stageRenderable;
+		Stage*											stage; // the stage this actor was added to, null until then
+		bool											worldQueued; // in stage's dirty list, see getTransform()
+		sac_handle										stageHandle; // handle of this actor within Stage::actors
+		sac_handle										stageRenderableHandle; // handle of this actor within stageRenderable->actors
 
 		Mesh*											mesh; // pointer to mesh used by this Actor independant of renderable. required for headless mode since there will be no renderable instance
 
@@ -50,6 +59,19 @@ namespace vel
 		bool											autoTransform;
 		
 		std::vector<Sensor*>							contactSensors;
+
+		glm::mat4										worldMatrix; // cached, see getWorldMatrix()
+		uint32_t										worldVersion; // bumped every time worldMatrix is rebuilt
+		uint32_t										worldBuiltFromLocal; // transform version worldMatrix was built from
+		uint32_t										worldBuiltFromParent; // parent worldVersion worldMatrix was built from
+		bool											worldDirty; // parent changed
+		glm::vec3										worldBoundsMin; // mesh bounds under worldMatrix, or it's translation without a mesh
+		glm::vec3										worldBoundsMax;
+		uint32_t										spatialIndexVersion; // worldVersion last written to the stage's SpatialIndex
+
+		void											refreshWorldBounds();
+
+		friend class ActorMotionState; // writes the transform bullet moved without queueing, it's world's moved list covers it
 		
 
 
@@ -68,6 +90,13 @@ namespace vel
 		void											clearTempRenderable();
 		void											setStageRenderable(Renderable* r);
 		std::optional<Renderable*>						getStageRenderable(); //TODO: tf is this an optional pointer for???
+		void											setStage(Stage* s);
+		void											setWorldQueued(bool q);
+		bool											isWorldQueued() const;
+		void											setStageHandle(sac_handle h);
+		sac_handle										getStageHandle() const;
+		void											setStageRenderableHandle(sac_handle h);
+		sac_handle										getStageRenderableHandle() const;
 
 
 
@@ -80,16 +109,29 @@ namespace vel
 		void											setArmature(Armature* arm);
 		Armature*										getArmature();
 
-		const std::vector<std::pair<size_t, std::string>>& getActiveBones() const;
-		void											setActiveBones(std::vector<std::pair<size_t, std::string>> activeBones);
+		const std::vector<std::pair<size_t, Name>>&		getActiveBones() const;
+		void											setActiveBones(std::vector<std::pair<size_t, Name>> activeBones);
 		void											setParentActor(Actor* a);
 		void											setParentArmatureBone(ArmatureBone* b);
+		Actor*											getParentActor();
+		const std::vector<Actor*>&						getChildActors() const;
+		ArmatureBone*									getParentArmatureBone();
 		void											addChildActor(Actor* a);
+		// the caller may move the actor through it, so it's queued for it's stage's next updateWorldMatrices(). Only
+		// from the thread ticking the stage, use the const overload to read
 		Transform&										getTransform();
+		const Transform&								getTransform() const;
 		std::optional<Transform>&						getPreviousTransform();
 		void											updatePreviousTransform();
 		void											clearPreviousTransform();
-		glm::mat4										getWorldMatrix();
+		const glm::mat4&								getWorldMatrix();
+		void											refreshWorldMatrix(); // parent actor must already be up to date
+		uint32_t										getWorldVersion() const;
+		void											setSpatialIndexVersion(uint32_t v);
+		uint32_t										getSpatialIndexVersion() const;
+		void											refreshPoseBounds(); // animated actors only, their pose moves the skin without touching the world matrix
+		const glm::vec3&								getWorldBoundsMin() const; // as of the last refreshWorldMatrix() or refreshPoseBounds()
+		const glm::vec3&								getWorldBoundsMax() const;
 		glm::mat4										getWorldRenderMatrix(float alpha); // contains logic for interpolation
 		glm::vec3										getInterpolatedTranslation(float alpha);
 		glm::quat										getInterpolatedRotation(float alpha);
@@ -107,6 +149,12 @@ namespace vel
 
 
 		void											processTransform();
+		void											syncRigidBodyTransform();
+
+		// bumped whenever any actor's dynamic, rigidbody, autoTransform, parent, armature or mesh changes or an actor is added
+		// to or removed from a stage, so stages know when the lists of actors they tick have to be rebuilt
+		static uint32_t									getSimulationVersion();
+		static void										bumpSimulationVersion();
 
 		void											removeParentActor(bool calledFromRemoveChildActor = false);
 		void											removeChildActor(Actor* a, bool calledFromRemoveParentActor = false);
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "btBulletDynamicsCommon.h"
+
+
+namespace vel
+{
+	class Actor;
+	class CollisionWorld;
+
+	/*
+		Motion state of the rigidbodies we create for actors. Bullet only calls setWorldTransform() for active
+		bodies which aren't static or kinematic, so sleeping and static bodies cost nothing per tick. When the
+		actor has autoTransform set the new transform is written straight into it (after moving the current one
+		into the previous slot for interpolation) and the actor is appended to it's world's moved list, which is
+		how the world settles it's previous transform once it stops moving (see CollisionWorld::step()).
+	*/
+	class ActorMotionState : public btMotionState
+	{
+	private:
+		Actor*							actor;
+		CollisionWorld*					collisionWorld;
+		btTransform						transform;
+
+	public:
+										ActorMotionState(Actor* actor, CollisionWorld* collisionWorld, const btTransform& startTransform = btTransform::getIdentity());
+
+		void							getWorldTransform(btTransform& worldTrans) const override;
+		void							setWorldTransform(const btTransform& worldTrans) override;
+
+		// whether the actor's transform is kept up to date by one of these rather than by polling it's rigidbody
+		static bool						drives(Actor* a);
+	};
+}
@@ -4,6 +4,7 @@
 #include <string>
 
 #include "vel/Channel.h"
+#include "vel/Name.h"
 
 
 namespace vel
@@ -13,7 +14,7 @@ namespace vel
 		std::string				name; //global name including armature prefix
 		double					duration;
 		double					tps;
-		std::unordered_map<std::string, Channel> channels;
+		std::unordered_map<Name, Channel> channels; // keyed by bone name
 	};
 	
 }
\ No newline at end of file
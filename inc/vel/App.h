@@ -5,12 +5,19 @@
 #include <deque>
 #include <optional>
 #include <chrono>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
 
 #include "vel/Config.h"
 #include "vel/Window.h"
 #include "vel/GPU.h"
 #include "vel/Scene.h"
 #include "vel/AssetManager.h"
+#include "vel/JobSystem.h"
+#include "vel/FramePacer.h"
+#include "vel/FrameTelemetry.h"
+#include "vel/RenderSnapshot.h"
 
 
 struct GLFWusercontext;
@@ -27,23 +34,49 @@ namespace vel
     private:
 														App(Config conf);
 		static App*										instance;
-        std::unique_ptr<Window>							window;
-		std::unique_ptr<GPU>							gpu;
+		JobSystem										jobSystem;
+#ifndef HEADLESS_BUILD
+        std::unique_ptr<Window>							window; // null when headless
+		std::unique_ptr<GPU>							gpu; // null when headless
+#endif
+		glm::ivec2										headlessScreenSize;
+		InputState										headlessInputState; // never changes, there is nothing to read input from
 		AssetManager									assetManager;
 		std::deque<std::unique_ptr<Scene>>				sceneLoadingQueue;
         std::vector<std::unique_ptr<Scene>>				scenes;
 		Scene*											activeScene;
+
+		// scenes added but not yet picked up by a loader thread, guarded by loaderMutex
+		std::vector<std::thread>						loaderThreads;
+		std::deque<Scene*>								scenesToLoad;
+		std::mutex										loaderMutex;
+		std::condition_variable							loaderCondition;
+		bool											loaderShutdown = false;
+		void											loaderWorker();
+		void											promoteLoadedScenes();
+		void											executeHeadless();
+
+		// Config::PIPELINED_SIMULATION
+		RenderSnapshot									renderSnapshot;
+		JobCounter										simCounter;
+		std::vector<double>								simTickTimes; // written by the in flight ticks, recorded once they're done
+		float											simLerpInterval = 0.0f; // alpha of the scene once the in flight ticks are done
+		void											startSimulation();
+		void											waitForSimulation();
 		
         
 
-        std::chrono::high_resolution_clock::time_point	startTime;
+        std::chrono::steady_clock::time_point			startTime;
+		FramePacer										framePacer;
+		FrameTelemetry									telemetry;
+		FrameHistogram									titleWindow; // frame times since the title was last updated
+		void											waitUntil(double t, bool recordStats = true);
         bool											shouldClose = false;
         double											fixedLogicTime = 0.0;
         double											currentTime = 0.0;
         double											newTime = 0.0;
         double											frameTime = 0.0;
         double											accumulator = 0.0;        
-        std::vector<double>								averageFrameTimeArray;
         double											lastFrameTimeCalculation = 0.0;
         void											displayAverageFrameTime();
 		void											calculateAverageFrameTime();
@@ -57,6 +90,7 @@ namespace vel
     public:
         static App&										get();
         static void										init(Config conf);
+														~App();
 														App(App const&) = delete;
         void											operator=(App const&) = delete;
         void											addScene(Scene* scene, bool swapWhenLoaded = false);
@@ -76,12 +110,15 @@ namespace vel
 
 		void											forceImguiRender();
 
-		GPU*											getGPU();
+		GPU*											getGPU(); // nullptr when headless
+		bool											isHeadless() const;
 		bool											getPauseBufferClearAndSwap();
 		void											setPauseBufferClearAndSwap(bool in);
 
 		AssetManager&									getAssetManager();
-		Scene*											getNextSceneToLoad();
+		JobSystem&										getJobSystem();
+		FramePacer&										getFramePacer();
+		FrameTelemetry&									getFrameTelemetry();
 
 		void											removeScene(std::string name);
 		void											swapScene(std::string name);
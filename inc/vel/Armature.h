@@ -57,10 +57,10 @@ namespace vel
 		std::vector<ArmatureBone>&							getBones();
 		const std::vector<ArmatureBone>&					getBones() const;
 		ArmatureBone&										getBone(size_t index);
-		ArmatureBone*										getBone(std::string boneName);
+		ArmatureBone*										getBone(Name boneName);
 		const std::string&									getName() const;
 		const std::vector<std::pair<std::string, Animation*>>&		getAnimations() const;
-		size_t												getBoneIndex(std::string boneName);
+		size_t												getBoneIndex(Name boneName);
 		void												updateAnimation(double runTime);
 		Animation*											getAnimation(std::string animationName);
 		const std::vector<std::pair<std::string, Animation*>>&	getAnimations();
@@ -7,6 +7,8 @@
 #include "glm/glm.hpp"
 #include "glm/gtc/quaternion.hpp"
 
+#include "vel/Name.h"
+
 
 
 
@@ -18,6 +20,7 @@ namespace vel
 	struct ArmatureBone
 	{
 		std::string		name;
+		Name			id; // interned name, used for lookups
 		std::string		parentName;
 		size_t			parent;
 
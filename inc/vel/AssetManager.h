@@ -2,6 +2,10 @@
 
 #include <string>
 #include <unordered_map>
+#include <shared_mutex>
+#include <future>
+#include <atomic>
+#include <memory>
 
 //#include "plf_colony/plf_colony.h"
 //#include "robin_hood/robin_hood.h"
@@ -18,31 +22,55 @@
 #include "vel/Armature.h"
 
 #include "vel/AssetTrackers.h"
+#include "vel/GpuUploadScheduler.h"
 
 namespace vel
 {
 	class GPU;
 
+	// a load which is currently being performed by some thread. Other threads requesting the same asset
+	// register as waiters and block on ready, the loading thread adds a reference for each of them
+	// when it publishes the asset so there is no window where the asset could be removed from under them
+	template<typename R>
+	struct InFlightLoad
+	{
+		std::promise<R>				promise;
+		std::shared_future<R>		ready = promise.get_future().share();
+		size_t						waiters = 0;
+	};
+
 	class AssetManager
 	{
 	private:
 		GPU*												gpu;
 
+		// guards every sac and in flight map below. Lookups take a shared lock, anything that adds,
+		// removes or changes a usageCount takes a unique lock. File io and decoding is never done while
+		// holding it
+		mutable std::shared_mutex							registryMutex;
+
+		// pushed from any loading thread, sent on the main thread
+		GpuUploadScheduler									gpuUploads;
+		std::atomic<bool>									gpuPrioritiesStale; // a blocking scene may now be waiting on a BACKGROUND upload
+		void												promoteGpuUploads();
+		void												queueGpuUpload(GpuUpload::Type type, sac_handle tracker, size_t firstStepBytes, size_t totalBytes);
+		GpuUpload::Step										sendGpuUploadStep(GpuUpload& u);
+		void												notifyGpuLoadWatchers(std::vector<std::shared_ptr<LoadProgress>>& watchers, size_t bytes);
+
 		sac<Shader>											shaders;
 		sac<ShaderTracker>									shaderTrackers;
-		std::deque<ShaderTracker*>							shadersThatNeedGpuLoad;
 		
 		sac<Mesh>											meshes;
 		sac<MeshTracker>									meshTrackers;
-		std::deque<MeshTracker*>							meshesThatNeedGpuLoad;
+		std::unordered_map<std::string, std::shared_ptr<InFlightLoad<std::pair<std::vector<std::string>, std::string>>>> meshFilesInFlight;
 
 		sac<Texture>										textures;
 		sac<TextureTracker> 								textureTrackers;
-		std::deque<TextureTracker*>							texturesThatNeedGpuLoad;
+		std::unordered_map<Name, std::shared_ptr<InFlightLoad<void>>> texturesInFlight;
 
         sac<Cubemap>										infiniteCubemaps;
 		sac<InfiniteCubemapTracker> 						infiniteCubemapTrackers;
-		std::deque<InfiniteCubemapTracker*>					infiniteCubemapsThatNeedGpuLoad;
+		std::unordered_map<Name, std::shared_ptr<InFlightLoad<void>>> infiniteCubemapsInFlight;
 
 		// TODO: when we do local cubemaps, they will be a struct of Cubemap and transform data, since
 		// infinite cubemaps have no transforms, just image data, they are simply the Cubemap struct
@@ -65,34 +93,39 @@ namespace vel
 		~AssetManager();
 
 
-		void						sendNextToGpu();
+		bool						sendNextToGpu();
+		bool						sendToGpu(double seconds, size_t bytes); // as many upload steps as fit in the budget, at least one
 		void						sendAllToGpu();
+		size_t						getQueuedGpuBytes() const;
+		size_t						getQueuedGpuBytes(GpuUpload::Priority p) const;
+		void						watchGpuLoad(GpuUpload::Type type, Name name, std::shared_ptr<LoadProgress> progress);
+		void						refreshGpuPriorities(); // a scene became blocking, it's queued uploads are promoted before the next send
 
 		std::string					loadShader(std::string name, std::string vertFile, std::string fragFile);
-		Shader*						getShader(std::string name);
-		bool						shaderIsGpuLoaded(std::string name);
+		Shader*						getShader(Name name);
+		bool						shaderIsGpuLoaded(Name name);
 		void						removeShader(std::string name);
 
 		std::pair<std::vector<std::string>, std::string> loadMesh(std::string path);
 		MeshTracker*				addMesh(Mesh m);
-		Mesh*						getMesh(std::string name);
-		bool						meshIsGpuLoaded(std::string name);
+		Mesh*						getMesh(Name name);
+		bool						meshIsGpuLoaded(Name name);
 		void						removeMesh(std::string name);
 
 		std::string					loadTexture(std::string name, std::string type, std::string path, std::vector<std::string> mips = std::vector<std::string>());
-		Texture*					getTexture(std::string name);
-		bool						textureIsGpuLoaded(std::string name);
+		Texture*					getTexture(Name name);
+		bool						textureIsGpuLoaded(Name name);
 		void						removeTexture(std::string name);
         
         
         std::string                 loadInfiniteCubemap(std::string name, std::string path);
-        Cubemap*					getInfiniteCubemap(std::string name);
-		bool						infiniteCubemapIsGpuLoaded(std::string name);
+        Cubemap*					getInfiniteCubemap(Name name);
+		bool						infiniteCubemapIsGpuLoaded(Name name);
 		void						removeInfiniteCubemap(std::string name);
         
 
 		std::string					addMaterial(Material m);
-		Material*					getMaterial(std::string name);
+		Material*					getMaterial(Name name);
 		void						removeMaterial(std::string name);
 
 		Animation*					addAnimation(Animation a);
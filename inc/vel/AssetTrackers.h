@@ -1,6 +1,8 @@
 #pragma once
 
 #include <string>
+#include <vector>
+#include <memory>
 
 
 #include "vel/Shader.h"
@@ -11,6 +13,7 @@
 #include "vel/Cubemap.h"
 #include "vel/Animation.h"
 #include "vel/Armature.h"
+#include "vel/LoadProgress.h"
 
 
 
@@ -20,24 +23,30 @@ namespace vel
 		Shader* 		ptr = nullptr;
 		bool 			gpuLoaded = false;
 		size_t 			usageCount = 0;
+		std::vector<std::shared_ptr<LoadProgress>> gpuLoadWatchers; // scenes waiting on this upload
 	};
 	
 	struct MeshTracker{
 		Mesh* 			ptr = nullptr;
 		bool 			gpuLoaded = false;
 		size_t 			usageCount = 0;
+		std::vector<std::shared_ptr<LoadProgress>> gpuLoadWatchers; // scenes waiting on this upload
 	};
 	
 	struct TextureTracker{
 		Texture* 		ptr = nullptr;
 		bool 			gpuLoaded = false;
+		size_t			gpuSteps = 0; // upload steps sent so far, the texture exists on the gpu once this is above 0
 		size_t 			usageCount = 0;
+		std::vector<std::shared_ptr<LoadProgress>> gpuLoadWatchers; // scenes waiting on this upload
 	};
     
     struct InfiniteCubemapTracker{
 		Cubemap*	ptr = nullptr;
 		bool 			gpuLoaded = false;
+		size_t			gpuSteps = 0; // upload steps sent so far, see GPU::loadInfiniteCubemapStep()
 		size_t 			usageCount = 0;
+		std::vector<std::shared_ptr<LoadProgress>> gpuLoadWatchers; // scenes waiting on this upload
 	};
 	
 	struct MaterialTracker{
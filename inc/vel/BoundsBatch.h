@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+
+namespace vel
+{
+	/*
+		Axis aligned boxes stored as structure of arrays, one array per min/max component, so cull() can test them
+		against a frustum four at a time with SSE (falling back to plain loops where it isn't available). A box is
+		outside when the corner furthest along any plane's normal is behind it, which is conservative: boxes near a
+		frustum corner may be reported as visible.
+	*/
+	class BoundsBatch
+	{
+	public:
+		enum Component { MIN_X, MIN_Y, MIN_Z, MAX_X, MAX_Y, MAX_Z, COUNT };
+
+	private:
+		std::vector<float>			bounds[COUNT];
+
+	public:
+		size_t						size() const;
+		void						clear();
+		void						reserve(size_t n);
+		uint32_t					push(const glm::vec3& min, const glm::vec3& max); // returns the index
+
+		// writes 1 to visible[i] for every box at least partly inside the planes (see frustumPlanes()), 0 otherwise
+		void						cull(const std::array<glm::vec4, 6>& planes, uint8_t* visible) const;
+	};
+}
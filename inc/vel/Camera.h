@@ -1,5 +1,7 @@
 #pragma once
 
+#include <array>
+
 #include "glm/glm.hpp"
 #include "glm/gtc/matrix_transform.hpp"
 #include "glm/gtc/type_ptr.hpp"
@@ -26,6 +28,7 @@ namespace vel
 		glm::vec3			    up;
 		glm::mat4			    viewMatrix;
 		glm::mat4			    projectionMatrix;
+		std::array<glm::vec4, 6> frustumPlanes; // world space, of projectionMatrix * viewMatrix
 
 		void                    updateViewMatrix();
 		void                    updateProjectionMatrix();
@@ -35,6 +38,7 @@ namespace vel
 		void                    update();
 		glm::mat4               getViewMatrix();
 		glm::mat4               getProjectionMatrix();
+		const std::array<glm::vec4, 6>& getFrustumPlanes() const; // as of the last update()
 		glm::vec3               getPosition();
 		glm::ivec2				getScreenSize();
 		void                    setPosition(float x, float y, float z);
@@ -20,6 +20,7 @@
 #include "vel/CollisionDebugDrawer.h"
 #include "vel/CollisionObjectTemplate.h"
 #include "vel/ConvexCastResult.h"
+#include "vel/ActorMotionState.h"
 
 
 namespace vel
@@ -38,6 +39,10 @@ namespace vel
 		btDiscreteDynamicsWorld*				dynamicsWorld;
 		std::unordered_map<std::string, btCollisionShape*> collisionShapes;
 		sac<Sensor>								sensors;
+		std::vector<std::vector<Sensor*>>		manifoldSensorMatches; // per manifold scratch for processSensors(), kept to reuse capacity
+		int										matchedManifoldCount; // entries of manifoldSensorMatches filled by the last matchSensors()
+		double									stepTime; // milliseconds the last step() took
+		std::vector<Actor*>						movedActors; // actors whose ActorMotionState was set by the last step()
 		Camera*									camera;
 		CollisionDebugDrawer* 					collisionDebugDrawer;
 		std::unordered_map<std::string, CollisionObjectTemplate> collisionObjectTemplates;
@@ -60,7 +65,13 @@ namespace vel
 		void									removeGhostObject(btPairCachingGhostObject* go);
 		Sensor*									addSensor(Sensor s);
 		void									removeSensor(Sensor* s);
+		void									step(float delta);
+		double									getStepTime() const;
+		void									addMovedActor(Actor* a);
+		const std::vector<Actor*>&				getMovedActors() const;
 		void									processSensors();
+		void									matchSensors();
+		void									dispatchSensors();
 
 
 		std::optional<RaycastResult>			rayTest(btVector3 from, btVector3 to, std::vector<btCollisionObject*> blackList = {});
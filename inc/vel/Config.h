@@ -31,6 +31,21 @@ namespace vel
         bool                                OPENGL_DEBUG_CONTEXT = true;
 		std::string							APP_EXE_NAME = "MyApp.exe";
 		std::string							APP_NAME = "MyApp";
+		size_t								LOADER_THREADS = 2; // scenes which can be loading into main memory at once
+		size_t								JOB_THREADS = 0; // JobSystem workers besides the main thread, 0 uses one per remaining core
+		bool								VALIDATE_TICK_GRAPH = false; // crash when a fixed tick task touches a stage or world it didn't declare
+		double								FRAME_PACER_SLACK = 0.002; // seconds before a frame is due that the main loop stops sleeping and starts yielding
+		double								HITCH_THRESHOLD = 0.05; // seconds, slower frames are counted as hitches by FrameTelemetry
+		size_t								PROFILER_EVENTS_PER_THREAD = 16384; // zones kept per thread for Profiler::writeChromeTrace(), oldest are overwritten
+		double								GPU_UPLOAD_BUDGET = 0.002; // seconds per main loop cycle spent sending assets to the gpu, at least one step is always sent
+		size_t								GPU_UPLOAD_BUDGET_BYTES = 8 * 1024 * 1024; // bytes per main loop cycle sent to the gpu, same exception
+		bool								PIPELINED_SIMULATION = false; // fixed ticks run on the JobSystem while the last tick is drawn, adds a frame of latency
+#ifdef HEADLESS_BUILD
+		bool								HEADLESS = true; // built without glfw/glad/imgui, always headless
+#else
+		bool								HEADLESS = false; // no Window, GPU or ImGui, only the fixed tick runs
+#endif
+		bool								HEADLESS_REALTIME = true; // headless ticks follow the wall clock at LOGIC_TICK, otherwise back to back
 		
 
 		std::vector<ImGuiFont>				imguiFonts;
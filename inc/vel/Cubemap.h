@@ -11,10 +11,10 @@ namespace vel
 	{
 		std::string		name;
 		ImageData		primaryImageData;
-        unsigned int    hdrTexture;
-        unsigned int    envCubemap;
-        unsigned int    irradianceMap;
-        unsigned int    prefilterMap;
-        unsigned int    brdfLUTTexture;
+        unsigned int    hdrTexture = 0; // 0 until created by it's upload step, so a partial upload can be cleared
+        unsigned int    envCubemap = 0;
+        unsigned int    irradianceMap = 0;
+        unsigned int    prefilterMap = 0;
+        unsigned int    brdfLUTTexture = 0;
 	};
 }
\ No newline at end of file
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+
+
+namespace vel
+{
+	/*
+		Fixed size histogram of durations in the style of HdrHistogram. Values are kept in whole microseconds,
+		exactly below 64us and above that in 32 linear buckets per power of two, so any value reported back
+		is within ~3% of what was recorded. Covers up to ~71 minutes, longer durations are clamped.
+		Recording is O(log n) in the value and never allocates.
+	*/
+	class FrameHistogram
+	{
+	public:
+		struct Summary
+		{
+			uint64_t			count = 0;
+			double				mean = 0.0;	// all in seconds
+			double				p50 = 0.0;
+			double				p90 = 0.0;
+			double				p99 = 0.0;
+			double				p999 = 0.0;
+			double				max = 0.0;
+		};
+
+	private:
+		static constexpr size_t	exactBuckets = 64;
+		static constexpr size_t	subBuckets = 32;
+		static constexpr size_t	maxBit = 31;
+		static constexpr size_t	bucketCount = exactBuckets + (maxBit - 5) * subBuckets;
+
+		uint64_t				counts[bucketCount];
+		uint64_t				count;
+		double					sum;		// seconds
+		uint64_t				maxValue;	// microseconds
+
+		static size_t			bucketIndex(uint64_t micros);
+		static uint64_t			bucketUpperBound(size_t index);
+
+	public:
+		FrameHistogram();
+
+		void					record(double seconds);
+		void					reset();
+
+		uint64_t				getCount() const;
+		double					getMean() const;
+		double					getMax() const;
+		double					percentile(double p) const; // p in [0, 100]
+		Summary					summarize() const;
+	};
+}
@@ -0,0 +1,50 @@
+#pragma once
+
+#include <chrono>
+#include <cstddef>
+
+
+namespace vel
+{
+	/*
+		Waits for a deadline without burning a core. Sleeps until slack (plus however much the os has
+		been oversleeping lately) before the deadline, then yields for the remainder, so wake ups are
+		accurate even where the scheduler granularity is coarse. Keeps statistics of how late each
+		recorded wait woke up relative to it's deadline.
+	*/
+	class FramePacer
+	{
+	public:
+		using Clock = std::chrono::steady_clock;
+
+		struct Stats
+		{
+			size_t				waits = 0;
+			double				meanError = 0.0;	// milliseconds late, on average
+			double				maxError = 0.0;		// milliseconds late, worst case
+			double				stdDevError = 0.0;	// milliseconds
+		};
+
+	private:
+		static constexpr std::chrono::milliseconds	maxOversleep{ 4 }; // cap on what a single sleep can teach
+
+		Clock::duration			slack;
+		Clock::duration			oversleepEstimate;
+
+		size_t					waits;
+		double					errorSum;
+		double					errorSquaredSum;
+		double					errorMax;
+
+	public:
+		FramePacer(double slackSeconds = 0.002);
+
+		void					setSlack(double seconds);
+		double					getSlack() const;
+
+		void					waitUntil(Clock::time_point deadline, bool recordStats = true);
+
+		Stats					getStats() const;
+		void					resetStats();
+	};
+}
@@ -0,0 +1,63 @@
+#pragma once
+
+#include <string>
+#include <cstdint>
+
+#include "vel/FrameHistogram.h"
+
+
+namespace vel
+{
+	// parts of the main loop which are timed individually, each occurrence is one sample
+	enum class FramePhase
+	{
+		GPU_UPLOAD,		// AssetManager::sendToGpu()
+		INPUT,			// window events and input state
+		OUTER_LOOP,		// Scene::outerLoop()
+		DRAW,			// buffer clear and Scene::draw()
+		GUI,			// imgui render
+		PRESENT,		// buffer swap
+		SIM_WAIT,		// pipelined simulation, waiting on the last frame's fixed ticks
+		WAIT,			// pacing until the next frame is due
+		COUNT
+	};
+
+	/*
+		Distributions of frame time, fixed tick time and the time spent in each FramePhase, along with a
+		count of hitches (frames slower than a threshold). Memory use is fixed however long the App runs.
+		Recorded and read on the main thread.
+	*/
+	class FrameTelemetry
+	{
+	private:
+		FrameHistogram			frames;
+		FrameHistogram			ticks;
+		FrameHistogram			phases[(size_t)FramePhase::COUNT];
+		double					hitchThreshold;
+		uint64_t				hitches;
+		double					worstHitch;
+
+	public:
+		FrameTelemetry(double hitchThreshold = 0.05);
+
+		static const char*		phaseName(FramePhase p);
+
+		void					recordFrame(double seconds);
+		void					recordTick(double seconds);
+		void					recordPhase(FramePhase p, double seconds);
+		void					reset();
+
+		void					setHitchThreshold(double seconds);
+		double					getHitchThreshold() const;
+		uint64_t				getHitchCount() const;
+		double					getWorstHitch() const;
+
+		const FrameHistogram&	getFrames() const;
+		const FrameHistogram&	getTicks() const;
+		const FrameHistogram&	getPhase(FramePhase p) const;
+
+		// times are written in milliseconds, both return false if path could not be opened
+		bool					writeCsv(std::string path) const;
+		bool					writeJson(std::string path) const;
+	};
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <memory>
 #include <optional>
+#include <cstdint>
 
 #include "glm/glm.hpp"
 
@@ -23,6 +24,59 @@ namespace vel
 
 	class GPU
 	{
+	public:
+		// steps of loadInfiniteCubemapStep(): the hdr upload and environment capture, the irradiance convolution,
+		// one per prefilter mip level and the brdf lut
+		static constexpr size_t				PREFILTER_MIP_LEVELS = 5;
+		static constexpr size_t				INFINITE_CUBEMAP_STEPS = 3 + PREFILTER_MIP_LEVELS;
+
+		/*
+			Shaders can read the camera from a uniform block rather than loose uniforms, it's then uploaded once
+			per stage instead of being set on every shader:
+
+				layout (std140) uniform Camera
+				{
+					mat4 projection;
+					mat4 view;
+					mat4 camOffset;
+					vec3 camPos;
+				};
+
+			Shaders without the block keep working, applyCamera() sets their loose uniforms the first time they're
+			used with a new camera.
+		*/
+		static constexpr unsigned int		CAMERA_BLOCK_BINDING = 0;
+
+		/*
+			Same for skinning. The palettes of every skinned draw of a frame are uploaded together into a storage
+			buffer, and each draw only sets where it's palette starts:
+
+				layout (std430) readonly buffer Bones
+				{
+					mat4 bones[];
+				};
+				uniform int boneOffset; // bones[boneOffset + id]
+
+			Shaders with a loose "uniform mat4 bones[N]" get their whole palette in a single call instead.
+		*/
+		static constexpr unsigned int		BONE_BLOCK_BINDING = 1;
+
+		/*
+			And instancing. The model matrices of every instanced draw of a frame are uploaded together, an
+			instanced draw sets where it's matrices start and draws them all with one call:
+
+				layout (std430) readonly buffer Instances
+				{
+					mat4 instanceModels[];
+				};
+				uniform int instanceOffset; // model = instanceModels[instanceOffset + gl_InstanceID]
+
+			Shaders declaring the block always take their model matrix from it, unskinned draws sharing state are
+			drawn together and the rest one instance at a time. Shaders without it are drawn one by one with the
+			model uniform.
+		*/
+		static constexpr unsigned int		INSTANCE_BLOCK_BINDING = 2;
+
 	private:
 		Window*								window;
 
@@ -53,6 +107,27 @@ namespace vel
         unsigned int                        pbrCaptureRBO;
 
 		RenderMode							currentRenderMode;
+
+		// std140 uniform buffer holding the camera of the stage being drawn, bound to CAMERA_BLOCK_BINDING for
+		// the lifetime of the gpu
+		unsigned int						cameraUBO;
+		uint32_t							cameraVersion;
+		glm::mat4							cameraProjection;
+		glm::mat4							cameraView;
+		glm::mat4							cameraOffset;
+		glm::vec3							cameraPosition;
+
+		// storage buffers holding the frame's bone palettes and instance matrices, bound to their BLOCK_BINDING,
+		// they only ever grow
+		unsigned int						boneSSBO;
+		size_t								boneSSBOCapacity; // in bytes
+		unsigned int						instanceSSBO;
+		size_t								instanceSSBOCapacity;
+
+		void								uploadStorage(unsigned int buffer, size_t& capacity, unsigned int binding, const void* data, size_t size);
+
+		GLint								uniformLocation(const Name& name) const;
+		void								resolveUniforms(Shader* s);
         
 
 	public:
@@ -73,7 +148,8 @@ namespace vel
 		void								loadShader(Shader* s);
 		void								loadMesh(Mesh* m);
 		void								loadTexture(Texture* t);
-        void                                loadInfiniteCubemap(Cubemap* h);
+		void								loadTextureLevel(Texture* t, size_t level); // 0 creates the texture, then one per entry of mips
+        void                                loadInfiniteCubemapStep(Cubemap* h, size_t step); // 0 to INFINITE_CUBEMAP_STEPS - 1, in order
 
 
 		void								useShader(Shader* s);
@@ -81,14 +157,27 @@ namespace vel
 		void								useMaterial(Material* m);
 		void								useMesh(Mesh* m);
 
-		void								setShaderBool(const std::string &name, bool value) const;
-		void								setShaderInt(const std::string &name, int value) const;
-		void								setShaderFloat(const std::string &name, float value) const;
-		void								setShaderMat4(const std::string &name, glm::mat4 value) const;
-		void								setShaderVec3(const std::string &name, glm::vec3 value) const;
-		void								setShaderVec4(const std::string &name, glm::vec4 value) const;
+		void								setShaderBool(const Name& name, bool value) const;
+		void								setShaderInt(const Name& name, int value) const;
+		void								setShaderFloat(const Name& name, float value) const;
+		void								setShaderMat4(const Name& name, glm::mat4 value) const;
+		void								setShaderVec3(const Name& name, glm::vec3 value) const;
+		void								setShaderVec4(const Name& name, glm::vec4 value) const;
+
+		// by location, for the handles of Shader::uniforms, -1 is ignored
+		void								setShaderMat4(GLint location, const glm::mat4& value) const;
+		void								setShaderVec3(GLint location, const glm::vec3& value) const;
+
+		void								setCamera(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& position, const glm::mat4& offset);
+		void								applyCamera(); // gives the active shader the camera if it doesn't read it from the Camera block
+
+		void								setBonePalette(const std::vector<glm::mat4>& palette); // every palette of the frame
+		void								useBones(const std::vector<glm::mat4>& palette, uint32_t begin, uint32_t end); // a draw's range of it
+
+		void								setInstanceMatrices(const std::vector<glm::mat4>& matrices); // every instanced draw of the frame
 
 		void								drawGpuMesh();
+		void								drawGpuMeshInstanced(uint32_t begin, uint32_t count); // range of the instance matrices
 		void								clearDepthBuffer();
 
 		void								finish();
@@ -103,6 +192,10 @@ namespace vel
 		void								clearMesh(Mesh* m);
 		void								clearTexture(Texture* t);
 
+		// image data is freed as each level or step is sent, these free what an unfinished upload never reached
+		void								freeTextureLevels(Texture* t, size_t firstLevel);
+		void								freeInfiniteCubemapData(Cubemap* h);
+
 		void                                drawSkybox(glm::mat4 projectionMatrix, glm::mat4 viewMatrix, unsigned int cm);
 
 		void								setCurrentRenderMode(RenderMode rm);
@@ -0,0 +1,79 @@
+#pragma once
+
+#include <deque>
+#include <atomic>
+#include <functional>
+#include <cstddef>
+
+#include "vel/sac_handle.h"
+#include "vel/MpscQueue.h"
+
+
+namespace vel
+{
+	// an asset waiting to be sent to the gpu, the tracker is referenced by handle so an asset removed
+	// before it's upload simply resolves to nothing when popped
+	struct GpuUpload
+	{
+		enum class Type { SHADER, MESH, TEXTURE, INFINITE_CUBEMAP };
+
+		// BLOCKING is for assets a scene which is (or is about to become) active is waiting on, BACKGROUND for
+		// scenes being loaded ahead of time. Every BLOCKING upload is sent before any BACKGROUND one
+		enum class Priority { BLOCKING, BACKGROUND, COUNT };
+
+		// outcome of sending one step of an upload
+		enum class Step { DONE, MORE, MISSING };
+
+		Type			type = Type::SHADER;
+		sac_handle		tracker;
+		Priority		priority = Priority::BLOCKING;
+		size_t			step = 0; // large uploads (a texture's mip levels) are sent one step at a time
+		size_t			stepBytes = 0; // size of the next step
+		size_t			remainingBytes = 0; // size of every step not yet sent, including the next
+	};
+
+	/*
+		Queue of pending gpu uploads which sends as many of them per call to run() as fit in a time and byte
+		budget, BLOCKING before BACKGROUND and oldest first within each. The first step is always sent so
+		the queue keeps moving whatever the budget, any further step is only started if it's bytes fit in
+		what's left and the time has not yet run out. How a step is sent is up to the caller, AssetManager
+		talks to the GPU, anything else (a recording backend for example) can be used in it's place.
+
+		push() and the queued counters can be used from any thread, run() only from one thread at a time.
+	*/
+	class GpuUploadScheduler
+	{
+	public:
+		// sends the next step of u, on MORE u.step, u.stepBytes and u.remainingBytes must describe the step
+		// after it. MISSING means the asset was removed before it was sent, nothing counts against the budget
+		using UploadFn = std::function<GpuUpload::Step(GpuUpload& u)>;
+
+	private:
+		static constexpr size_t						priorityCount = (size_t)GpuUpload::Priority::COUNT;
+		static thread_local GpuUpload::Priority		threadPriority;
+
+		MpscQueue<GpuUpload>						incoming;
+		std::deque<GpuUpload>						queues[priorityCount];
+		std::atomic<size_t>							queuedBytes[priorityCount];
+		std::atomic<size_t>							queuedUploads[priorityCount];
+
+	public:
+		GpuUploadScheduler();
+
+		// priority uploads pushed from the calling thread should use, BLOCKING unless set
+		static void									setThreadPriority(GpuUpload::Priority p);
+		static GpuUpload::Priority					getThreadPriority();
+
+		void										push(GpuUpload u);
+		size_t										run(double seconds, size_t bytes, const UploadFn& upload); // returns steps sent
+
+		// moves the queued uploads below BLOCKING for which blocking returns true up to BLOCKING, keeping their
+		// order (an upload part way through it's steps included). Same thread as run(), returns uploads moved
+		size_t										promote(const std::function<bool(const GpuUpload& u)>& blocking);
+		bool										empty() const;
+
+		size_t										getQueuedBytes(GpuUpload::Priority p) const;
+		size_t										getQueuedBytes() const;
+		size_t										getQueuedUploads(GpuUpload::Priority p) const;
+	};
+}
@@ -0,0 +1,184 @@
+#pragma once
+
+#include <atomic>
+#include <vector>
+#include <deque>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <cstddef>
+
+
+namespace vel
+{
+	class JobCounter;
+
+	struct Job
+	{
+		std::function<void()>	fn;
+		JobCounter*				signal = nullptr; // decremented once fn has returned
+	};
+
+	/*
+		Counts jobs which have been submitted against it but not yet completed. Jobs can be made to
+		depend on a counter, in which case they are only queued once it reaches zero. A counter must
+		outlive every job signalling it, every job depending on it and every wait() on it, isDone() alone
+		is not enough to know a counter can be destroyed, JobSystem::wait() is.
+	*/
+	class JobCounter
+	{
+	private:
+		friend class JobSystem;
+
+		std::atomic<size_t>		pending{ 0 };
+		std::mutex				continuationMutex;
+		std::vector<Job>		continuations; // jobs waiting for pending to reach zero
+
+	public:
+		bool					isDone() const { return this->pending.load(std::memory_order_acquire) == 0; }
+	};
+
+	/*
+		Bump allocator for short lived scratch memory, one per thread (see local()). Memory is only ever
+		handed back in bulk by releasing to a marker, which ArenaScope does automatically, so allocations
+		made inside a job are gone once that job's ArenaScope closes. Storage is returned uninitialized
+		and destructors are never run, so only use it for trivially destructible types.
+	*/
+	class JobArena
+	{
+	private:
+		static constexpr size_t	defaultBlockSize = 64 * 1024;
+
+		std::vector<std::unique_ptr<unsigned char[]>>	blocks;
+		std::vector<size_t>		blockSizes;
+		size_t					block = 0;	// block currently being allocated from
+		size_t					offset = 0;	// bytes used in that block
+
+	public:
+		struct Marker
+		{
+			size_t				block;
+			size_t				offset;
+		};
+
+		static JobArena&		local();
+
+		void*					allocate(size_t bytes, size_t align = alignof(std::max_align_t));
+		template<typename T>
+		T*						allocate(size_t count) { return static_cast<T*>(this->allocate(count * sizeof(T), alignof(T))); }
+
+		Marker					mark() const;
+		void					release(Marker m);
+	};
+
+	class ArenaScope
+	{
+	private:
+		JobArena&				arena;
+		JobArena::Marker		marker;
+
+	public:
+		ArenaScope() : arena(JobArena::local()), marker(arena.mark()) {}
+		~ArenaScope() { this->arena.release(this->marker); }
+		ArenaScope(const ArenaScope&) = delete;
+		ArenaScope&				operator=(const ArenaScope&) = delete;
+
+		void*					allocate(size_t bytes, size_t align = alignof(std::max_align_t)) { return this->arena.allocate(bytes, align); }
+		template<typename T>
+		T*						allocate(size_t count) { return this->arena.allocate<T>(count); }
+	};
+
+	/*
+		Work stealing job system. Every worker thread, plus the thread which constructed the JobSystem
+		(the main thread, as App owns it), has it's own deque. Jobs submitted from a worker go to the back
+		of that worker's deque and it pops from the back, idle workers steal from the front of the others.
+		Threads which don't own a deque (the scene loaders for example) hand their jobs out round robin.
+
+		The main thread never sleeps on the job system, instead wait() runs queued jobs until the counter
+		it's waiting on reaches zero, so the main thread is effectively always one of the workers.
+	*/
+	class JobSystem
+	{
+	private:
+		struct WorkerQueue
+		{
+			std::mutex			mutex;
+			std::deque<Job>		jobs;
+		};
+
+		std::vector<std::unique_ptr<WorkerQueue>>	queues; // index 0 belongs to the constructing thread
+		std::vector<std::thread>	threads;
+		std::atomic<size_t>			queuedJobs{ 0 };
+		std::atomic<size_t>			submitIndex{ 0 };
+
+		std::mutex					sleepMutex;
+		std::condition_variable		sleepCondition;
+		bool						shutdown = false;
+
+		size_t						localQueueIndex() const;
+		void						push(Job j);
+		bool						tryPop(Job& out);
+		void						execute(Job j);
+		void						signalDone(JobCounter* c);
+		void						workerLoop(size_t index);
+
+	public:
+		JobSystem(size_t workerThreads = 0); // 0 starts one worker per core besides the calling thread's
+		~JobSystem();
+		JobSystem(const JobSystem&) = delete;
+		JobSystem&					operator=(const JobSystem&) = delete;
+
+		size_t						getThreadCount() const; // workers including the constructing thread
+
+		void						run(std::function<void()> fn, JobCounter* signal = nullptr, JobCounter* dependsOn = nullptr);
+		void						wait(JobCounter& c);
+
+		// calls fn(begin, end) over [0, count) split into ranges of at most grain, and returns once every range
+		// has been processed. Runs inline when count fits in a single range
+		template<typename F>
+		void						parallelFor(size_t count, size_t grain, F&& fn);
+
+		// calls fn(item) for every element of items
+		template<typename T, typename F>
+		void						parallelForEach(std::vector<T>& items, size_t grain, F&& fn);
+	};
+
+	template<typename F>
+	void JobSystem::parallelFor(size_t count, size_t grain, F&& fn)
+	{
+		if (grain == 0)
+			grain = 1;
+
+		if (count <= grain || this->threads.empty())
+		{
+			if (count > 0)
+				fn((size_t)0, count);
+
+			return;
+		}
+
+		JobCounter counter;
+
+		// first range is kept for the calling thread
+		for (size_t begin = grain; begin < count; begin += grain)
+		{
+			size_t end = begin + grain < count ? begin + grain : count;
+			this->run([&fn, begin, end] { fn(begin, end); }, &counter);
+		}
+
+		fn((size_t)0, grain);
+
+		this->wait(counter);
+	}
+
+	template<typename T, typename F>
+	void JobSystem::parallelForEach(std::vector<T>& items, size_t grain, F&& fn)
+	{
+		this->parallelFor(items.size(), grain, [&items, &fn](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
+				fn(items[i]);
+		});
+	}
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+#include <atomic>
+#include <cstddef>
+
+
+namespace vel
+{
+	/*
+		Counters describing how far along a Scene is in loading. They are bumped by the loader threads
+		(decoding) and by AssetManager::sendToGpu() on the main thread (uploads), and can be read
+		from anywhere at any time without locking, so polling them for a loading screen costs nothing.
+	*/
+	struct LoadProgress
+	{
+		std::atomic<size_t>		assetsDecoded{ 0 };			// shaders, mesh files, textures and cubemaps loaded into main memory
+		std::atomic<size_t>		gpuAssetsRequested{ 0 };	// assets this scene is waiting on to reach the gpu
+		std::atomic<size_t>		gpuAssetsUploaded{ 0 };		// of those, how many have been uploaded
+		std::atomic<size_t>		bytesUploaded{ 0 };			// approximate size of the vertex/index/image data uploaded
+		std::atomic<bool>		blocking{ false };			// the scene will be swapped to once loaded, so it's uploads are BLOCKING
+	};
+}
@@ -4,6 +4,7 @@
 #include <string>
 #include <deque>
 #include <thread>
+#include <mutex>
 
 
 namespace vel 
@@ -13,6 +14,7 @@ namespace vel
     private:
 
         std::deque<std::string>		fileBuffer;
+        std::mutex					fileMutex; // loader threads log too
         std::string					filePath;
 
                                     Log(std::string logFilePath);
@@ -27,6 +27,8 @@ namespace vel
 		std::vector<MeshBone>				bones;
 		std::optional<GpuMesh>              gpuMesh;
 		glm::mat4							globalInverseMatrix;
+		glm::vec3							boundsMin; // local bounds of the vertices (bind pose for skinned meshes)
+		glm::vec3							boundsMax;
 
 
 	public:
@@ -34,8 +36,11 @@ namespace vel
 		void								addVertexWeight(unsigned int vertexIndex, unsigned int boneIndex, float weight);
 		void                                setGpuMesh(GpuMesh gm);
 		void								setVertices(std::vector<Vertex>& vertices);
+		void								setVertices(std::vector<Vertex>&& vertices);
 		void								setIndices(std::vector<unsigned int>& indices);
+		void								setIndices(std::vector<unsigned int>&& indices);
 		void								setBones(std::vector<MeshBone>& bones);
+		void								setBones(std::vector<MeshBone>&& bones);
 		const std::optional<GpuMesh>&       getGpuMesh() const;
 		const std::string                   getName() const;
 		const std::vector<Vertex>&			getVertices() const;
@@ -47,6 +52,9 @@ namespace vel
 		MeshBone&							getBone(size_t index);
 		MeshBone*							getBone(std::string boneName);
 		const std::vector<MeshBone>&		getBones() const;
+		void								setBounds(glm::vec3 min, glm::vec3 max);
+		const glm::vec3&					getBoundsMin() const;
+		const glm::vec3&					getBoundsMax() const;
 
 	};
     
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <atomic>
+#include <utility>
+
+
+namespace vel
+{
+	/*
+		Unbounded lock-free multi producer / single consumer queue (Vyukov). Any number of threads
+		may push(), but only one thread may pop() at a time. A push is a single atomic exchange, so
+		producers never block each other or the consumer.
+	*/
+	template<typename T>
+	class MpscQueue
+	{
+	private:
+		struct Node
+		{
+			std::atomic<Node*>	next;
+			T					value;
+		};
+
+		std::atomic<Node*>		head; // most recently pushed node, producers exchange this
+		Node*					tail; // stub node, it's next is the oldest value, consumer only
+
+	public:
+		MpscQueue();
+		~MpscQueue();
+		MpscQueue(const MpscQueue&) = delete;
+		MpscQueue&				operator=(const MpscQueue&) = delete;
+
+		void					push(T value);
+		bool					pop(T& out);
+		bool					empty() const;
+	};
+
+	template<typename T>
+	MpscQueue<T>::MpscQueue() :
+		head(new Node{ {nullptr}, T() }),
+		tail(head.load(std::memory_order_relaxed))
+	{}
+
+	template<typename T>
+	MpscQueue<T>::~MpscQueue()
+	{
+		T discard;
+		while (this->pop(discard)) {}
+
+		delete this->tail;
+	}
+
+	template<typename T>
+	void MpscQueue<T>::push(T value)
+	{
+		Node* n = new Node{ {nullptr}, std::move(value) };
+
+		// between the exchange and the store below the node is not yet reachable from the consumer, pop()
+		// will simply report empty until the link is published
+		Node* prev = this->head.exchange(n, std::memory_order_acq_rel);
+		prev->next.store(n, std::memory_order_release);
+	}
+
+	template<typename T>
+	bool MpscQueue<T>::pop(T& out)
+	{
+		Node* next = this->tail->next.load(std::memory_order_acquire);
+		if (next == nullptr)
+			return false;
+
+		out = std::move(next->value);
+		delete this->tail;
+		this->tail = next;
+
+		return true;
+	}
+
+	template<typename T>
+	bool MpscQueue<T>::empty() const
+	{
+		return this->tail->next.load(std::memory_order_acquire) == nullptr;
+	}
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <cstdint>
+#include <cstddef>
+#include <string>
+#include <functional>
+#include <type_traits>
+
+
+namespace vel
+{
+	/*
+		64 bit FNV-1a hash of a string used as an identifier. Comparing and hashing two Names is
+		a single integer operation, and Names built from string literals are hashed at compile time.
+
+		Names built implicitly, from literals, arrays, pointers or strings, are just the hash, which is all
+		a lookup needs, and cost no lock or allocation. Where a name is kept as a key (sac inserts, bone
+		ids...) build it with Name::interned() instead, which copies the text into a global table once.
+		c_str()/str() then work for that Name and for any hash only Name equal to it, and two different
+		strings hashing the same are caught in every build rather than silently comparing equal.
+		Name::literal() keeps a pointer to it's text without interning, for string literals only.
+	*/
+	class Name
+	{
+	private:
+		uint64_t					hash;
+		const char*					text; // null when only the hash is known
+
+		static constexpr uint64_t	fnvOffsetBasis = 14695981039346656037ull;
+		static constexpr uint64_t	fnvPrime = 1099511628211ull;
+
+		constexpr Name(uint64_t hash, const char* text) : hash(hash), text(text) {}
+
+		static const char*			lookup(uint64_t hash); // interned text of a hash, null if it never was
+
+	public:
+		static constexpr uint64_t	hashString(const char* s, size_t len)
+		{
+			uint64_t h = fnvOffsetBasis;
+			for (size_t i = 0; i < len; i++)
+			{
+				h ^= (uint64_t)(unsigned char)s[i];
+				h *= fnvPrime;
+			}
+			return h;
+		}
+
+		static constexpr size_t		length(const char* s)
+		{
+			size_t len = 0;
+			while (s[len] != '\0')
+				len++;
+			return len;
+		}
+
+		constexpr Name() : hash(fnvOffsetBasis), text("") {}
+
+		// hash only, literals are hashed at compile time where the Name is constexpr
+		template<size_t N>
+		constexpr Name(const char (&s)[N]) : hash(hashString(s, length(s))), text(nullptr) {}
+		template<typename P, std::enable_if_t<std::is_same_v<P, const char*> || std::is_same_v<P, char*>, int> = 0>
+		Name(P s) : hash(hashString(s, length(s))), text(nullptr) {}
+		Name(const std::string& s) : hash(hashString(s.data(), s.size())), text(nullptr) {}
+
+		// anything implicitly convertible to std::string (nlohmann::json string values for example)
+		template<typename S, typename = std::enable_if_t<!std::is_same_v<S, std::string> &&
+			!std::is_convertible_v<const S&, const char*> && std::is_convertible_v<const S&, std::string>>>
+		Name(const S& s) : Name(std::string(s)) {}
+
+		static Name					interned(const std::string& s); // exits on a hash collision
+
+		// keeps the pointer, so only for string literals (or other static storage). Writable buffers are refused
+		template<size_t N>
+		static constexpr Name		literal(const char (&s)[N]) { return Name(hashString(s, length(s)), s); }
+		template<size_t N>
+		static Name					literal(char (&s)[N]) = delete;
+
+		constexpr uint64_t			getHash() const { return this->hash; }
+		const char*					c_str() const; // "" if the text was never interned
+		std::string					str() const; // the hash in hex if the text was never interned
+
+		constexpr bool				operator==(const Name& other) const { return this->hash == other.hash; }
+		constexpr bool				operator!=(const Name& other) const { return this->hash != other.hash; }
+		constexpr bool				operator<(const Name& other) const { return this->hash < other.hash; }
+	};
+
+	inline std::string operator+(const std::string& lhs, const Name& rhs) { return lhs + rhs.str(); }
+	inline std::string operator+(const char* lhs, const Name& rhs) { return std::string(lhs) + rhs.str(); }
+}
+
+namespace std
+{
+	template<>
+	struct hash<vel::Name>
+	{
+		size_t operator()(const vel::Name& n) const noexcept { return (size_t)n.getHash(); }
+	};
+}
@@ -0,0 +1,98 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <atomic>
+#include <unordered_set>
+#include <cstdint>
+
+
+// VEL_ZONE("name") times the enclosing scope. name must outlive the capture it ends up in, so use string
+// literals or Profiler::intern(). Compiles to nothing unless PROFILE_ZONES is defined
+#ifdef PROFILE_ZONES
+#define VEL_ZONE_CONCAT_INNER(a, b) a##b
+#define VEL_ZONE_CONCAT(a, b) VEL_ZONE_CONCAT_INNER(a, b)
+#define VEL_ZONE(name) ::vel::ProfileZone VEL_ZONE_CONCAT(velProfileZone, __LINE__)(name)
+#else
+#define VEL_ZONE(name)
+#endif
+
+
+namespace vel
+{
+	/*
+		Collects timed zones from every thread into per thread ring buffers, the owning thread is the only
+		writer so recording a zone never takes a lock. Once a buffer is full the oldest zones are overwritten,
+		so only the recent past is kept, which is all that's needed to see where a hitch came from.
+
+		App marks the start of every frame and writeChromeTrace() dumps the zones from the last N of them as
+		json which can be loaded into chrome://tracing (or ui.perfetto.dev).
+	*/
+	class Profiler
+	{
+	private:
+		struct Event
+		{
+			std::atomic<const char*>	name{ nullptr };
+			std::atomic<int64_t>		start{ 0 };	// ns since the profiler was created
+			std::atomic<int64_t>		end{ 0 };
+		};
+
+		struct ThreadBuffer
+		{
+			std::unique_ptr<Event[]>	events;
+			size_t						capacity;
+			std::atomic<uint64_t>		written{ 0 }; // total events ever recorded, slot is written % capacity
+			uint32_t					id;
+			std::string					name;	// guarded by registryMutex
+		};
+
+		static constexpr size_t			frameCapacity = 1024;
+
+										Profiler();
+		static Profiler&				get();
+		static thread_local ThreadBuffer* local;
+		static ThreadBuffer&			localBuffer();
+
+		std::mutex						registryMutex;
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers; // kept after their thread exits so it's zones can still be dumped
+		size_t							eventsPerThread = 16384;
+
+		std::shared_mutex				internMutex;
+		std::unordered_set<std::string>	internedNames;
+
+		std::unique_ptr<std::atomic<int64_t>[]> frameStarts;
+		std::atomic<uint64_t>			frameCount{ 0 };
+
+	public:
+										Profiler(Profiler const&) = delete;
+		void							operator=(Profiler const&) = delete;
+
+		static int64_t					now();
+		static void						record(const char* name, int64_t start, int64_t end);
+
+		// only affects threads which haven't recorded anything yet
+		static void						setEventsPerThread(size_t count);
+		static void						setThreadName(std::string name);
+		static const char*				intern(const std::string& name);
+
+		static void						markFrame();
+		static bool						writeChromeTrace(std::string path, size_t frames);
+	};
+
+	class ProfileZone
+	{
+	private:
+		const char*						name;
+		int64_t							start;
+
+	public:
+										ProfileZone(const char* name) : name(name), start(Profiler::now()) {}
+										~ProfileZone() { Profiler::record(this->name, this->start, Profiler::now()); }
+										ProfileZone(const ProfileZone&) = delete;
+		ProfileZone&					operator=(const ProfileZone&) = delete;
+	};
+}
@@ -0,0 +1,97 @@
+#pragma once
+
+#include <vector>
+#include <utility>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace vel
+{
+	struct Shader;
+	struct Cubemap;
+	struct Material;
+	class Mesh;
+
+	/*
+		Turns the draws of a stage pass into a list of commands which only change the gpu state that actually
+		differs from the previous draw. Opaque draws are radix sorted by a 64 bit key of
+
+			shader (14 bits) | ibl (8) | material (16) | mesh (14) | instanceable (1) | coarse depth (11)
+
+		so draws sharing state end up next to each other and, within the same state, go front to back. The state
+		fields are hashes of the pointers: only equality matters for grouping and the commands compare the actual
+		pointers, so a collision costs a bind, never a wrong draw. Transparent draws keep the order they were pushed
+		in and only have their redundant binds dropped.
+
+		Stages stay in order (a stage can clear the depth buffer or change the render mode, and it's transparents
+		have to follow it's opaques), so each pass is flushed on it's own and starts from unknown gpu state.
+
+		Draws pushed as INSTANCED (no per draw state besides their model matrix) which end up next to each other
+		with the same state become a single DRAW_INSTANCED, it's items listed in getInstanceItems(). INSTANCED_ALONE
+		draws read their model matrix the same way but have state of their own, so always get one to themselves.
+
+		Only pointers and indices are involved, nothing here touches the gpu. Scene::drawSnapshot() executes the
+		commands, anything else can inspect them.
+	*/
+	class RenderQueue
+	{
+	public:
+		enum Op : uint8_t { USE_SHADER, USE_IBL, USE_MATERIAL, USE_MESH, DRAW, DRAW_INSTANCED };
+		enum Instancing : uint8_t { NOT_INSTANCED, INSTANCED, INSTANCED_ALONE };
+
+		struct Command
+		{
+			Op						op;
+			uint32_t				item; // as pushed, the draw whose state is used
+			uint32_t				instanceBegin = 0; // DRAW_INSTANCED only, range of getInstanceItems()
+			uint32_t				instanceCount = 0;
+		};
+
+		// since the last begin(), binds are those issued, avoided the draws which didn't need one
+		struct Stats
+		{
+			size_t					draws = 0; // items drawn, instanced or not
+			size_t					iblDraws = 0; // draws with an ibl
+			size_t					instancedDraws = 0; // DRAW_INSTANCED commands
+			size_t					instances = 0; // items drawn by them
+			size_t					shaderBinds = 0;
+			size_t					iblBinds = 0;
+			size_t					materialBinds = 0;
+			size_t					meshBinds = 0;
+
+			size_t					bindsAvoided() const; // over binding everything for every draw
+		};
+
+	private:
+		struct Draw
+		{
+			const Shader*			shader;
+			const Cubemap*			ibl;
+			const Material*			material;
+			const Mesh*				mesh;
+			uint32_t				item;
+			Instancing				instancing;
+		};
+
+		std::vector<Draw>			draws; // pushed since the last flush
+		std::vector<uint64_t>		keys[2]; // keys[0] parallel to draws
+		std::vector<uint32_t>		order[2];
+		std::vector<Command>		commands;
+		std::vector<uint32_t>		instanceItems;
+		Stats						stats;
+
+		void						sortDraws(); // leaves the sorted positions in order[0]
+
+	public:
+		void						begin(); // new frame, clears commands and stats
+		void						push(const Shader* shader, const Cubemap* ibl, const Material* material, const Mesh* mesh, float depth, uint32_t item, Instancing instancing = NOT_INSTANCED);
+
+		// appends the commands for everything pushed since the last flush, returns their begin/end
+		std::pair<size_t, size_t>	flush(bool sort);
+
+		const std::vector<Command>&	getCommands() const;
+		const std::vector<uint32_t>&	getInstanceItems() const; // items of every DRAW_INSTANCED since the last begin()
+		const Stats&				getStats() const;
+	};
+}
@@ -0,0 +1,120 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <utility>
+#include <unordered_map>
+
+#include "glm/glm.hpp"
+#include "glm/gtc/quaternion.hpp"
+
+#include "vel/Transform.h"
+#include "vel/TransformBatch.h"
+#include "vel/RenderQueue.h"
+#include "vel/RenderMode.h"
+#include "vel/Shader.h"
+#include "vel/Mesh.h"
+#include "vel/Material.h"
+#include "vel/Cubemap.h"
+#include "vel/CollisionDebugDrawer.h"
+
+
+namespace vel
+{
+	/*
+		Everything Scene::drawSnapshot() needs to render a frame, copied out of the scene by
+		Scene::captureRenderSnapshot() so the fixed tick can go on changing the scene while the frame is drawn
+		(see Config::PIPELINED_SIMULATION). Actor and bone transforms keep both their previous and current
+		tick values in TransformBatches and are only interpolated by alpha when drawn. Assets are referenced
+		by pointer, they can't be freed while their scene is active. Vectors are cleared rather than released
+		between frames.
+	*/
+	struct RenderSnapshot
+	{
+		// world transform of an actor, parents are always captured before their children
+		struct Node
+		{
+			bool					interpolate; // dynamic with a previous transform, otherwise matrix is the world matrix
+			glm::mat4				matrix; // local matrix when interpolated but it didn't move over the last tick
+			int32_t					local = -1; // index into nodeTransforms, when interpolated and it moved
+			int32_t					parentNode = -1;
+			int32_t					parentBone = -1; // index into boneTransforms
+		};
+
+		// one entry of a skinned actor's bone palette, in the order of the mesh's bones
+		struct SkinBone
+		{
+			uint32_t				bone; // index into boneTransforms
+			glm::mat4				offsetMatrix;
+		};
+
+		// a visible actor of a renderable
+		struct Item
+		{
+			Shader*					shader;
+			Mesh*					mesh;
+			Material*				material;
+			uint32_t				node;
+			uint32_t				skinBegin; // range of skinBones, and of skinMatrices once resolved
+			uint32_t				skinEnd;
+		};
+
+		struct StagePass
+		{
+			const char*				name; // interned, names the stage's profiler zone
+			RenderMode				renderMode;
+			bool					clearDepthBuffer;
+			Cubemap*				ibl; // only set for RenderMode::PBR_IBL
+			glm::vec3				cameraPosition;
+			glm::mat4				projection;
+			glm::mat4				view;
+			glm::vec3				renderCameraPosition;
+			glm::mat4				renderCameraOffset;
+			size_t					opaqueBegin;
+			size_t					opaqueEnd;
+			size_t					transparentBegin; // transparents are in back to front order
+			size_t					transparentEnd;
+
+			// filled in while drawing, ranges of renderQueue's commands
+			std::pair<size_t, size_t>	opaqueCommands;
+			std::pair<size_t, size_t>	transparentCommands;
+		};
+
+		struct DebugWorld
+		{
+			CollisionDebugDrawer*	drawer;
+			glm::mat4				vp;
+		};
+
+		float						alpha = 0.0f;
+		Cubemap*					skybox = nullptr; // null when no skybox is drawn
+		glm::mat4					projection;
+		glm::mat4					view;
+		std::vector<DebugWorld>		debugWorlds;
+		std::vector<StagePass>		stages;
+		std::vector<Item>			items;
+		std::vector<Node>			nodes;
+		TransformBatch				nodeTransforms;
+		TransformBatch				boneTransforms; // the armature's current pose twice over when it doesn't interpolate
+		std::vector<SkinBone>		skinBones;
+
+		// captured so far, so an actor or bone shared by several items (a parent, a bone with actors attached to
+		// it) is only captured once. Keyed by Actor* and ArmatureBone*
+		std::unordered_map<const void*, uint32_t>	capturedNodes;
+		std::unordered_map<const void*, uint32_t>	capturedBones;
+
+		// filled in while drawing
+		std::vector<glm::mat4>		localMatrices;
+		std::vector<glm::mat4>		worldMatrices;
+		std::vector<glm::mat4>		boneMatrices;
+		std::vector<glm::mat4>		skinMatrices; // parallel to skinBones, bone matrix times offset matrix
+		RenderQueue					renderQueue;
+		std::vector<glm::mat4>		instanceMatrices; // model matrices of renderQueue's instance items
+
+		void						clear();
+		void						resolveMatrices(); // interpolates every bone and node by alpha, then builds the skin palettes
+
+		// the 10 floats of a TransformBatch entry
+		static void					packTransform(const glm::vec3& t, const glm::quat& r, const glm::vec3& s, float* out);
+	};
+}
@@ -4,6 +4,8 @@
 #include <vector>
 #include <string>
 #include <optional>
+#include <atomic>
+#include <future>
 
 #include "vel/sac.h"
 #include "vel/ptrsac.h"
@@ -16,8 +18,11 @@
 #include "vel/Material.h"
 #include "vel/Cubemap.h"
 #include "vel/AssetTrackers.h"
+#include "vel/LoadProgress.h"
+#include "vel/TickGraph.h"
 #include "vel/CollisionWorld.h"
 #include "vel/CollisionDebugDrawer.h"
+#include "vel/RenderSnapshot.h"
 
 
 namespace vel
@@ -44,17 +49,26 @@ namespace vel
 		std::vector<std::string>			armaturesInUse;
 		
 		void								freeAssets();
-		void								drawActor(Actor* a, float alphaTime);
-		std::vector<std::pair<float, Actor*>> sortedTransparentActors;
+		RenderSnapshot						renderSnapshot; // used by draw()
+		uint32_t							captureNode(RenderSnapshot& snap, Actor* a);
+		uint32_t							captureBone(RenderSnapshot& snap, ArmatureBone& b, bool interpolate);
+		void								captureItem(RenderSnapshot& snap, Renderable* r, Actor* a);
+		void								drawItem(const RenderSnapshot& snap, const RenderSnapshot::Item& item);
+		void								runRenderCommands(const RenderSnapshot& snap, const RenderSnapshot::StagePass& pass, std::pair<size_t, size_t> commands);
+		static RenderQueue::Instancing		instancing(const RenderSnapshot::Item& item);
+		RenderQueue::Stats					renderStats; // of the last drawSnapshot()
 
-		glm::vec3							cameraPosition;
-		glm::mat4							cameraProjectionMatrix;
-		glm::mat4							cameraViewMatrix;
+		std::string							name = "";
 
-		glm::vec3							renderCameraPosition;
-		glm::mat4							renderCameraOffset;
+		TickGraph							tickGraph;
+		bool								tickGraphDirty = true; // stages or collision worlds were added since the graph was built
+		bool								parallelPhysics = false;
+		float								tickDelta = 0.0f;
+		void								buildTickGraph();
 
-		std::string							name = "";
+		std::shared_ptr<LoadProgress>		loadProgress;
+		std::promise<void>					loadPromise;
+		std::shared_future<void>			loadFuture;
 
 	protected:
 		
@@ -70,11 +84,11 @@ namespace vel
 		void								addRenderable(std::string name, Shader* shader, Mesh* mesh, Material* material);
 		Stage*								addStage(std::string name);
 
-		Shader*								getShader(std::string name);
-        Cubemap*							getInfiniteCubemap(std::string name);
-		Mesh*								getMesh(std::string name);
-		Texture*							getTexture(std::string name);
-		Material*							getMaterial(std::string name);
+		Shader*								getShader(Name name);
+        Cubemap*							getInfiniteCubemap(Name name);
+		Mesh*								getMesh(Name name);
+		Texture*							getTexture(Name name);
+		Material*							getMaterial(Name name);
 		Renderable							getRenderable(std::string name);
 		Armature							getArmature(std::string name);
 		
@@ -90,13 +104,17 @@ namespace vel
 		virtual void						postPhysics(float deltaTime);
 
 		// TODO: why are these public?
-		bool								mainMemoryloaded;
+		std::atomic<bool>					mainMemoryloaded;
 		bool								swapWhenLoaded;
 		//////////////
 		
 		void								setName(std::string n);
 		std::string							getName();
 		bool								isFullyLoaded();
+		void								setMainMemoryLoaded(); // called by the loader thread once load() returns
+		const LoadProgress&					getLoadProgress() const;
+		void								setBlocking(); // it's gpu uploads go ahead of those of scenes loaded in the background
+		std::shared_future<void>			getLoadFuture() const; // ready once load() has returned, gpu uploads may still be pending
 		
 		// TODO: some of these should probably be protected
 
@@ -111,10 +129,16 @@ namespace vel
 		void								setDrawSkybox(bool b);
 		bool								getDrawSkybox();
 
+		void								fixedTick(double delta);
 		void								updateFixedAnimations(double runTime);
 		void								updateAnimations(double frameTime);
-		void								draw(float alpha);
+		void								draw(float alpha); // captureRenderSnapshot() then drawSnapshot()
+		void								captureRenderSnapshot(RenderSnapshot& snap, float alpha);
+		void								drawSnapshot(RenderSnapshot& snap);
+		const RenderQueue::Stats&			getRenderStats() const; // draws and binds issued/avoided by the last drawSnapshot()
 		void								stepPhysics(float delta);
+		void								setParallelPhysics(bool b); // step active collision worlds concurrently
+		bool								getParallelPhysics() const;
 		void								applyTransformations();
 		void								processSensors();
 
@@ -2,21 +2,43 @@
 
 #include <string>
 #include <vector>
+#include <cstdint>
 #include <unordered_map>
 
 #include "glm/glm.hpp"
 
+#include "vel/Name.h"
+
 
 typedef int GLint;
 
 namespace vel
 {
+	// locations of the uniforms set while drawing a stage, resolved when the shader is linked, -1 when the
+	// shader doesn't use them
+	struct ShaderUniforms
+	{
+		GLint					model = -1;
+		GLint					projection = -1;
+		GLint					view = -1;
+		GLint					camPos = -1;
+		GLint					camOffset = -1;
+		GLint					bones = -1; // first element of the loose bone palette array
+		GLint					boneOffset = -1;
+		GLint					instanceOffset = -1;
+	};
+
 	struct Shader
 	{
 		unsigned int id;
 		std::string name;
 		std::string vertFile;
 		std::string fragFile;
-		std::unordered_map<std::string, GLint> uniformLocations;
+		std::unordered_map<Name, GLint> uniformLocations; // every active uniform once linked, misses are added when looked up
+		ShaderUniforms uniforms;
+		bool cameraBlock = false; // declares the Camera uniform block (see GPU::setCamera())
+		uint32_t cameraVersion = 0; // GPU camera the loose camera uniforms were last set from
+		bool boneBlock = false; // declares the Bones storage block (see GPU::setBonePalette())
+		bool instanceBlock = false; // declares the Instances storage block, so can be drawn instanced (see GPU::setInstanceMatrices())
 	};
-}
\ No newline at end of file
+}
@@ -0,0 +1,83 @@
+#pragma once
+
+#include <vector>
+#include <array>
+#include <unordered_map>
+#include <limits>
+#include <cstdint>
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+
+namespace vel
+{
+	class Actor;
+
+	/*
+		Loose uniform grid over the world bounds of a stage's actors. Each actor lives in the cell containing the
+		center of it's bounds, so as long as it's no larger than a cell it never reaches further than half a cell
+		outside of it and queries only have to look that much further. Actors larger than a cell are kept in a
+		separate list which every query tests. Only occupied cells are stored (hashed by their coordinates), when a
+		query would cover more cells than are occupied it walks the occupied ones instead.
+
+		Entries are only touched when an actor's bounds are updated, Stage::updateWorldMatrices() does this for the
+		actors whose world matrix was rebuilt. Queries clear and fill a vector supplied by the caller so it's capacity
+		is reused across calls, and only read the index so any number of them can run concurrently.
+	*/
+	class SpatialIndex
+	{
+	private:
+		struct Entry
+		{
+			Actor*						actor;
+			glm::vec3					min;
+			glm::vec3					max;
+			uint64_t					cell;
+			bool						oversized;
+			uint32_t					slot; // position within it's cell, or within oversized
+		};
+
+		static constexpr uint64_t		NO_CELL = std::numeric_limits<uint64_t>::max();
+
+		float							cellSize;
+		std::vector<Entry>				entries;
+		std::vector<uint32_t>			freeEntries;
+		std::unordered_map<Actor*, uint32_t> entryOf;
+		std::unordered_map<uint64_t, std::vector<uint32_t>> cells;
+		std::vector<uint32_t>			oversized;
+
+		int32_t							cellCoordinate(float v) const;
+		uint64_t						cellKey(int32_t x, int32_t y, int32_t z) const;
+		glm::ivec3						cellFromKey(uint64_t key) const;
+		void							unlink(Entry& e);
+		void							link(uint32_t id);
+
+		// calls fn(entry) for every entry whose cell could hold something overlapping min/max, plus every
+		// oversized entry. The caller still has to test each entry's bounds
+		template<typename Fn>
+		void							forEachCandidate(const glm::vec3& min, const glm::vec3& max, Fn&& fn) const;
+
+	public:
+		static constexpr float			DEFAULT_CELL_SIZE = 16.0f;
+
+										SpatialIndex(float cellSize = DEFAULT_CELL_SIZE);
+
+		void							setCellSize(float cellSize); // relinks every entry
+		float							getCellSize() const;
+
+		void							update(Actor* a, const glm::vec3& min, const glm::vec3& max); // inserts when not yet indexed
+		void							remove(Actor* a);
+		bool							contains(Actor* a) const;
+		size_t							size() const;
+		void							clear();
+
+		// actors whose bounds touch the sphere, box or frustum
+		void							querySphere(const glm::vec3& center, float radius, std::vector<Actor*>& out) const;
+		void							queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<Actor*>& out) const;
+		void							queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<Actor*>& out) const; // see frustumPlanes()
+
+		// up to k actors closest to point (by distance to their bounds) no further than maxDistance, nearest first
+		void							queryNearest(const glm::vec3& point, size_t k, std::vector<Actor*>& out, float maxDistance = std::numeric_limits<float>::max()) const;
+	};
+}
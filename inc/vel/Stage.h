@@ -15,11 +15,15 @@
 #include "vel/GPU.h"
 #include "vel/RenderMode.h"
 #include "vel/Cubemap.h"
+#include "vel/SpatialIndex.h"
+#include "vel/BoundsBatch.h"
+#include "vel/TransparentDrawList.h"
 
 
 namespace vel
 {
 	class Scene;
+	class CollisionWorld;
 	
 
 
@@ -31,16 +35,40 @@ namespace vel
 		sac<Actor>										actors;
 		sac<Armature>									armatures;
 		sac<Renderable>									renderables;
+		SpatialIndex									actorIndex; // world bounds of every actor, kept up to date by updateWorldMatrices()
 		bool											clearDepthBuffer;
 		std::string										name;
 		RenderMode										renderMode;
 		Cubemap*										activeInfiniteCubemap;
 		bool											useSceneCameraPositionForLighting;
 
+		// actors the fixed tick has to visit, rebuilt when Actor::getSimulationVersion() changes. Actors moved by an
+		// ActorMotionState are in none of them, their collision world updates them only when bullet moves them
+		uint32_t										tickedActorsVersion;
+		std::vector<Actor*>								previousTransformActors; // dynamic, need their previous transform kept
+		std::vector<Actor*>								polledRigidBodyActors; // autoTransform rigidbodies without an ActorMotionState
+		std::vector<Actor*>								posedActors; // parented to an armature bone, their world matrix changes every tick
+		std::vector<Actor*>								animatedActors; // skinned, their bounds follow the pose every tick
+
+		uint32_t										worldActorsVersion; // simulation version of the last full updateWorldMatrices() walk
+		std::vector<Actor*>								dirtyActors; // handed out their transform since the last updateWorldMatrices()
+
+		// written by cull(), visible actors grouped by renderable in getRenderables() order
+		bool											frustumCulling;
+		std::vector<Actor*>								visibleActors;
+		std::vector<size_t>								visibleRenderableEnds; // per renderable, end of it's actors in visibleActors
+		std::vector<Actor*>								cullCandidates; // scratch, parallel to cullBounds
+		BoundsBatch										cullBounds;
+		std::vector<uint8_t>							cullResults;
+		size_t											culledCount;
+		TransparentDrawList								transparents; // visible actors of transparent renderables, refilled by cull()
 		
 
 
 		void											_removeActor(Actor* a);
+		void											updateWorldMatrices(Actor* a, bool wholeHierarchy);
+		void											updatePoseBounds();
+		void											refreshTickedActors();
 
 
 	public:
@@ -51,7 +79,7 @@ namespace vel
 		Actor*											addActor(Actor a);
 		void											removeActor(std::string name);
 		void											removeActor(Actor* a);
-		Actor*											getActor(std::string name);
+		Actor*											getActor(Name name);
 		std::vector<Actor*>&							getActors();
 		std::vector<Renderable*>& 						getRenderables();
 		void											setCamera(Camera* c);
@@ -62,6 +90,31 @@ namespace vel
 		void											setClearDepthBuffer(bool b);
 		bool											getClearDepthBuffer();
 		void											applyTransformations();
+		void											updatePreviousTransforms();
+		void											syncRigidBodyTransforms();
+		// rebuild the stale cached world matrices of the actors that may have moved since the last call, and their
+		// children. Those moved by bullet are taken from the worlds' moved lists
+		void											updateWorldMatrices(const std::vector<CollisionWorld*>& collisionWorlds);
+		void											markMoved(Actor* a); // called by Actor::getTransform(), queued once until the next update
+
+		// actors whose world bounds touch the region as of the last updateWorldMatrices(), out is cleared first
+		// and can be reused between calls to avoid allocating
+		void											queryActors(const glm::vec3& center, float radius, std::vector<Actor*>& out) const;
+		void											queryActors(const glm::vec3& min, const glm::vec3& max, std::vector<Actor*>& out) const;
+		void											queryActors(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<Actor*>& out) const;
+		void											queryNearestActors(const glm::vec3& point, size_t k, std::vector<Actor*>& out, float maxDistance = std::numeric_limits<float>::max()) const;
+		const SpatialIndex&								getSpatialIndex() const;
+		void											setSpatialIndexCellSize(float cellSize);
+
+		// fills the visible list with the visible actors of every renderable whose world bounds touch the frustum,
+		// or all of them when frustum culling is disabled (for stages drawn in screen space for example)
+		void											cull(const std::array<glm::vec4, 6>& frustumPlanes);
+		std::pair<Actor* const*, Actor* const*>			getVisibleActors(size_t renderableIndex) const; // begin/end, as of the last cull()
+		size_t											getVisibleCount() const;
+		size_t											getCulledCount() const;
+		void											setFrustumCulling(bool b);
+		bool											getFrustumCulling() const;
+		const std::vector<TransparentDrawList::Entry>&	sortTransparents(const glm::vec3& eye); // the last cull()'s transparent actors, furthest first
 
 		Armature*										addArmature(Armature a, std::string defaultAnimation, std::vector<std::string> actors);	
 		const std::string&								getName() const;
@@ -10,7 +10,7 @@ namespace vel
 	struct Texture
 	{
 		std::string					name;
-		unsigned int				id;
+		unsigned int				id = 0;
 		std::string					type;
 		bool						alphaChannel;
 		ImageData					primaryImageData;
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <string>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <functional>
+
+#include "vel/JobSystem.h"
+
+
+namespace vel
+{
+	/*
+		A fixed tick expressed as tasks with declared read and write sets. Resources are identified by
+		address (a Stage*, a CollisionWorld*...). Dependencies are derived from the order tasks are added
+		in: a task runs after every earlier task which writes something it reads or writes, or reads
+		something it writes. Tasks with no such conflict run concurrently on the JobSystem.
+
+		Tasks added with addMainThreadTask() are treated as touching everything (they run user code), they
+		run on the thread calling run() once every earlier task has finished and before any later one starts.
+
+		With validation enabled, engine code reports what it actually touches through TickGraph::access()
+		and any access outside of the running task's declared sets crashes naming the task.
+	*/
+	class TickGraph
+	{
+	private:
+		struct Task
+		{
+			std::string					name;
+			const char*					zoneName = nullptr; // name interned for the profiler
+			std::function<void()>		fn;
+			std::vector<const void*>	reads;
+			std::vector<const void*>	writes;
+			std::vector<size_t>			dependents;
+			size_t						dependencyCount = 0;
+		};
+
+		// a run of concurrent tasks, or a single main thread task
+		struct Segment
+		{
+			size_t						begin;
+			size_t						end;
+			bool						mainThread;
+		};
+
+		std::vector<Task>				tasks;
+		std::vector<Segment>			segments;
+		std::unique_ptr<std::atomic<size_t>[]> remaining; // per task dependencies left this run
+		size_t							remainingSize = 0;
+
+		static std::atomic<bool>		validation;
+
+		static bool						conflicts(const Task& a, const Task& b);
+		void							execute(size_t index);
+		void							submit(size_t index, JobSystem& js, JobCounter& done);
+
+	public:
+		void							clear();
+		bool							empty() const;
+
+		void							addTask(std::string name, std::function<void()> fn, std::vector<const void*> reads, std::vector<const void*> writes);
+		void							addMainThreadTask(std::string name, std::function<void()> fn);
+
+		void							run(JobSystem& js);
+
+		static void						setValidation(bool b);
+		static bool						validating() { return TickGraph::validation.load(std::memory_order_relaxed); }
+		static void						access(const void* resource, bool write);
+	};
+}
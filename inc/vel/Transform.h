@@ -4,6 +4,8 @@
 #include "glm/gtc/quaternion.hpp"
 #include "glm/gtx/quaternion.hpp"
 
+#include <cstdint>
+
 
 namespace vel
 {
@@ -14,9 +16,17 @@ namespace vel
 		glm::quat			rotation;
 		glm::vec3			scale;
 
+		mutable glm::mat4	matrix; // cached result of getMatrix()
+		mutable bool		matrixDirty;
+		uint32_t			version; // bumped by every change, so whatever is built from this transform can tell it's stale
+
 	public:
 							Transform();
 							Transform(glm::vec3 t, glm::quat r, glm::vec3 s);
+							Transform(const Transform& other) = default;
+		Transform&			operator=(const Transform& other);
+		bool				operator==(const Transform& other) const; // same translation, rotation and scale
+		bool				operator!=(const Transform& other) const;
 		void				setTranslation(glm::vec3 translation);
 		void				setRotation(float angle, glm::vec3 axis);
 		void				setRotation(glm::quat rotation);
@@ -24,7 +34,8 @@ namespace vel
 		const glm::vec3&	getTranslation() const;
 		const glm::quat&	getRotation() const;
 		const glm::vec3&	getScale() const;
-		const glm::mat4		getMatrix() const;
+		const glm::mat4&	getMatrix() const;
+		uint32_t			getVersion() const;
 		void				print();
 
 		glm::vec3			getRotationEulers();
@@ -0,0 +1,36 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+
+namespace vel
+{
+	/*
+		Previous and current translation/rotation/scale of many transforms stored as structure of arrays, one
+		array per component, so interpolate() can turn them into matrices four at a time with SSE (falling back
+		to plain loops where it isn't available). Rotations are blended with nlerp along the shortest arc, which
+		for the small per tick changes being interpolated is indistinguishable from slerp.
+	*/
+	class TransformBatch
+	{
+	public:
+		// order of the 10 floats describing a transform when pushed
+		enum Component { TX, TY, TZ, RX, RY, RZ, RW, SX, SY, SZ, COUNT };
+
+	private:
+		std::vector<float>			previous[COUNT];
+		std::vector<float>			current[COUNT];
+
+	public:
+		size_t						size() const;
+		void						clear();
+		void						reserve(size_t n);
+		uint32_t					push(const float* previousTRS, const float* currentTRS); // returns the index
+
+		// writes one column major 4x4 matrix (16 floats, the layout of glm::mat4) per transform to out,
+		// translate * rotate * scale of the transform interpolated by alpha
+		void						interpolate(float alpha, float* out) const;
+	};
+}
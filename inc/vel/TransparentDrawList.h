@@ -0,0 +1,65 @@
+#pragma once
+
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+#include "glm/glm.hpp"
+
+
+namespace vel
+{
+	class Actor;
+	class Renderable;
+
+	/*
+		A stage's visible transparent actors in back to front order, kept from frame to frame. Each frame the actors
+		which are still visible keep last frame's order and new ones are appended, so after the distance keys are
+		refreshed the list is usually sorted already or nearly so and an insertion sort finishes in close to one pass.
+		When too much has changed (the camera turned around, lots of new actors) the insertion sort gives up and a
+		radix sort on the float keys takes over. All storage is kept between frames, so once the largest frame has
+		been seen nothing is allocated.
+	*/
+	class TransparentDrawList
+	{
+	public:
+		struct Entry
+		{
+			Actor*					actor;
+			Renderable*				renderable;
+			uint32_t				slot; // the actor's slot within it's stage
+		};
+
+	private:
+		struct Incoming
+		{
+			Actor*					actor;
+			Renderable*				renderable;
+			uint32_t				slot;
+			bool					placed;
+		};
+
+		uint32_t					frame = 0;
+		std::vector<Incoming>		incoming; // added this frame, in no particular order
+		std::vector<uint32_t>		slotFrame; // per actor stage slot, frame it was last added in
+		std::vector<uint32_t>		slotIncoming; // per actor stage slot, it's index in incoming when added this frame
+
+		std::vector<Entry>			entries; // back to front after sort()
+		std::vector<Entry>			nextEntries;
+		std::vector<float>			keys; // squared distance from the eye, parallel to entries
+
+		// scratch
+		std::vector<float>			positions[3];
+		std::vector<uint32_t>		radixKeys[2];
+		std::vector<uint32_t>		radixOrder[2];
+
+		bool						insertionSort(size_t maxMoves); // false if it gave up, entries are still a permutation
+		void						radixSort();
+
+	public:
+		void						begin(); // starts a new frame
+		void						add(Actor* a, Renderable* r); // each visible transparent actor once per frame
+		void						sort(const glm::vec3& eye);
+		const std::vector<Entry>&	getEntries() const;
+	};
+}
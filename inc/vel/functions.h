@@ -2,6 +2,7 @@
 
 #include <vector>
 #include <string>
+#include <array>
 
 
 #include "glm/glm.hpp"
@@ -32,4 +33,5 @@ namespace vel
 	btTransform glmMat4ToBulletTransform(const glm::mat4& m);
 	bool isPowerOfTwo(int n);
 	float lerpf(float a, float b, float f);
+	std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& viewProjection); // left, right, bottom, top, near, far
 }
\ No newline at end of file
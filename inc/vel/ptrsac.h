@@ -5,25 +5,41 @@
 #include <iostream>
 #include <unordered_map>
 #include <vector>
+#include <string>
+#include <algorithm>
+
+#include "vel/sac_handle.h"
+#include "vel/Name.h"
 
 
 
 
 /*
 	Class meant to be used to store pointers in a contiguous block of memory and be
-	accessible via given name or pointer. Pointers of slot values are not kept valid
+	accessible via given name, pointer or sac_handle. Pointers of slot values are not kept valid
 	as memory will simply be swapped and popped. If this is a requirement use sac.h
+
+	Handles index into a sparse array which maps to the current position of the value
+	within slots, so they survive the swap and pop of other values. Names are an optional
+	side index, values inserted without a name are never hashed by string.
 */
 template<typename T>
 class ptrsac
 {
 private:
-	size_t													originalBlockSize;
-	size_t													blockSize;
 	std::vector<T>											slots;
+	std::vector<uint32_t>									slotHandleIndexes; // parallel to slots, handle index of each value
+
+	std::vector<uint32_t>									handleSlotIndexes; // handle index -> index within slots
+	std::vector<uint32_t>									handleGenerations; // handle index -> generation
+	std::vector<vel::Name>									handleNames; // handle index -> name
+	std::vector<bool>										handleNamed; // handle index -> whether or not this handle is in the name side index
+	std::vector<uint32_t>									freeHandles;
 
-	std::unordered_map<std::string, size_t>					trackerMap;
-	std::unordered_map<T, std::string>						ptrackerMap;
+	std::unordered_map<vel::Name, uint32_t>					trackerMap;
+
+	uint32_t												acquireHandle(T dataObject);
+	void													eraseHandle(uint32_t handleIndex);
 
 
 public:
@@ -31,13 +47,21 @@ public:
 	ptrsac();
 	//~sac();
 	//sac(const sac<T>& old);
-	void								insert(std::string name, T dataObject);
-	void								erase(std::string name);
-	void								erase(T slotPtr);
-	T									get(std::string name);
+	sac_handle							insert(vel::Name name, T dataObject);
+	sac_handle							insert(T dataObject);
+	void								erase(vel::Name name);
+	void								erase(T slotPtr); // searches slots, prefer the handle returned by insert()
+	void								erase(sac_handle handle);
+	T									get(vel::Name name);
+	T									get(sac_handle handle);
 	std::vector<T>&						getAll();
 	size_t								size() const;
-	bool								exists(std::string name) const;
+	bool								exists(vel::Name name) const;
+	bool								exists(sac_handle handle) const;
+
+	void								reserve(size_t count);
+	void								shrink_to_fit();
+	size_t								memoryFootprint() const;
 
 };
 
@@ -52,25 +76,19 @@ public:
 //	ptrackerMap(old.ptrackerMap),
 //	activeSlotTrackerMap(old.activeSlotTrackerMap)
 //{
-//	
+//
 //}
 
+// nothing is reserved up front, slots grow geometrically as values are inserted (use reserve() if the
+// final size is known). Pointers to slots are never handed out so reallocation is harmless
 template <typename T>
 ptrsac<T>::ptrsac()
-{
-	size_t blockSize = 1000;
-
-	this->originalBlockSize = blockSize;
-	this->blockSize = blockSize;
-	this->slots.reserve(blockSize);
-}
+{}
 
 template <typename T>
 ptrsac<T>::ptrsac(size_t blockSize)
 {
-	this->originalBlockSize = blockSize;
-	this->blockSize = blockSize;
-	this->slots.reserve(blockSize);
+	this->reserve(blockSize);
 }
 
 //template <typename T>
@@ -84,101 +102,164 @@ ptrsac<T>::ptrsac(size_t blockSize)
 //}
 
 template <typename T>
-void ptrsac<T>::insert(std::string name, T dataObject)
+uint32_t ptrsac<T>::acquireHandle(T dataObject)
+{
+	uint32_t handleIndex;
+	if (this->freeHandles.size() > 0)
+	{
+		handleIndex = this->freeHandles.back();
+		this->freeHandles.pop_back();
+	}
+	else
+	{
+		handleIndex = (uint32_t)this->handleSlotIndexes.size();
+		this->handleSlotIndexes.push_back(0);
+		this->handleGenerations.push_back(0);
+		this->handleNames.push_back(vel::Name());
+		this->handleNamed.push_back(false);
+	}
+
+	this->slots.push_back(dataObject);
+	this->slotHandleIndexes.push_back(handleIndex);
+	this->handleSlotIndexes[handleIndex] = (uint32_t)(this->slots.size() - 1);
+
+	return handleIndex;
+}
+
+template <typename T>
+sac_handle ptrsac<T>::insert(vel::Name name, T dataObject)
 {
 	// if this key already exists within the sac, display message and die
 	if (this->trackerMap.count(name) == 1)
 	{
-		//std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " 
+		//std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: "
 		//	<< name << " bypassing insert" << std::endl;
-		std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " << name << std::endl;
+		std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " << name.str() << std::endl;
 		std::cin.get();
 		exit(EXIT_FAILURE);
 		//return this->trackerMap[name];
 	}
 
+	auto handleIndex = this->acquireHandle(dataObject);
 
-	if (this->slots.size() == this->blockSize)
-	{
-		this->blockSize += this->originalBlockSize;
-		this->slots.reserve(this->blockSize);
-	}
+	this->trackerMap.emplace(name, handleIndex);
+	this->handleNames[handleIndex] = name;
+	this->handleNamed[handleIndex] = true;
 
-	this->slots.push_back(dataObject);
+	sac_handle h;
+	h.index = handleIndex;
+	h.generation = this->handleGenerations[handleIndex];
+
+	return h;
+}
+
+template <typename T>
+sac_handle ptrsac<T>::insert(T dataObject)
+{
+	sac_handle h;
+	h.index = this->acquireHandle(dataObject);
+	h.generation = this->handleGenerations[h.index];
 
-	this->trackerMap[name] = this->slots.size() - 1;
-	this->ptrackerMap[dataObject] = name;
+	return h;
 }
 
 template <typename T>
-void ptrsac<T>::erase(std::string name)
+void ptrsac<T>::eraseHandle(uint32_t handleIndex)
 {
-	if (!this->trackerMap.count(name) == 1)
+	uint32_t indexOfPointerToRemove = this->handleSlotIndexes[handleIndex];
+
+	// if indexOfPointerToRemove is not the last element swap it with the last element, and update
+	// the slot index of the value we swapped
+	if (indexOfPointerToRemove != this->slots.size() - 1)
 	{
-		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << name << std::endl;
-		std::cin.get();
-		exit(EXIT_FAILURE);
+		std::iter_swap(this->slots.begin() + indexOfPointerToRemove, this->slots.end() - 1);
+		std::iter_swap(this->slotHandleIndexes.begin() + indexOfPointerToRemove, this->slotHandleIndexes.end() - 1);
+
+		this->handleSlotIndexes[this->slotHandleIndexes[indexOfPointerToRemove]] = indexOfPointerToRemove;
 	}
 
-	T pointerToRemove = this->slots.at(this->trackerMap[name]);
+	// remove pointerToRemove from slots (it is now the last element in the vector)
+	this->slots.pop_back();
+	this->slotHandleIndexes.pop_back();
 
-	// remove from activeSlots
-	if (this->slots.size() > 1)
+	// remove from name side index if this handle was named
+	if (this->handleNamed[handleIndex])
 	{
-		// get index of pointerToRemove
-		size_t indexOfPointerToRemove = this->trackerMap[name];
-
-		// if indexOfPointerToRemove is the last element
-		if (indexOfPointerToRemove == this->slots.size() - 1)
-		{
-			this->slots.pop_back();
-		}
-		else
-		{
-			// swap the pointer to remove with the last element in activeSlots
-			std::iter_swap(this->slots.begin() + indexOfPointerToRemove, this->slots.end() - 1);
-
-			// remove pointerToRemove from activeSlots (it is now the last element in the vector)
-			this->slots.pop_back();
-
-			// update the index of the element we swapped within activeSlotTrackerMap
-			this->trackerMap[this->ptrackerMap[this->slots.at(indexOfPointerToRemove)]] = indexOfPointerToRemove;
-		}
+		this->trackerMap.erase(this->handleNames[handleIndex]);
+		this->handleNames[handleIndex] = vel::Name();
+		this->handleNamed[handleIndex] = false;
 	}
-	else
+
+	// invalidate all outstanding handles and recycle
+	this->handleGenerations[handleIndex]++;
+	this->freeHandles.push_back(handleIndex);
+}
+
+template <typename T>
+void ptrsac<T>::erase(vel::Name name)
+{
+	auto it = this->trackerMap.find(name);
+	if (it == this->trackerMap.end())
 	{
-		this->slots.clear();
+		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << name.str() << std::endl;
+		std::cin.get();
+		exit(EXIT_FAILURE);
 	}
 
-	// remove from trackers
-	this->ptrackerMap.erase(pointerToRemove);
-	this->trackerMap.erase(name);
+	this->eraseHandle(it->second);
 }
 
 template <typename T>
 void ptrsac<T>::erase(T slotPtr)
 {
-	if (!this->ptrackerMap.count(slotPtr) == 1)
+	// slots are densely packed values, so a scan is cheap and saves hashing every value on insert
+	auto it = std::find(this->slots.begin(), this->slots.end(), slotPtr);
+	if (it == this->slots.end())
 	{
 		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << slotPtr << std::endl;
 		std::cin.get();
 		exit(EXIT_FAILURE);
 	}
 
-	this->erase(this->ptrackerMap[slotPtr]);
+	this->eraseHandle(this->slotHandleIndexes[it - this->slots.begin()]);
+}
+
+template <typename T>
+void ptrsac<T>::erase(sac_handle handle)
+{
+	if (!this->exists(handle))
+	{
+		std::cout << "sac::erase(): attempting to erase element from sac using stale handle: " << handle.index << ":" << handle.generation << std::endl;
+		std::cin.get();
+		exit(EXIT_FAILURE);
+	}
+
+	this->eraseHandle(handle.index);
 }
 
+// only finds, never inserts, so it's safe for concurrent readers
 template <typename T>
-T ptrsac<T>::get(std::string name)
+T ptrsac<T>::get(vel::Name name)
 {
-	if (!this->trackerMap.count(name) == 1)
+	auto it = this->trackerMap.find(name);
+	if (it == this->trackerMap.end())
 	{
-		std::cout << "sac::get(): attempting to get element from sac which does not exist: " << name << std::endl;
+		std::cout << "sac::get(): attempting to get element from sac which does not exist: " << name.str() << std::endl;
 		std::cin.get();
 		exit(EXIT_FAILURE);
 	}
 
-	return this->slots.at(this->trackerMap[name]);
+	return this->slots[this->handleSlotIndexes[it->second]];
+}
+
+// returns a value initialized T (nullptr for pointers) if the handle is stale
+template <typename T>
+T ptrsac<T>::get(sac_handle handle)
+{
+	if (!this->exists(handle))
+		return T();
+
+	return this->slots[this->handleSlotIndexes[handle.index]];
 }
 
 template <typename T>
@@ -194,7 +275,54 @@ size_t ptrsac<T>::size() const
 }
 
 template <typename T>
-bool ptrsac<T>::exists(std::string name) const
+bool ptrsac<T>::exists(vel::Name name) const
 {
 	return this->trackerMap.count(name) == 1;
-}
\ No newline at end of file
+}
+
+template <typename T>
+bool ptrsac<T>::exists(sac_handle handle) const
+{
+	if (handle.index >= this->handleGenerations.size() || this->handleGenerations[handle.index] != handle.generation)
+		return false;
+
+	// generation matches, but the handle could still be sitting in the free list if it was never re-used
+	auto slotIndex = this->handleSlotIndexes[handle.index];
+	return slotIndex < this->slotHandleIndexes.size() && this->slotHandleIndexes[slotIndex] == handle.index;
+}
+
+template <typename T>
+void ptrsac<T>::reserve(size_t count)
+{
+	this->slots.reserve(count);
+	this->slotHandleIndexes.reserve(count);
+}
+
+// handle slots are kept, handles index into them directly and their generations must survive
+template <typename T>
+void ptrsac<T>::shrink_to_fit()
+{
+	this->slots.shrink_to_fit();
+	this->slotHandleIndexes.shrink_to_fit();
+	this->freeHandles.shrink_to_fit();
+	this->trackerMap.rehash(0);
+}
+
+// approximate number of bytes held by this ptrsac
+template <typename T>
+size_t ptrsac<T>::memoryFootprint() const
+{
+	size_t bytes = sizeof(ptrsac<T>);
+
+	bytes += this->slots.capacity() * sizeof(T);
+	bytes += this->slotHandleIndexes.capacity() * sizeof(uint32_t);
+	bytes += this->handleSlotIndexes.capacity() * sizeof(uint32_t);
+	bytes += this->handleGenerations.capacity() * sizeof(uint32_t);
+	bytes += this->handleNames.capacity() * sizeof(vel::Name);
+	bytes += this->handleNamed.capacity() / 8;
+	bytes += this->freeHandles.capacity() * sizeof(uint32_t);
+	bytes += this->trackerMap.bucket_count() * sizeof(void*);
+	bytes += this->trackerMap.size() * (sizeof(std::pair<const vel::Name, uint32_t>) + sizeof(void*));
+
+	return bytes;
+}
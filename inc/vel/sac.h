@@ -7,20 +7,41 @@
 #include <unordered_map>
 #include <vector>
 #include <memory>
+#include <string>
+#include <algorithm>
+#include <utility>
 
+#include "vel/sac_handle.h"
+#include "vel/Name.h"
 
+
+/*
+	Slot index bookkeeping. Every element in a sac lives in a slot which is addressed by a
+	32 bit index, slots are never moved once created (pointers stay valid) and are recycled
+	through freeSlots. Generations are bumped on erase so stale sac_handles can be detected.
+	Names are an optional side index keyed by vel::Name, elements inserted without a name are never hashed.
+
+	Blocks are allocated lazily on first insert. The first block holds blockSize elements and every
+	following block doubles in size up to maxBlockSize, so small sacs (a HUD stage with a handful
+	of actors) only pay for what they use.
+*/
 template<typename T>
 struct sac_data
 {
-	size_t													blockSize;
-	size_t													blockIndex;
+	size_t													blockSize; // size of the first block
+	size_t													maxBlockSize;
 	std::vector<std::vector<T>>								slots;
 	std::vector<T*>											activeSlots;
-	std::vector<T*>											freeSlots;
+	std::vector<uint32_t>									activeSlotIndexes; // parallel to activeSlots, slot index of each active element
+	std::vector<uint32_t>									freeSlots;
+
+	std::vector<T*>											slotPointers; // slot index -> element
+	std::vector<uint32_t>									slotGenerations; // slot index -> generation
+	std::vector<size_t>										slotActiveIndexes; // slot index -> position within activeSlots, npos when free
+	std::vector<vel::Name>									slotNames; // slot index -> name
+	std::vector<bool>										slotNamed; // slot index -> whether or not this slot is in the name side index
 
-	std::unordered_map<std::string, T*>						trackerMap;
-	std::unordered_map<T*, std::string>						ptrackerMap;
-	std::unordered_map<T*, size_t>							activeSlotTrackerMap;
+	std::unordered_map<vel::Name, uint32_t>					trackerMap;
 };
 
 
@@ -30,19 +51,44 @@ class sac
 private:
 	std::shared_ptr<sac_data<T>>		data;
 
+	void								addBlock(size_t capacity);
+	size_t								nextBlockSize() const;
+	template<typename... Args>
+	uint32_t							acquireSlot(Args&&... args);
+	template<typename... Args>
+	uint32_t							acquireNamedSlot(vel::Name name, Args&&... args);
+	sac_handle							slotHandle(uint32_t slotIndex) const;
+	void								eraseSlot(uint32_t slotIndex);
+	bool								slotFromPointer(const T* slotPtr, uint32_t& slotIndexOut) const;
+
 
 public:
-	sac(size_t blockSize);
+	sac(size_t blockSize, size_t maxBlockSize = 4096);
 	sac();
 	//~sac();
 	//sac(const sac<T>& old);
-	T*									insert(std::string name, T dataObject);
-	void								erase(std::string name);
+	// handleOut, when given, receives the handle of the new element so it doesn't have to be looked up
+	T*									insert(vel::Name name, T dataObject, sac_handle* handleOut = nullptr);
+	T*									insert(T dataObject, sac_handle* handleOut = nullptr);
+	template<typename... Args>
+	T*									emplace(vel::Name name, Args&&... args);
+	template<typename... Args>
+	T*									emplace(sac_handle* handleOut, vel::Name name, Args&&... args);
+	void								erase(vel::Name name);
 	void								erase(T* slotPtr);
-	T*									get(std::string name);
+	void								erase(sac_handle handle);
+	T*									get(vel::Name name);
+	T*									get(sac_handle handle);
+	sac_handle							getHandle(const T* slotPtr) const; // walks the blocks, prefer the handle given by insert()
+	sac_handle							getHandle(vel::Name name) const;
 	std::vector<T*>&					getAll();
 	size_t								size() const;
-	bool								exists(std::string name) const;
+	bool								exists(vel::Name name) const;
+	bool								exists(sac_handle handle) const;
+
+	void								reserve(size_t count);
+	void								shrink_to_fit();
+	size_t								memoryFootprint() const;
 
 };
 
@@ -57,31 +103,25 @@ public:
 //	ptrackerMap(old.ptrackerMap),
 //	activeSlotTrackerMap(old.activeSlotTrackerMap)
 //{
-//	
+//
 //}
 
 template <typename T>
 sac<T>::sac() :
 	data(std::make_shared<sac_data<T>>())
 {
-	size_t blockSize = 10000;
-
 	//std::stringstream ss;
 	//ss << std::this_thread::get_id();
 	//uint64_t id = std::stoull(ss.str());
 
 	//std::cout << id << ":Initializing:" << this << std::endl;
 
-	this->data->blockSize = blockSize;
-	this->data->blockIndex = 0;
-	this->data->slots.push_back(std::vector<T>());
-	this->data->slots.at(0).reserve(blockSize);
-	this->data->activeSlots.reserve(blockSize);
-	this->data->freeSlots.reserve(blockSize);
+	this->data->blockSize = 16;
+	this->data->maxBlockSize = 4096;
 }
 
 template <typename T>
-sac<T>::sac(size_t blockSize) :
+sac<T>::sac(size_t blockSize, size_t maxBlockSize) :
 	data(std::make_shared<sac_data<T>>())
 {
 	//std::stringstream ss;
@@ -90,12 +130,8 @@ sac<T>::sac(size_t blockSize) :
 
 	//std::cout << id << ":Initializing:" << this << std::endl;
 
-	this->data->blockSize = blockSize;
-	this->data->blockIndex = 0;
-	this->data->slots.push_back(std::vector<T>());
-	this->data->slots.at(0).reserve(blockSize);
-	this->data->activeSlots.reserve(blockSize);
-	this->data->freeSlots.reserve(blockSize);
+	this->data->blockSize = blockSize > 0 ? blockSize : 1;
+	this->data->maxBlockSize = std::max(this->data->blockSize, maxBlockSize);
 }
 
 //template <typename T>
@@ -109,138 +145,274 @@ sac<T>::sac(size_t blockSize) :
 //}
 
 template <typename T>
-T* sac<T>::insert(std::string name, T dataObject)
+void sac<T>::addBlock(size_t capacity)
 {
-	//std::stringstream ss;
-	//ss << std::this_thread::get_id();
-	//uint64_t id = std::stoull(ss.str());
+	// elements are only ever pushed into the last block, and never beyond the capacity reserved here,
+	// so the block never reallocates and pointers into it stay valid
+	this->data->slots.push_back(std::vector<T>());
+	this->data->slots.back().reserve(capacity);
+}
 
-	//std::cout << id << ":sac.h:" << name << ":" << this << std::endl;
+template <typename T>
+size_t sac<T>::nextBlockSize() const
+{
+	if (this->data->slots.size() == 0)
+		return this->data->blockSize;
 
-	// if this key already exists within the sac, bypass insertion and return pointer to existing item.
-	// This could be a cause of confusion
-	if (this->data->trackerMap.count(name) == 1)
-	{
-		//std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " 
-		//	<< name << " bypassing insert" << std::endl;
-		std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " << name << std::endl;
-		std::cin.get();
-		exit(EXIT_FAILURE);
-		//return this->data->trackerMap[name];
-	}
+	return std::min(std::max(this->data->slots.back().capacity() * 2, this->data->blockSize), this->data->maxBlockSize);
+}
 
-	T* slotPointer;
+// constructs the element from args, either by move assigning into a free slot or by constructing it
+// in place at the end of the last block
+template <typename T>
+template <typename... Args>
+uint32_t sac<T>::acquireSlot(Args&&... args)
+{
+	uint32_t slotIndex;
 	if (this->data->freeSlots.size() > 0)
 	{
-		slotPointer = this->data->freeSlots.back();
+		slotIndex = this->data->freeSlots.back();
 		this->data->freeSlots.pop_back();
-		*slotPointer = dataObject;
+		*this->data->slotPointers[slotIndex] = T(std::forward<Args>(args)...);
 	}
 	else
 	{
-		if (this->data->slots.at(this->data->blockIndex).size() == this->data->blockSize)
-		{
-			this->data->slots.push_back(std::vector<T>());
-			this->data->slots.back().reserve(this->data->blockSize);
-			this->data->blockIndex++;
-		}
+		if (this->data->slots.size() == 0 || this->data->slots.back().size() == this->data->slots.back().capacity())
+			this->addBlock(this->nextBlockSize());
+
+		this->data->slots.back().emplace_back(std::forward<Args>(args)...);
 
-		//std::cout << "sac001" << std::endl;
+		slotIndex = (uint32_t)this->data->slotPointers.size();
+		this->data->slotPointers.push_back(&this->data->slots.back().back());
+		this->data->slotActiveIndexes.push_back(std::string::npos);
+		this->data->slotNames.push_back(vel::Name());
+		this->data->slotNamed.push_back(false);
 
-		this->data->slots.at(this->data->blockIndex).push_back(dataObject);
+		// slots are never released (not even by shrink_to_fit()), so this is always a brand new slot and no
+		// handle can refer to it yet
+		this->data->slotGenerations.push_back(0);
+	}
 
-		//std::cout << "sac001b" << std::endl;
+	this->data->slotActiveIndexes[slotIndex] = this->data->activeSlots.size();
+	this->data->activeSlots.push_back(this->data->slotPointers[slotIndex]);
+	this->data->activeSlotIndexes.push_back(slotIndex);
 
-		slotPointer = &this->data->slots.at(this->data->blockIndex).back();
+	return slotIndex;
+}
 
-		//std::cout << "sac002" << std::endl;
+// constructs the element like acquireSlot() and adds it to the name side index, dies if the name is taken
+template <typename T>
+template <typename... Args>
+uint32_t sac<T>::acquireNamedSlot(vel::Name name, Args&&... args)
+{
+	if (this->data->trackerMap.count(name) == 1)
+	{
+		std::cout << "sac::insert(): the name of the data object which you are trying to load into the sac already exists: " << name.str() << std::endl;
+		std::cin.get();
+		exit(EXIT_FAILURE);
 	}
 
-	// TODO activeSlots reallocating on every entry if blockSize has been reached,
-	// need to reserve additional block size when this happens like we do for slots.back()
+	auto slotIndex = this->acquireSlot(std::forward<Args>(args)...);
+
+	this->data->trackerMap.emplace(name, slotIndex);
+	this->data->slotNames[slotIndex] = name;
+	this->data->slotNamed[slotIndex] = true;
+
+	return slotIndex;
+}
 
-	//std::cout << "sac003:" << slotPointer << std::endl;
+template <typename T>
+sac_handle sac<T>::slotHandle(uint32_t slotIndex) const
+{
+	sac_handle h;
+	h.index = slotIndex;
+	h.generation = this->data->slotGenerations[slotIndex];
+
+	return h;
+}
 
-	this->data->activeSlots.push_back(slotPointer);
-	this->data->activeSlotTrackerMap[slotPointer] = this->data->activeSlots.size() - 1;
+template <typename T>
+T* sac<T>::insert(vel::Name name, T dataObject, sac_handle* handleOut)
+{
+	auto slotIndex = this->acquireNamedSlot(name, std::move(dataObject));
+
+	if (handleOut != nullptr)
+		*handleOut = this->slotHandle(slotIndex);
+
+	return this->data->slotPointers[slotIndex];
+}
+
+template <typename T>
+T* sac<T>::insert(T dataObject, sac_handle* handleOut)
+{
+	auto slotIndex = this->acquireSlot(std::move(dataObject));
 
-	this->data->trackerMap[name] = slotPointer;
-	this->data->ptrackerMap[slotPointer] = name;
+	if (handleOut != nullptr)
+		*handleOut = this->slotHandle(slotIndex);
 
-	return slotPointer;
+	return this->data->slotPointers[slotIndex];
 }
 
+// constructs the element in place from args, avoiding the temporary (and any copies) that insert requires
 template <typename T>
-void sac<T>::erase(std::string name)
+template <typename... Args>
+T* sac<T>::emplace(vel::Name name, Args&&... args)
 {
-	if (!this->data->trackerMap.count(name) == 1)
+	return this->data->slotPointers[this->acquireNamedSlot(name, std::forward<Args>(args)...)];
+}
+
+template <typename T>
+template <typename... Args>
+T* sac<T>::emplace(sac_handle* handleOut, vel::Name name, Args&&... args)
+{
+	auto slotIndex = this->acquireNamedSlot(name, std::forward<Args>(args)...);
+
+	if (handleOut != nullptr)
+		*handleOut = this->slotHandle(slotIndex);
+
+	return this->data->slotPointers[slotIndex];
+}
+
+template <typename T>
+void sac<T>::eraseSlot(uint32_t slotIndex)
+{
+	size_t indexOfPointerToRemove = this->data->slotActiveIndexes[slotIndex];
+
+	// swap the pointer to remove with the last element in activeSlots and pop it off, then update the
+	// active index of the element we swapped (if it was not the last element already)
+	if (indexOfPointerToRemove != this->data->activeSlots.size() - 1)
 	{
-		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << name << std::endl;
-		std::cin.get();
-		exit(EXIT_FAILURE);
+		std::iter_swap(this->data->activeSlots.begin() + indexOfPointerToRemove, this->data->activeSlots.end() - 1);
+		std::iter_swap(this->data->activeSlotIndexes.begin() + indexOfPointerToRemove, this->data->activeSlotIndexes.end() - 1);
+
+		this->data->slotActiveIndexes[this->data->activeSlotIndexes[indexOfPointerToRemove]] = indexOfPointerToRemove;
 	}
 
-	T* pointerToRemove = this->data->trackerMap[name];
-	// remove from activeSlots
-	if (this->data->activeSlots.size() > 1)
+	this->data->activeSlots.pop_back();
+	this->data->activeSlotIndexes.pop_back();
+
+	// remove from name side index if this slot was named
+	if (this->data->slotNamed[slotIndex])
 	{
-		// get index of pointerToRemove
-		size_t indexOfPointerToRemove = this->data->activeSlotTrackerMap[pointerToRemove];
+		this->data->trackerMap.erase(this->data->slotNames[slotIndex]);
+		this->data->slotNames[slotIndex] = vel::Name();
+		this->data->slotNamed[slotIndex] = false;
+	}
 
-		// if indexOfPointerToRemove is the last element
-		if (indexOfPointerToRemove == this->data->activeSlots.size() - 1)
+	// invalidate all outstanding handles to this slot and push to freeSlots
+	this->data->slotActiveIndexes[slotIndex] = std::string::npos;
+	this->data->slotGenerations[slotIndex]++;
+	this->data->freeSlots.push_back(slotIndex);
+}
+
+template <typename T>
+bool sac<T>::slotFromPointer(const T* slotPtr, uint32_t& slotIndexOut) const
+{
+	// blocks are filled in order and never shrink, so the slot index of an element is the number of
+	// elements in all blocks before the one containing it plus it's offset within that block
+	size_t blockStart = 0;
+	for (auto& block : this->data->slots)
+	{
+		if (block.size() > 0 && slotPtr >= block.data() && slotPtr < block.data() + block.size())
 		{
-			this->data->activeSlots.pop_back();
+			slotIndexOut = (uint32_t)(blockStart + (slotPtr - block.data()));
+			return this->data->slotActiveIndexes[slotIndexOut] != std::string::npos;
 		}
-		else
-		{
-			// swap the pointer to remove with the last element in activeSlots
-			std::iter_swap(this->data->activeSlots.begin() + indexOfPointerToRemove, this->data->activeSlots.end() - 1);
-
-			// remove pointerToRemove from activeSlots (it is now the last element in the vector)
-			this->data->activeSlots.pop_back();
 
-			// update the index of the element we swapped within activeSlotTrackerMap
-			this->data->activeSlotTrackerMap[this->data->activeSlots.at(indexOfPointerToRemove)] = indexOfPointerToRemove;
-		}
+		blockStart += block.size();
 	}
-	else
+
+	return false;
+}
+
+template <typename T>
+void sac<T>::erase(vel::Name name)
+{
+	auto it = this->data->trackerMap.find(name);
+	if (it == this->data->trackerMap.end())
 	{
-		this->data->activeSlots.clear();
+		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << name.str() << std::endl;
+		std::cin.get();
+		exit(EXIT_FAILURE);
 	}
 
-	// push to freeSlots
-	this->data->freeSlots.push_back(pointerToRemove);
-
-	// remove from trackers
-	this->data->ptrackerMap.erase(pointerToRemove);
-	this->data->trackerMap.erase(name);
+	this->eraseSlot(it->second);
 }
 
 template <typename T>
 void sac<T>::erase(T* slotPtr)
 {
-	if (!this->data->ptrackerMap.count(slotPtr) == 1)
+	uint32_t slotIndex;
+	if (!this->slotFromPointer(slotPtr, slotIndex))
 	{
 		std::cout << "sac::erase(): attempting to erase element from sac which does not exist: " << slotPtr << std::endl;
 		std::cin.get();
 		exit(EXIT_FAILURE);
 	}
 
-	this->erase(this->data->ptrackerMap[slotPtr]);
+	this->eraseSlot(slotIndex);
 }
 
 template <typename T>
-T* sac<T>::get(std::string name)
+void sac<T>::erase(sac_handle handle)
 {
-	if (!this->data->trackerMap.count(name) == 1)
+	if (!this->exists(handle))
 	{
-		std::cout << "sac::get(): attempting to get element from sac which does not exist: " << name << std::endl;
+		std::cout << "sac::erase(): attempting to erase element from sac using stale handle: " << handle.index << ":" << handle.generation << std::endl;
 		std::cin.get();
 		exit(EXIT_FAILURE);
 	}
 
-	return this->data->trackerMap[name];
+	this->eraseSlot(handle.index);
+}
+
+// only finds, never inserts, so it's safe for concurrent readers (AssetManager looks up under a shared lock)
+template <typename T>
+T* sac<T>::get(vel::Name name)
+{
+	auto it = this->data->trackerMap.find(name);
+	if (it == this->data->trackerMap.end())
+	{
+		std::cout << "sac::get(): attempting to get element from sac which does not exist: " << name.str() << std::endl;
+		std::cin.get();
+		exit(EXIT_FAILURE);
+	}
+
+	return this->data->slotPointers[it->second];
+}
+
+// returns nullptr if the handle is stale (element it referred to has been erased)
+template <typename T>
+T* sac<T>::get(sac_handle handle)
+{
+	if (!this->exists(handle))
+		return nullptr;
+
+	return this->data->slotPointers[handle.index];
+}
+
+template <typename T>
+sac_handle sac<T>::getHandle(const T* slotPtr) const
+{
+	uint32_t slotIndex;
+	if (this->slotFromPointer(slotPtr, slotIndex))
+		return this->slotHandle(slotIndex);
+
+	return sac_handle();
+}
+
+template <typename T>
+sac_handle sac<T>::getHandle(vel::Name name) const
+{
+	sac_handle h;
+	auto it = this->data->trackerMap.find(name);
+	if (it != this->data->trackerMap.end())
+	{
+		h.index = it->second;
+		h.generation = this->data->slotGenerations[it->second];
+	}
+
+	return h;
 }
 
 template <typename T>
@@ -256,7 +428,81 @@ size_t sac<T>::size() const
 }
 
 template <typename T>
-bool sac<T>::exists(std::string name) const
+bool sac<T>::exists(vel::Name name) const
 {
 	return this->data->trackerMap.count(name) == 1;
-}
\ No newline at end of file
+}
+
+template <typename T>
+bool sac<T>::exists(sac_handle handle) const
+{
+	return handle.index < this->data->slotGenerations.size() &&
+		this->data->slotGenerations[handle.index] == handle.generation &&
+		this->data->slotActiveIndexes[handle.index] != std::string::npos;
+}
+
+// makes sure count elements can be held without allocating another block
+template <typename T>
+void sac<T>::reserve(size_t count)
+{
+	if (count <= this->size())
+		return;
+
+	size_t available = this->data->freeSlots.size();
+	if (this->data->slots.size() > 0)
+		available += this->data->slots.back().capacity() - this->data->slots.back().size();
+
+	size_t required = count - this->size();
+	if (required > available)
+	{
+		// whatever is left in the current last block is skipped, elements are only pushed into the last block
+		this->addBlock(required - this->data->freeSlots.size());
+	}
+
+	this->data->activeSlots.reserve(count);
+	this->data->activeSlotIndexes.reserve(count);
+}
+
+// releases unused bookkeeping capacity only. Block memory is retained, even for blocks which are now empty, erased
+// elements are only marked deleted (see Stage::_removeActor()) so pointers to them have to stay valid for the life
+// of the sac. A sac that grew large keeps it's peak element memory until it's destroyed
+template <typename T>
+void sac<T>::shrink_to_fit()
+{
+	this->data->slots.shrink_to_fit();
+	this->data->activeSlots.shrink_to_fit();
+	this->data->activeSlotIndexes.shrink_to_fit();
+	this->data->freeSlots.shrink_to_fit();
+	this->data->slotPointers.shrink_to_fit();
+	this->data->slotGenerations.shrink_to_fit();
+	this->data->slotActiveIndexes.shrink_to_fit();
+	this->data->slotNames.shrink_to_fit();
+	this->data->slotNamed.shrink_to_fit();
+	this->data->trackerMap.rehash(0);
+}
+
+// approximate number of bytes held by this sac, not including memory owned by the elements themselves
+template <typename T>
+size_t sac<T>::memoryFootprint() const
+{
+	auto& d = *this->data;
+
+	size_t bytes = sizeof(sac_data<T>);
+
+	for (auto& block : d.slots)
+		bytes += block.capacity() * sizeof(T);
+
+	bytes += d.slots.capacity() * sizeof(std::vector<T>);
+	bytes += d.activeSlots.capacity() * sizeof(T*);
+	bytes += d.activeSlotIndexes.capacity() * sizeof(uint32_t);
+	bytes += d.freeSlots.capacity() * sizeof(uint32_t);
+	bytes += d.slotPointers.capacity() * sizeof(T*);
+	bytes += d.slotGenerations.capacity() * sizeof(uint32_t);
+	bytes += d.slotActiveIndexes.capacity() * sizeof(size_t);
+	bytes += d.slotNames.capacity() * sizeof(vel::Name);
+	bytes += d.slotNamed.capacity() / 8;
+	bytes += d.trackerMap.bucket_count() * sizeof(void*);
+	bytes += d.trackerMap.size() * (sizeof(std::pair<const vel::Name, uint32_t>) + sizeof(void*));
+
+	return bytes;
+}
@@ -0,0 +1,21 @@
+#pragma once
+
+#include <cstdint>
+#include <limits>
+
+
+/*
+	Generational handle into a sac or ptrsac. The index is the slot the element lives in,
+	the generation is bumped every time that slot is erased, so a handle that outlives the
+	element it was created for will no longer resolve (instead of silently pointing at
+	whatever was inserted into the recycled slot).
+*/
+struct sac_handle
+{
+	uint32_t	index = std::numeric_limits<uint32_t>::max();
+	uint32_t	generation = 0;
+
+	bool		isNull() const { return this->index == std::numeric_limits<uint32_t>::max(); }
+	bool		operator==(const sac_handle& other) const { return this->index == other.index && this->generation == other.generation; }
+	bool		operator!=(const sac_handle& other) const { return !(*this == other); }
+};
@@ -1,11 +1,15 @@
 #include <iostream>
+#include <limits>
 
 #include "vel/functions.h"
 #include "vel/Actor.h"
+#include "vel/Stage.h"
 
 
 namespace vel
 {
+	std::atomic<uint32_t> Actor::simulationVersion(0);
+
 	Actor::Actor(std::string name) :
 		name(name),
 		deleted(false),
@@ -15,11 +19,21 @@ namespace vel
 		parentActor(nullptr),
 		parentArmatureBone(nullptr),
 		armature(nullptr),
+		stage(nullptr),
+		worldQueued(false),
 		mesh(nullptr),
 		collisionWorld(nullptr),
 		rigidBody(nullptr),
 		ghostObject(nullptr),
-		autoTransform(true) // this is needed so that we don't update a static actor that has a rigidbody association
+		autoTransform(true), // this is needed so that we don't update a static actor that has a rigidbody association
+		worldMatrix(1.0f),
+		worldVersion(0),
+		worldBuiltFromLocal(0),
+		worldBuiltFromParent(0),
+		worldDirty(true),
+		worldBoundsMin(0.0f),
+		worldBoundsMax(0.0f),
+		spatialIndexVersion(0)
 	{}
 
 	void Actor::setCollisionWorld(CollisionWorld* cw)
@@ -50,11 +64,13 @@ namespace vel
 	void Actor::processTransform()
 	{
 		this->updatePreviousTransform();
+		this->syncRigidBodyTransform();
+	}
 
-		// TODO: this can be avoided by deriving our own motionstate class from btMotionState, 
-		// but will need to put thought into how that will affect our current interpolation process
-		// for framerate independent logic
-		// https://pybullet.org/Bullet/phpBB3/viewtopic.php?t=1205
+	void Actor::syncRigidBodyTransform()
+	{
+		// only used for rigidbodies which weren't given an ActorMotionState, those push their transform
+		// into the actor themselves when bullet moves them
 		if (this->autoTransform && this->rigidBody != nullptr)
 		{
 			this->transform.setTranslation(bulletToGlmVec3(this->rigidBody->getWorldTransform().getOrigin()));
@@ -89,12 +105,15 @@ namespace vel
 				this->parentActor->removeChildActor(this, true);
 
 			this->parentActor = nullptr;
+			this->worldDirty = true;
+			Actor::bumpSimulationVersion();
 		}
 	}
 
 	void Actor::setDynamic(bool dynamic)
 	{
 		this->dynamic = dynamic;
+		Actor::bumpSimulationVersion();
 	}
 
 	void Actor::setGhostObject(btPairCachingGhostObject* go)
@@ -123,6 +142,11 @@ namespace vel
 		newActor.setGhostObject(nullptr);
 		newActor.setAutoTransform(true);
 		newActor.setArmature(nullptr);
+
+		// Clear handles, these are assigned when the copy is added to a stage
+		newActor.setStage(nullptr);
+		newActor.setStageHandle(sac_handle());
+		newActor.setStageRenderableHandle(sac_handle());
 		newActor.clearContactSensors();
 
 		// TODO: In the future we may need to implement methods for:
@@ -139,8 +163,10 @@ namespace vel
 
 	void Actor::addRenderable(Renderable r)
 	{
-		this->tempRenderable = r;
 		this->mesh = r.getMesh();
+		this->tempRenderable = std::move(r);
+		this->worldDirty = true; // world bounds depend on the mesh
+		Actor::bumpSimulationVersion();
 	}
 
 	Mesh* Actor::getMesh()
@@ -158,18 +184,132 @@ namespace vel
 		this->tempRenderable.reset();
 	}
 
-	glm::mat4 Actor::getWorldMatrix()
+	// the world matrix is cached and only rebuilt when this actor's transform, it's parent's world matrix or the
+	// parent itself has changed since. Walks up the parents to find out, use Stage::updateWorldMatrices() to
+	// refresh a whole hierarchy in one pass instead
+	const glm::mat4& Actor::getWorldMatrix()
 	{
-		// if this actor has no parent, simply return the matrix of it's transform
-		if (this->parentActor == nullptr && this->parentArmatureBone == nullptr)
-			return this->transform.getMatrix();
+		if (this->parentArmatureBone == nullptr && this->parentActor != nullptr)
+			this->parentActor->getWorldMatrix();
 
-		// if this actor is parented to another actor (parenting to actor will override bone parenting)
-		if (this->parentArmatureBone == nullptr)
-			return this->parentActor->getWorldMatrix() * this->transform.getMatrix();
+		this->refreshWorldMatrix();
+		return this->worldMatrix;
+	}
+
+	// rebuilds the cached world matrix (and world bounds) if stale, assuming the parent actor's is already up to date
+	void Actor::refreshWorldMatrix()
+	{
+		// if this actor is parented to a bone (which takes precedence over an actor), it's posed every tick so there
+		// is nothing to compare against, always rebuild
+		if (this->parentArmatureBone != nullptr)
+		{
+			//this->worldMatrix = this->parentActor->getWorldMatrix() * this->parentArmatureBone->matrix * this->transform.getMatrix();
+			this->worldMatrix = this->parentArmatureBone->matrix * this->transform.getMatrix();
+			this->worldVersion++;
+			this->worldDirty = false;
+			this->refreshWorldBounds();
+			return;
+		}
 
-		//return this->parentActor->getWorldMatrix() * this->parentArmatureBone->matrix * this->transform.getMatrix();
-		return this->parentArmatureBone->matrix * this->transform.getMatrix();
+		uint32_t parentVersion = this->parentActor != nullptr ? this->parentActor->worldVersion : 0;
+
+		if (!this->worldDirty && this->worldBuiltFromLocal == this->transform.getVersion() && this->worldBuiltFromParent == parentVersion)
+			return;
+
+		// if this actor has no parent, simply use the matrix of it's transform
+		if (this->parentActor == nullptr)
+			this->worldMatrix = this->transform.getMatrix();
+		else
+			this->worldMatrix = this->parentActor->worldMatrix * this->transform.getMatrix();
+
+		this->worldBuiltFromLocal = this->transform.getVersion();
+		this->worldBuiltFromParent = parentVersion;
+		this->worldVersion++;
+		this->worldDirty = false;
+		this->refreshWorldBounds();
+	}
+
+	// grows min/max to hold the box around [boxMin, boxMax] once transformed by m, center moved by the matrix and
+	// half extents by the absolute value of it's upper 3x3
+	static void growBounds(const glm::mat4& m, const glm::vec3& boxMin, const glm::vec3& boxMax, glm::vec3& min, glm::vec3& max)
+	{
+		glm::vec3 center = (boxMin + boxMax) * 0.5f;
+		glm::vec3 halfExtent = (boxMax - boxMin) * 0.5f;
+
+		glm::vec3 transformedCenter = glm::vec3(m * glm::vec4(center, 1.0f));
+		glm::vec3 transformedHalfExtent(0.0f);
+		for (int c = 0; c < 3; c++)
+			transformedHalfExtent += glm::abs(glm::vec3(m[c])) * halfExtent[c];
+
+		min = glm::min(min, transformedCenter - transformedHalfExtent);
+		max = glm::max(max, transformedCenter + transformedHalfExtent);
+	}
+
+	// the box around the mesh's local bounds once transformed by the world matrix. A skinned vertex is a weighted
+	// blend of it's bind pose position moved by each of it's bones, so it stays within the box around the bind
+	// pose bounds moved by every bone of the current pose, which is used in place of the local bounds
+	void Actor::refreshWorldBounds()
+	{
+		if (this->mesh == nullptr)
+		{
+			this->worldBoundsMin = glm::vec3(this->worldMatrix[3]);
+			this->worldBoundsMax = this->worldBoundsMin;
+			return;
+		}
+
+		glm::vec3 localMin = this->mesh->getBoundsMin();
+		glm::vec3 localMax = this->mesh->getBoundsMax();
+
+		if (this->armature != nullptr && !this->activeBones.empty())
+		{
+			glm::vec3 skinMin(std::numeric_limits<float>::max());
+			glm::vec3 skinMax(std::numeric_limits<float>::lowest());
+
+			size_t boneIndex = 0;
+			for (auto& activeBone : this->activeBones)
+			{
+				growBounds(this->armature->getBone(activeBone.first).matrix * this->mesh->getBone(boneIndex).offsetMatrix, localMin, localMax, skinMin, skinMax);
+				boneIndex++;
+			}
+
+			localMin = skinMin;
+			localMax = skinMax;
+		}
+
+		this->worldBoundsMin = glm::vec3(std::numeric_limits<float>::max());
+		this->worldBoundsMax = glm::vec3(std::numeric_limits<float>::lowest());
+		growBounds(this->worldMatrix, localMin, localMax, this->worldBoundsMin, this->worldBoundsMax);
+	}
+
+	void Actor::refreshPoseBounds()
+	{
+		if (this->isAnimated())
+			this->refreshWorldBounds();
+	}
+
+	uint32_t Actor::getWorldVersion() const
+	{
+		return this->worldVersion;
+	}
+
+	void Actor::setSpatialIndexVersion(uint32_t v)
+	{
+		this->spatialIndexVersion = v;
+	}
+
+	uint32_t Actor::getSpatialIndexVersion() const
+	{
+		return this->spatialIndexVersion;
+	}
+
+	const glm::vec3& Actor::getWorldBoundsMin() const
+	{
+		return this->worldBoundsMin;
+	}
+
+	const glm::vec3& Actor::getWorldBoundsMax() const
+	{
+		return this->worldBoundsMax;
 	}
 
 	glm::mat4 Actor::getWorldRenderMatrix(float alpha)
@@ -182,7 +322,12 @@ namespace vel
 		if (!this->isDynamic() || !this->previousTransform)
 			return this->getWorldMatrix();
 
-		auto actorMatrix = Transform::interpolateTransforms(this->previousTransform.value(), this->transform, alpha);
+		// nothing moved over the last tick so there is nothing to interpolate, the cached matrices can be used
+		bool moved = this->previousTransform.value() != this->transform;
+		if (!moved && this->parentActor == nullptr && this->parentArmatureBone == nullptr)
+			return this->getWorldMatrix();
+
+		glm::mat4 actorMatrix = moved ? Transform::interpolateTransforms(this->previousTransform.value(), this->transform, alpha) : this->transform.getMatrix();
 
 		// if this actor has no parent, simply return the matrix of it's transform
 		if (this->parentActor == nullptr && this->parentArmatureBone == nullptr)
@@ -233,7 +378,7 @@ namespace vel
 	void Actor::updatePreviousTransform()
 	{
 		if (!this->isDeleted() && this->isDynamic())
-			this->previousTransform = this->getTransform();
+			this->previousTransform = this->transform;
 	}
 
 	void Actor::setParentActor(Actor* a)
@@ -242,7 +387,9 @@ namespace vel
 		if(a != nullptr)
 		{
 			this->parentActor = a;
+			this->worldDirty = true;
 			a->addChildActor(this);
+			Actor::bumpSimulationVersion();
 		}
 		// remove the parent relationship
 		else
@@ -257,7 +404,9 @@ namespace vel
 		if(b != nullptr)
 		{
 			this->parentArmatureBone = b;
+			this->worldDirty = true;
 			b->childActors.push_back(this);
+			Actor::bumpSimulationVersion();
 		}
 		// remove the parent relationship
 		else if(this->parentArmatureBone != nullptr)
@@ -271,25 +420,50 @@ namespace vel
 				i++;
 			}
 			this->parentArmatureBone = nullptr;
+			this->worldDirty = true;
+			Actor::bumpSimulationVersion();
 		}
 	}
 
+	Actor* Actor::getParentActor()
+	{
+		return this->parentActor;
+	}
+
+	const std::vector<Actor*>& Actor::getChildActors() const
+	{
+		return this->childActors;
+	}
+
+	ArmatureBone* Actor::getParentArmatureBone()
+	{
+		return this->parentArmatureBone;
+	}
+
 	void Actor::addChildActor(Actor* a)
 	{
 		this->childActors.push_back(a);
 	}
 
-	void Actor::setActiveBones(std::vector<std::pair<size_t, std::string>> activeBones)
+	void Actor::setActiveBones(std::vector<std::pair<size_t, Name>> activeBones)
 	{
 		this->activeBones = activeBones;
 	}
 
-	const std::vector<std::pair<size_t, std::string>>& Actor::getActiveBones() const
+	const std::vector<std::pair<size_t, Name>>& Actor::getActiveBones() const
 	{
 		return this->activeBones;
 	}
 
 	Transform& Actor::getTransform()
+	{
+		if (this->stage != nullptr)
+			this->stage->markMoved(this);
+
+		return this->transform;
+	}
+
+	const Transform& Actor::getTransform() const
 	{
 		return this->transform;
 	}
@@ -312,11 +486,23 @@ namespace vel
 	void Actor::setRigidBody(btRigidBody* rb)
 	{
 		this->rigidBody = rb;
+		Actor::bumpSimulationVersion();
 	}
 
 	void Actor::setAutoTransform(bool mt)
 	{
 		this->autoTransform = mt;
+		Actor::bumpSimulationVersion();
+	}
+
+	uint32_t Actor::getSimulationVersion()
+	{
+		return Actor::simulationVersion.load(std::memory_order_relaxed);
+	}
+
+	void Actor::bumpSimulationVersion()
+	{
+		Actor::simulationVersion.fetch_add(1, std::memory_order_relaxed);
 	}
 
 	btRigidBody* Actor::getRigidBody()
@@ -357,6 +543,42 @@ namespace vel
 		this->stageRenderable = r;
 	}
 
+	void Actor::setStage(Stage* s)
+	{
+		this->stage = s;
+		this->worldQueued = false;
+	}
+
+	void Actor::setWorldQueued(bool q)
+	{
+		this->worldQueued = q;
+	}
+
+	bool Actor::isWorldQueued() const
+	{
+		return this->worldQueued;
+	}
+
+	void Actor::setStageHandle(sac_handle h)
+	{
+		this->stageHandle = h;
+	}
+
+	sac_handle Actor::getStageHandle() const
+	{
+		return this->stageHandle;
+	}
+
+	void Actor::setStageRenderableHandle(sac_handle h)
+	{
+		this->stageRenderableHandle = h;
+	}
+
+	sac_handle Actor::getStageRenderableHandle() const
+	{
+		return this->stageRenderableHandle;
+	}
+
 	const bool Actor::isAnimated() const
 	{
 		if (this->armature)
@@ -368,6 +590,7 @@ namespace vel
 	void Actor::setArmature(Armature* arm)
 	{
 		this->armature = arm;
+		Actor::bumpSimulationVersion();
 	}
 
 	Armature* Actor::getArmature()
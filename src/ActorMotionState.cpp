@@ -0,0 +1,41 @@
+#include "vel/ActorMotionState.h"
+#include "vel/Actor.h"
+#include "vel/CollisionWorld.h"
+#include "vel/functions.h"
+
+
+namespace vel
+{
+	ActorMotionState::ActorMotionState(Actor* actor, CollisionWorld* collisionWorld, const btTransform& startTransform) :
+		actor(actor),
+		collisionWorld(collisionWorld),
+		transform(startTransform)
+	{}
+
+	void ActorMotionState::getWorldTransform(btTransform& worldTrans) const
+	{
+		worldTrans = this->transform;
+	}
+
+	// called from within CollisionWorld::step(), on whichever thread is stepping the world
+	void ActorMotionState::setWorldTransform(const btTransform& worldTrans)
+	{
+		this->transform = worldTrans;
+
+		if (this->actor == nullptr || !this->actor->getAutoTransform())
+			return;
+
+		this->actor->updatePreviousTransform();
+		this->actor->transform.setTranslation(bulletToGlmVec3(worldTrans.getOrigin()));
+		this->actor->transform.setRotation(bulletToGlmQuat(worldTrans.getRotation()));
+
+		this->collisionWorld->addMovedActor(this->actor);
+	}
+
+	bool ActorMotionState::drives(Actor* a)
+	{
+		auto rb = a->getRigidBody();
+		return rb != nullptr && a->getAutoTransform() && dynamic_cast<ActorMotionState*>(rb->getMotionState()) != nullptr;
+	}
+
+}
@@ -1,6 +1,6 @@
 #include <iostream>
 #include <limits>
-#include <thread> 
+#include <algorithm>
 #include <chrono>
 
 
@@ -10,8 +10,7 @@
 
 #include "vel/App.h"
 #include "vel/Log.h"
-
-using namespace std::chrono_literals;
+#include "vel/Profiler.h"
 
 namespace vel
 {
@@ -22,6 +21,10 @@ namespace vel
 		// initialze Log
 		Log::init(conf.LOG_PATH);
 
+		// before App exists so the profiler outlives it, and every thread it starts
+		Profiler::setEventsPerThread(conf.PROFILER_EVENTS_PER_THREAD);
+		Profiler::setThreadName("Main");
+
 		static App inst(conf);
 		App::instance = &inst;
     }
@@ -33,12 +36,28 @@ namespace vel
 
     App::App(Config conf) :
         config(conf),
-		window(std::make_unique<Window>(this->config)),
-		gpu(std::make_unique<GPU>(this->window.get())),
-		assetManager(AssetManager(this->gpu.get())),
+		jobSystem(this->config.JOB_THREADS),
+#ifndef HEADLESS_BUILD
+		window(this->config.HEADLESS ? nullptr : std::make_unique<Window>(this->config)),
+		gpu(this->config.HEADLESS ? nullptr : std::make_unique<GPU>(this->window.get())),
+#endif
+		headlessScreenSize(this->config.SCREEN_WIDTH, this->config.SCREEN_HEIGHT),
+		assetManager(AssetManager(this->getGPU())),
 		activeScene(nullptr),
-        startTime(std::chrono::high_resolution_clock::now())
-    {        
+        startTime(std::chrono::steady_clock::now()),
+		framePacer(this->config.FRAME_PACER_SLACK),
+		telemetry(this->config.HITCH_THRESHOLD)
+    {
+#ifdef HEADLESS_BUILD
+		this->config.HEADLESS = true; // there is no window or gpu to fall back on
+#endif
+		TickGraph::setValidation(this->config.VALIDATE_TICK_GRAPH);
+
+#ifdef DEBUG_LOG
+	if (this->isHeadless())
+		Log::toCliAndFile("Running headless, assets are only loaded into main memory");
+#endif
+        
         /* load default shaders
 		***************************************************************/
 
@@ -101,16 +120,22 @@ namespace vel
         
         
         // pass shaders gpu needs for generating hdr assets
-        this->gpu->initPbrShaders(
-            this->assetManager.getShader("defaultEquirectangularToCubemap"),
-            this->assetManager.getShader("defaultIrradianceConvolution"),
-            this->assetManager.getShader("defaultPrefilter"),
-            this->assetManager.getShader("defaultBrdf"),
-            this->assetManager.getShader("defaultBackground")
-        );
+#ifndef HEADLESS_BUILD
+		if (this->gpu)
+		{
+			this->gpu->initPbrShaders(
+				this->assetManager.getShader("defaultEquirectangularToCubemap"),
+				this->assetManager.getShader("defaultIrradianceConvolution"),
+				this->assetManager.getShader("defaultPrefilter"),
+				this->assetManager.getShader("defaultBrdf"),
+				this->assetManager.getShader("defaultBackground")
+			);
+		}
+#endif
         
         
-        // load default hdr image
+        // load default hdr image, headless this only registers the name (as with the default textures below)
+        // so scenes referencing them load the same either way
         this->assetManager.loadInfiniteCubemap("defaultCubemap", "data/default_textures/default.hdr");
         this->assetManager.sendAllToGpu();
         
@@ -125,53 +150,88 @@ namespace vel
 		this->assetManager.sendAllToGpu();
 
 
-		//create separate thread that will poll scenes and load them into system memory asynchronously
-		std::thread t([this] {
+		// start the loader threads, each sleeps until addScene() hands it a scene to load into main memory
+		size_t loaderCount = this->config.LOADER_THREADS > 0 ? this->config.LOADER_THREADS : 1;
+		for (size_t i = 0; i < loaderCount; i++)
+			this->loaderThreads.emplace_back(&App::loaderWorker, this);
 
-			while (true)
-			{
-				std::this_thread::sleep_for(250ms);
+    }
 
-				Scene* nextScene = this->getNextSceneToLoad();
+	App::~App()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->loaderMutex);
+			this->loaderShutdown = true;
+		}
+		this->loaderCondition.notify_all();
 
-				if (nextScene != nullptr)
-				{
-					nextScene->load();
-					nextScene->mainMemoryloaded = true;
-				}
-			}
+		// a loader in the middle of Scene::load() finishes that scene first
+		for (auto& t : this->loaderThreads)
+			t.join();
+	}
 
-		});
-		t.detach();
+	void App::loaderWorker()
+	{
+		Profiler::setThreadName("Scene loader");
 
-    }
+		while (true)
+		{
+			Scene* nextScene = nullptr;
 
-	Scene* App::getNextSceneToLoad()
-	{
-		if (this->sceneLoadingQueue.size() == 0)
-			return nullptr;
+			{
+				std::unique_lock<std::mutex> lock(this->loaderMutex);
+				this->loaderCondition.wait(lock, [this] { return this->loaderShutdown || !this->scenesToLoad.empty(); });
 
-		return this->sceneLoadingQueue.at(0).get();
+				if (this->loaderShutdown)
+					return;
+
+				nextScene = this->scenesToLoad.front();
+				this->scenesToLoad.pop_front();
+			}
+
+			// the scene is owned by sceneLoadingQueue and only leaves it once fully loaded, so it
+			// stays alive for the duration of the load. Uploads for a scene that will be swapped to
+			// go ahead of those for scenes loaded in the background
+			GpuUploadScheduler::setThreadPriority(nextScene->getLoadProgress().blocking ? GpuUpload::Priority::BLOCKING : GpuUpload::Priority::BACKGROUND);
+			{
+				VEL_ZONE("Scene::load");
+				nextScene->load();
+			}
+			nextScene->setMainMemoryLoaded();
+		}
 	}
 
 	void App::forceImguiRender()
 	{
-		this->window->renderGui();
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			this->window->renderGui();
+#endif
 	}
 
 	void App::showMouseCursor()
 	{
-		this->window->showMouseCursor();
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			this->window->showMouseCursor();
+#endif
 	}
 
 	void App::hideMouseCursor()
 	{
-		this->window->hideMouseCursor();
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			this->window->hideMouseCursor();
+#endif
 	}
 
 	ImFont* App::getImguiFont(std::string key) const
 	{
-		return this->window->getImguiFont(key);
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			return this->window->getImguiFont(key);
+#endif
+		return nullptr;
 	}
 
 	void App::removeScene(std::string name)
@@ -208,53 +268,94 @@ namespace vel
 		for (auto& s : this->scenes)
 			if (s->getName() == name)
 				this->activeScene = s.get();
+
+		// still loading, swap to it once it's done and stop it's uploads waiting behind background ones
+		for (auto& s : this->sceneLoadingQueue)
+		{
+			if (s->getName() == name)
+			{
+				s->swapWhenLoaded = true;
+				s->setBlocking();
+				this->assetManager.refreshGpuPriorities();
+			}
+		}
 	}
 
     void App::addScene(Scene* scene, bool swapWhenLoaded)
     {
 		// TODO: this was required before to get imgui to work correctly, but that was when we could only ever load
 		// one scene at a time. Need to figure out how to integrate imgui into the new api
-		if(this->window->getImguiFrameOpen())
+#ifndef HEADLESS_BUILD
+		if(this->window && this->window->getImguiFrameOpen())
 			this->forceImguiRender();
+#endif
         //this->scene = std::move(std::move(std::unique_ptr<Scene>(scene)));
 
 		std::string className = typeid(*scene).name();// name is "class Test" when we need just "Test", so trim off "class "
 		className.erase(0, 6);
 		scene->setName(className);
 		scene->swapWhenLoaded = swapWhenLoaded;
+		if (swapWhenLoaded)
+			scene->setBlocking();
 		
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Adding Scene: " + className);
 #endif
 
 		this->sceneLoadingQueue.push_back(std::move(std::unique_ptr<Scene>(scene)));
+
+		{
+			std::lock_guard<std::mutex> lock(this->loaderMutex);
+			this->scenesToLoad.push_back(scene);
+		}
+		this->loaderCondition.notify_one();
     }
 
     void App::close()
     {
         this->shouldClose = true;
-        this->window->setToClose();        
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			this->window->setToClose();
+#endif
     }
 
     const double App::time() const
     {
-        std::chrono::duration<double> t = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::high_resolution_clock::now() - this->startTime);
+        std::chrono::duration<double> t = std::chrono::duration_cast<std::chrono::duration<double>>(std::chrono::steady_clock::now() - this->startTime);
         return t.count();
     }
 
     const glm::ivec2& App::getScreenSize() const
     {
-        return this->window->getScreenSize();
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			return this->window->getScreenSize();
+#endif
+        return this->headlessScreenSize;
     }
 
     const InputState& App::getInputState() const
     {
-        return this->window->getInputState();
+#ifndef HEADLESS_BUILD
+		if (this->window)
+			return this->window->getInputState();
+#endif
+        return this->headlessInputState;
     }
 
 	GPU* App::getGPU()
 	{
+#ifndef HEADLESS_BUILD
 		return this->gpu.get();
+#else
+		return nullptr;
+#endif
+	}
+
+	bool App::isHeadless() const
+	{
+		return this->config.HEADLESS;
 	}
 
 	AssetManager& App::getAssetManager()
@@ -262,6 +363,35 @@ namespace vel
 		return this->assetManager;
 	}
 
+	JobSystem& App::getJobSystem()
+	{
+		return this->jobSystem;
+	}
+
+	FramePacer& App::getFramePacer()
+	{
+		return this->framePacer;
+	}
+
+	FrameTelemetry& App::getFrameTelemetry()
+	{
+		return this->telemetry;
+	}
+
+	// t is in the same timeline as App::time()
+	void App::waitUntil(double t, bool recordStats)
+	{
+		VEL_ZONE("App::waitUntil");
+
+		double waitStart = this->time();
+		auto deadline = this->startTime + std::chrono::duration_cast<std::chrono::steady_clock::duration>(std::chrono::duration<double>(t));
+		this->framePacer.waitUntil(deadline, recordStats);
+
+		// idle waits (nothing loaded yet) aren't part of a frame
+		if (recordStats)
+			this->telemetry.recordPhase(FramePhase::WAIT, this->time() - waitStart);
+	}
+
 	float App::getFrameTime()
 	{
 		return (float)this->frameTime;
@@ -276,35 +406,39 @@ namespace vel
 	{
 		this->canDisplayAverageFrameTime = false;
 
+		this->telemetry.recordFrame(this->frameTime);
+		this->titleWindow.record(this->frameTime);
+
 		if (this->time() - this->lastFrameTimeCalculation >= 1.0)
 		{
 			this->lastFrameTimeCalculation = this->time();
 
-			double average = 0.0;
-
-			for (auto& v : this->averageFrameTimeArray)
-				average += v;
-
-			average = average / this->averageFrameTimeArray.size();
-
-			this->averageFrameTime = average;
-			this->averageFrameRate = 1000 / (average * 1000);
-
-			this->averageFrameTimeArray.clear();
+			this->averageFrameTime = this->titleWindow.getMean();
+			this->averageFrameRate = this->averageFrameTime > 0.0 ? 1.0 / this->averageFrameTime : 0.0;
 
 			this->canDisplayAverageFrameTime = true;
 		}
-
-		this->averageFrameTimeArray.push_back(this->frameTime);
 	}
 
     void App::displayAverageFrameTime()
     {
         if (this->canDisplayAverageFrameTime)
         {    
-			std::string message = "FrameTime: " + std::to_string(this->averageFrameRate) + " | FPS: " + std::to_string(this->averageFrameRate);
+			auto pacing = this->framePacer.getStats();
+			this->framePacer.resetStats();
+
+			auto window = this->titleWindow.summarize();
+			this->titleWindow.reset();
 
-			this->window->setTitle(message);
+			std::string message = "FrameTime (ms) avg: " + std::to_string(window.mean * 1000.0) + " p99: " + std::to_string(window.p99 * 1000.0) +
+				" max: " + std::to_string(window.max * 1000.0) + " | FPS: " + std::to_string(this->averageFrameRate) +
+				" | Hitches: " + std::to_string(this->telemetry.getHitchCount()) +
+				" | Pacing error (ms) avg: " + std::to_string(pacing.meanError) + " max: " + std::to_string(pacing.maxError);
+
+#ifndef HEADLESS_BUILD
+			if (this->window)
+				this->window->setTitle(message);
+#endif
         }
     }
 
@@ -318,11 +452,137 @@ namespace vel
 		this->pauseBufferClearAndSwap = in;
 	}
 
+	// scenes load concurrently so they can finish in any order, move each one which has been loaded into
+	// both main memory and gpu memory into this->scenes, and if it has swapWhenLoaded set make it the activeScene
+	void App::promoteLoadedScenes()
+	{
+		VEL_ZONE("App::promoteLoadedScenes");
+
+		for (size_t i = 0; i < this->sceneLoadingQueue.size();)
+		{
+			if (!this->sceneLoadingQueue.at(i)->isFullyLoaded())
+			{
+				i++;
+				continue;
+			}
+
+			if (this->sceneLoadingQueue.at(i)->swapWhenLoaded)
+				this->activeScene = this->sceneLoadingQueue.at(i).get();
+
+			this->scenes.push_back(std::move(this->sceneLoadingQueue.at(i)));
+			this->sceneLoadingQueue.erase(this->sceneLoadingQueue.begin() + i);
+		}
+	}
+
+	// Config::PIPELINED_SIMULATION: runs the fixed ticks which are due as a single job, the frame goes on to draw
+	// the snapshot captured just before. The scene belongs to that job until waitForSimulation(), so innerLoop()
+	// and postPhysics() must leave the GPU, Window and App's scene list alone, and the ticks see the input state
+	// as it was when they were started
+	void App::startSimulation()
+	{
+		size_t ticks = 0;
+		while (this->accumulator >= this->fixedLogicTime)
+		{
+			ticks++;
+			this->accumulator -= this->fixedLogicTime;
+		}
+
+		// alpha the scene will be drawn at next frame, once these ticks have run
+		this->simLerpInterval = (float)(this->accumulator / this->fixedLogicTime);
+
+		if (ticks == 0)
+			return;
+
+		Scene* scene = this->activeScene;
+		this->jobSystem.run([this, scene, ticks] {
+			VEL_ZONE("App::simulate");
+			for (size_t i = 0; i < ticks; i++)
+			{
+				double tickStart = this->time();
+				scene->fixedTick(this->fixedLogicTime);
+				this->simTickTimes.push_back(this->time() - tickStart);
+			}
+		}, &this->simCounter);
+	}
+
+	void App::waitForSimulation()
+	{
+		VEL_ZONE("App::waitForSimulation");
+
+		double waitStart = this->time();
+		this->jobSystem.wait(this->simCounter);
+		this->telemetry.recordPhase(FramePhase::SIM_WAIT, this->time() - waitStart);
+
+		// telemetry is main thread only, so tick times are handed over here
+		for (auto t : this->simTickTimes)
+			this->telemetry.recordTick(t);
+
+		this->simTickTimes.clear();
+	}
+
+	// only the fixed tick runs, there is nothing to render or read input from so outerLoop() and draw() are
+	// never called. With HEADLESS_REALTIME ticks are paced against the wall clock, otherwise each one starts
+	// as soon as the last has finished
+	void App::executeHeadless()
+	{
+		while (!this->shouldClose)
+		{
+			this->promoteLoadedScenes();
+
+			if (this->activeScene == nullptr)
+			{
+				this->waitUntil(this->time() + this->fixedLogicTime, false);
+				continue;
+			}
+
+			// a headless frame is a pass over any ticks which are due
+			Profiler::markFrame();
+
+			if (!this->config.HEADLESS_REALTIME)
+			{
+				double tickStart = this->time();
+				this->frameTime = this->fixedLogicTime;
+				this->activeScene->fixedTick(this->fixedLogicTime);
+				this->telemetry.recordTick(this->time() - tickStart);
+				continue;
+			}
+
+			this->newTime = this->time();
+			this->frameTime = this->newTime - this->currentTime;
+			this->currentTime = this->newTime;
+			this->telemetry.recordFrame(this->frameTime);
+
+			// prevent spiral of death
+			if (this->frameTime > 0.25)
+				this->frameTime = 0.25;
+
+			this->accumulator += this->frameTime;
+
+			while (this->accumulator >= this->fixedLogicTime)
+			{
+				double tickStart = this->time();
+				this->activeScene->fixedTick(this->fixedLogicTime);
+				this->telemetry.recordTick(this->time() - tickStart);
+				this->accumulator -= this->fixedLogicTime;
+			}
+
+			// sleep until the next tick is due
+			this->waitUntil(this->currentTime + (this->fixedLogicTime - this->accumulator));
+		}
+	}
+
     void App::execute()
     {
         this->fixedLogicTime = 1 / this->config.LOGIC_TICK;
         this->currentTime = this->time();
 
+		if (this->isHeadless())
+		{
+			this->executeHeadless();
+			return;
+		}
+
+#ifndef HEADLESS_BUILD
         while (true)
         {
 
@@ -330,31 +590,27 @@ namespace vel
 				break;
 
 
-			// load a single gpu asset for this loop cycle if needed
-			this->assetManager.sendNextToGpu();
-
-
-			if (this->sceneLoadingQueue.size() > 0)
-			{
-				// if there is a scene in the loading queue, then check whether all of it's assets have
-				// been loaded into both main memory and gpu memory and if so and it has swapWhenLoaded set
-				// then set activeScene to this scene after moving it into this->scenes, then pop it off sceneLoadingQueue
-
-				if (this->sceneLoadingQueue.at(0)->isFullyLoaded())
-				{
-					if (this->sceneLoadingQueue.at(0)->swapWhenLoaded)
-						this->activeScene = this->sceneLoadingQueue.at(0).get();
+			// send queued gpu assets within this loop cycle's budget, cut short when a frame is due sooner than that
+			double uploadStart = this->time();
+			double uploadBudget = this->config.GPU_UPLOAD_BUDGET;
+			if (this->activeScene != nullptr)
+				uploadBudget = std::max(std::min(uploadBudget, this->currentTime + (1 / this->config.MAX_RENDER_FPS) - uploadStart), 0.0);
 
-					this->scenes.push_back(std::move(this->sceneLoadingQueue.at(0)));
+			bool uploaded = this->assetManager.sendToGpu(uploadBudget, this->config.GPU_UPLOAD_BUDGET_BYTES);
+			if (uploaded)
+				this->telemetry.recordPhase(FramePhase::GPU_UPLOAD, this->time() - uploadStart);
 
-					// TODO: I believe this is necessary, but not 100%, so this COULD be a nasty runtime bug
-					this->sceneLoadingQueue.pop_front();
-				}
 
-			}
+			this->promoteLoadedScenes();
 
+			// nothing to show yet, idle for a frame's worth of time unless there are still assets to upload
 			if (this->activeScene == nullptr)
+			{
+				if (!uploaded)
+					this->waitUntil(this->time() + (1 / this->config.MAX_RENDER_FPS), false);
+
 				continue;
+			}
 
 			//        if (this->scene != nullptr && !this->scene->loaded)
 			//        {
@@ -372,6 +628,9 @@ namespace vel
 
             if (this->frameTime >= (1 / this->config.MAX_RENDER_FPS)) // cap max fps
             {
+				Profiler::markFrame();
+				VEL_ZONE("App::frame");
+
 				this->calculateAverageFrameTime();
 				this->displayAverageFrameTime();
 				
@@ -388,42 +647,29 @@ namespace vel
                 this->accumulator += this->frameTime;
 
 
+				// the scene is only ever touched by one thread at a time, so the last frame's ticks finish first
+				if (this->config.PIPELINED_SIMULATION)
+					this->waitForSimulation();
 
 
 				// update window
-				this->window->updateInputState();
-				this->window->update();
+				double phaseStart = this->time();
+				{
+					VEL_ZONE("Window::update");
+					this->window->updateInputState();
+					this->window->update();
+				}
+				this->telemetry.recordPhase(FramePhase::INPUT, this->time() - phaseStart);
 				
 				
-                // process update logic
-                while (this->accumulator >= this->fixedLogicTime)
+                // process update logic, when pipelined this happens after outer loop, alongside the draw
+                while (!this->config.PIPELINED_SIMULATION && this->accumulator >= this->fixedLogicTime)
                 {
-					//// update animations
-					//this->scene->updateAnimations(this->fixedLogicTime);
-
-					//// step physics simulation
-					this->activeScene->stepPhysics((float)this->fixedLogicTime);
-
-					// TODO: at some point we will probably want to break dynamic actors out into
-					// their own container so we're not looping over and checking static actors,
-					// which there could be many of and would never need to have their transforms
-					// updated
-					this->activeScene->applyTransformations();
-
-					// execute all contact triggers
-					this->activeScene->processSensors();
-
-					// execute inner loop (fixed rate) logic
-					this->activeScene->innerLoop((float)this->fixedLogicTime);
-
-					// update animations
-					this->activeScene->updateFixedAnimations(this->fixedLogicTime);
-
-					// step physics simulation
-					//this->activeScene->stepPhysics((float)this->fixedLogicTime);
-
-					// call postPhysics method to allow correction of any issues caused by collision solver
-					this->activeScene->postPhysics((float)this->fixedLogicTime);
+					// step physics, sync transforms, execute contact triggers, inner loop (fixed rate) logic, update
+					// animations and postPhysics, scheduled over the job system where stages and worlds allow
+					double tickStart = this->time();
+					this->activeScene->fixedTick(this->fixedLogicTime);
+					this->telemetry.recordTick(this->time() - tickStart);
                     
                     
                     // decrement accumulator
@@ -434,32 +680,68 @@ namespace vel
 				//this->activeScene->updateAnimations(this->frameTime);
 
 
-				float renderLerpInterval = (float)(this->accumulator / this->fixedLogicTime);
+				float renderLerpInterval = this->config.PIPELINED_SIMULATION ? this->simLerpInterval : (float)(this->accumulator / this->fixedLogicTime);
 
 
 				// execute outer loop (immediate) logic
-				this->activeScene->outerLoop((float)this->frameTime, renderLerpInterval);
+				phaseStart = this->time();
+				{
+					VEL_ZONE("Scene::outerLoop");
+					this->activeScene->outerLoop((float)this->frameTime, renderLerpInterval);
+				}
+				this->telemetry.recordPhase(FramePhase::OUTER_LOOP, this->time() - phaseStart);
 				
 
 				// perform draw (render) logic
+				phaseStart = this->time();
+				if (this->config.PIPELINED_SIMULATION)
+				{
+					this->activeScene->captureRenderSnapshot(this->renderSnapshot, renderLerpInterval);
+					this->startSimulation();
+				}
+
 				if (!this->pauseBufferClearAndSwap)
 				{
+					VEL_ZONE("GPU::clearBuffers");
 					//this->gpu->clearBuffers(0.2f, 0.3f, 0.3f, 1.0f);
 					this->gpu->clearBuffers(0.0f, 0.0f, 0.0f, 1.0f);
 				}
 					
 
-                this->activeScene->draw(renderLerpInterval);
+				if (this->config.PIPELINED_SIMULATION)
+					this->activeScene->drawSnapshot(this->renderSnapshot);
+				else
+					this->activeScene->draw(renderLerpInterval);
+				this->telemetry.recordPhase(FramePhase::DRAW, this->time() - phaseStart);
 
 
-				this->window->renderGui();
+				phaseStart = this->time();
+				{
+					VEL_ZONE("Window::renderGui");
+					this->window->renderGui();
+				}
+				this->telemetry.recordPhase(FramePhase::GUI, this->time() - phaseStart);
 
 
 				if (!this->pauseBufferClearAndSwap)
+				{
+					VEL_ZONE("Window::swapBuffers");
+					phaseStart = this->time();
 					this->window->swapBuffers();
+					this->telemetry.recordPhase(FramePhase::PRESENT, this->time() - phaseStart);
+				}
             }
+			// wait out the rest of the frame, unless uploads are pending in which case keep feeding them
+			else if (!uploaded)
+			{
+				this->waitUntil(this->currentTime + (1 / this->config.MAX_RENDER_FPS));
+			}
 
         }
+
+		if (this->config.PIPELINED_SIMULATION)
+			this->waitForSimulation();
+#endif
     }
 
 }
\ No newline at end of file
@@ -8,6 +8,7 @@
 #include "glm/gtx/string_cast.hpp"
 
 #include "vel/Log.h"
+#include "vel/Profiler.h"
 #include "vel/Armature.h"
 
 
@@ -89,12 +90,23 @@ namespace vel
 		{
 			//std::cout << aa.animation->name << "\n";
 			//std::cout << bone.name << "\n";
-			auto channel = &aa.animation->channels[bone.name];
+			// the animation is shared by every armature playing it, possibly on other threads, so it's channels
+			// are only ever read, and were looked up once in playAnimation()
+			TRS trs;
+			auto channel = aa.channels[index];
+			if (channel == nullptr)
+			{
+				trs.translation = glm::vec3(0.0f);
+				trs.rotation = glm::quat(1.0f, 0.0f, 0.0f, 0.0f);
+				trs.scale = glm::vec3(1.0f);
+				activeAnimationsTRS.push_back(trs);
+				continue;
+			}
+
 			auto it = std::upper_bound(channel->positionKeyTimes.begin(), channel->positionKeyTimes.end(), aa.animationKeyTime);
 			auto tmpKey = (size_t)(it - channel->positionKeyTimes.begin());
 			size_t currentKeyIndex = !(tmpKey == channel->positionKeyTimes.size()) ? (tmpKey - 1) : (tmpKey - 2);
 
-			TRS trs;
 			trs.translation = this->calcTranslation(aa.animationKeyTime, currentKeyIndex, channel);
 			trs.rotation = this->calcRotation(aa.animationKeyTime, currentKeyIndex, channel);
 			trs.scale = this->calcScale(aa.animationKeyTime, currentKeyIndex, channel);
@@ -153,6 +165,7 @@ namespace vel
 
 	void Armature::updateAnimation(double runTime)
 	{
+		VEL_ZONE("Armature::updateAnimation");
 		this->previousRunTime = this->runTime;
 		this->runTime = runTime;
 		auto stepTime = this->runTime - this->previousRunTime;
@@ -241,6 +254,14 @@ namespace vel
 		a.blendPercentage = 0.0f;
 		a.repeat = repeat;
 
+		// assimp leaves out channels of bones that aren't animated
+		a.channels.reserve(this->bones.size());
+		for (auto& b : this->bones)
+		{
+			auto it = a.animation->channels.find(b.id);
+			a.channels.push_back(it != a.animation->channels.end() ? &it->second : nullptr);
+		}
+
 		this->activeAnimations.push_back(a);
 	}
 
@@ -282,6 +303,7 @@ namespace vel
 
 	void Armature::addBone(ArmatureBone b)
 	{
+		b.id = Name::interned(b.name);
 		this->bones.push_back(b);
 	}
 
@@ -300,10 +322,10 @@ namespace vel
 		return this->bones;
 	}
 
-	ArmatureBone* Armature::getBone(std::string boneName)
+	ArmatureBone* Armature::getBone(Name boneName)
 	{
 		for (auto& b : this->bones)
-			if (b.name == boneName)
+			if (b.id == boneName)
 				return &b;
 
 		return nullptr;
@@ -326,10 +348,10 @@ namespace vel
     
     }
 
-	size_t Armature::getBoneIndex(std::string boneName)
+	size_t Armature::getBoneIndex(Name boneName)
 	{
 		for (size_t i = 0; i < this->bones.size(); i++)
-			if (this->bones.at(i).name == boneName)
+			if (this->bones[i].id == boneName)
 				return i;
         
 #ifdef DEBUG_LOG
@@ -14,6 +14,7 @@
 #include "vel/Vertex.h"
 #include "vel/functions.h"
 #include "vel/Log.h"
+#include "vel/Profiler.h"
 
 
 namespace vel
@@ -25,6 +26,7 @@ namespace vel
 		currentArmature(nullptr),
 		existingArmature(false)
 	{
+		VEL_ZONE("AssetLoaderV2::import");
 		this->impScene = this->aiImporter.ReadFile(this->currentAssetFile, aiProcess_Triangulate | aiProcess_FlipUVs | aiProcess_JoinIdenticalVertices);
 
 		if (!this->impScene || !this->impScene->mRootNode)
@@ -38,6 +40,7 @@ namespace vel
 
 	void AssetLoaderV2::load()
 	{
+		VEL_ZONE("AssetLoaderV2::load");
 		this->processNode(this->impScene->mRootNode);
 	}
 
@@ -94,14 +97,14 @@ namespace vel
 				}
 
 				// add channel to animation
-				a.channels[this->impScene->mAnimations[i]->mChannels[j]->mNodeName.C_Str()] = c;
+				a.channels[Name::interned(this->impScene->mAnimations[i]->mChannels[j]->mNodeName.C_Str())] = c;
 			}
 
 			// add animation to scene's animations container, retrieving index
-			auto aPtr = this->assetManager->addAnimation(a);
+			auto aPtr = this->assetManager->addAnimation(std::move(a));
 
 			// obtain this animation name relative to the armature
-			auto name = explode_string(a.name, '|')[1];
+			auto name = explode_string(aPtr->name, '|')[1];
 
 			// add this animation name/index to the armature's animations vector
 			this->currentArmature->addAnimation(name, aPtr);
@@ -127,7 +130,6 @@ namespace vel
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Armature, bypass reload: " + nodeName);
 #endif
-					armTracker->usageCount++;
 					this->armatureTracker = armTracker;
 					this->existingArmature = true;
 					this->currentArmature = armTracker->ptr;
@@ -236,7 +238,6 @@ namespace vel
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Mesh, bypass reload: " + mesh.getName());
 #endif
-			meshTracker->usageCount++;
 			this->meshTrackers.push_back(meshTracker);
 			return;
 		}
@@ -247,6 +248,8 @@ namespace vel
 
 		// walk through each of the mesh's vertices
 		std::vector<Vertex> vertices;
+		glm::vec3 boundsMin(0.0f);
+		glm::vec3 boundsMax(0.0f);
 		for (unsigned int i = 0; i < aiMesh->mNumVertices; i++)
 		{
 			Vertex vertex;
@@ -258,6 +261,9 @@ namespace vel
 			vector.z = aiMesh->mVertices[i].z;
 			vertex.position = vector;
 
+			boundsMin = i == 0 ? vector : glm::min(boundsMin, vector);
+			boundsMax = i == 0 ? vector : glm::max(boundsMax, vector);
+
 			// normal
 			vector.x = aiMesh->mNormals[i].x;
 			vector.y = aiMesh->mNormals[i].y;
@@ -282,7 +288,8 @@ namespace vel
 			vertices.push_back(vertex);
 		}
 
-		mesh.setVertices(vertices);
+		mesh.setVertices(std::move(vertices));
+		mesh.setBounds(boundsMin, boundsMax);
 
 
 		// now walk through each of the mesh's faces (a face is a mesh's triangle) and retrieve the corresponding vertex indices.
@@ -295,7 +302,7 @@ namespace vel
 			for (unsigned int j = 0; j < face.mNumIndices; j++)
 				indices.push_back(face.mIndices[j]);
 		}
-		mesh.setIndices(indices);
+		mesh.setIndices(std::move(indices));
 
 
 		// if mesh has bones, process bones
@@ -320,11 +327,11 @@ namespace vel
 				boneIndex++;
 			}
 		}
-		mesh.setBones(bones);
+		mesh.setBones(std::move(bones));
 
 		mesh.setGlobalInverseMatrix(this->currentGlobalInverseMatrix);
 
-		this->assetManager->addMesh(mesh);
+		this->meshTrackers.push_back(this->assetManager->addMesh(std::move(mesh)));
 	}
 
 	glm::mat4 AssetLoaderV2::aiMatrix4x4ToGlm(const aiMatrix4x4 &from)
@@ -1,94 +1,294 @@
-#include <thread> 
-#include <chrono>
+#include <mutex>
+#include <shared_mutex>
 #include <iostream>
 
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image/stb_image.h"
+#ifndef HEADLESS_BUILD
 #include "glad/glad.h"
+#else
+// image formats are recorded the same way in both builds, only the values are needed
+#define GL_RED 0x1903
+#define GL_RGB 0x1907
+#define GL_RGBA 0x1908
+#endif
 
 #include "vel/AssetManager.h"
+#include "vel/GPU.h"
 #include "vel/AssetLoaderV2.h"
 #include "vel/Log.h"
+#include "vel/Profiler.h"
 #include "vel/functions.h"
 
-using namespace std::chrono_literals;
-
 namespace vel
 {
 
 	AssetManager::AssetManager(GPU* gpu) :
-		gpu(gpu)
+		gpu(gpu),
+		gpuPrioritiesStale(false)
 	{}
 	AssetManager::~AssetManager(){}
 
 
-	void AssetManager::sendAllToGpu()
+	// sizes the upload scheduler budgets by and LoadProgress reports, approximate as they ignore padding/alignment
+	static size_t imageBytes(const ImageData& i)
 	{
-		for(auto& s : this->shadersThatNeedGpuLoad)
-		{
-			this->gpu->loadShader(s->ptr);
-			s->gpuLoaded = true;
-			this->shadersThatNeedGpuLoad.pop_front();
-		}
-		
-		for(auto& m : this->meshesThatNeedGpuLoad)
-		{
-			this->gpu->loadMesh(m->ptr);
-			m->gpuLoaded = true;
-			this->meshesThatNeedGpuLoad.pop_front();
-		}
-		
-		for(auto& t : this->texturesThatNeedGpuLoad)
-		{
-			this->gpu->loadTexture(t->ptr);
-			t->gpuLoaded = true;
-			this->texturesThatNeedGpuLoad.pop_front();
-		}
-        
-        for(auto& h : this->infiniteCubemapsThatNeedGpuLoad)
-		{
-			this->gpu->loadInfiniteCubemap(h->ptr);
-			h->gpuLoaded = true;
-			this->infiniteCubemapsThatNeedGpuLoad.pop_front();
-		}        
+		return (size_t)i.width * i.height * i.nrComponents;
 	}
 
-	void AssetManager::sendNextToGpu()
+	static size_t textureBytes(const Texture* t)
 	{
-		if (this->shadersThatNeedGpuLoad.size() > 0)
+		size_t bytes = imageBytes(t->primaryImageData);
+		for (auto& m : t->mips)
+			bytes += imageBytes(m);
+
+		return bytes;
+	}
+
+	static size_t meshBytes(Mesh* m)
+	{
+		return m->getVertices().size() * sizeof(Vertex) + m->getIndices().size() * sizeof(unsigned int);
+	}
+
+	// one step of GPU::loadInfiniteCubemapStep(), by the size of what it uploads or renders
+	static size_t infiniteCubemapStepBytes(const Cubemap* c, size_t step)
+	{
+		const size_t rgb16f = 6;
+
+		if (step == 0)
+			return imageBytes(c->primaryImageData) * sizeof(float) + 512 * 512 * 6 * rgb16f; // hdr, so float data
+
+		if (step == 1)
+			return 32 * 32 * 6 * rgb16f;
+
+		if (step < 2 + GPU::PREFILTER_MIP_LEVELS)
 		{
-			auto shaderTracker = this->shadersThatNeedGpuLoad.at(0);
-			this->gpu->loadShader(shaderTracker->ptr);
-			shaderTracker->gpuLoaded = true;
-			this->shadersThatNeedGpuLoad.pop_front();
-			return;
+			size_t size = (size_t)128 >> (step - 2);
+			return size * size * 6 * rgb16f;
 		}
 
-		if (this->meshesThatNeedGpuLoad.size() > 0)
+		return 512 * 512 * 4; // rg16f brdf lut
+	}
+
+	static size_t infiniteCubemapBytes(const Cubemap* c)
+	{
+		size_t bytes = 0;
+		for (size_t step = 0; step < GPU::INFINITE_CUBEMAP_STEPS; step++)
+			bytes += infiniteCubemapStepBytes(c, step);
+
+		return bytes;
+	}
+
+	void AssetManager::sendAllToGpu()
+	{
+		while (!this->gpuUploads.empty())
+			this->sendNextToGpu();
+	}
+
+	// sends a single upload step, returns false if nothing was uploaded. Must only be called from the main
+	// thread (the only one sending uploads, and the only thread which removes assets)
+	bool AssetManager::sendNextToGpu()
+	{
+		return this->sendToGpu(0.0, 0);
+	}
+
+	// sends queued uploads, BLOCKING before BACKGROUND, until seconds have passed or the next step would take the
+	// bytes sent over budget, returns false if nothing was uploaded. Same threading rules as sendNextToGpu()
+	bool AssetManager::sendToGpu(double seconds, size_t bytes)
+	{
+#ifdef HEADLESS_BUILD
+		return false; // nothing is ever queued without a gpu
+#else
+		if (this->gpuPrioritiesStale.exchange(false))
+			this->promoteGpuUploads();
+
+		return this->gpuUploads.run(seconds, bytes, [this](GpuUpload& u) { return this->sendGpuUploadStep(u); }) > 0;
+#endif
+	}
+
+	void AssetManager::refreshGpuPriorities()
+	{
+		this->gpuPrioritiesStale = true;
+	}
+
+	// an upload's priority is fixed by the thread that queued it, this lifts those a blocking scene is now waiting on
+	// (it was swapped to while loading, or it shares the asset with a scene loaded in the background)
+	void AssetManager::promoteGpuUploads()
+	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
+		auto waitedOn = [](auto* t) {
+			if (t == nullptr)
+				return false;
+
+			for (auto& w : t->gpuLoadWatchers)
+				if (w->blocking)
+					return true;
+
+			return false;
+		};
+
+		this->gpuUploads.promote([this, &waitedOn](const GpuUpload& u) {
+			switch (u.type)
+			{
+			case GpuUpload::Type::SHADER:			return waitedOn(this->shaderTrackers.get(u.tracker));
+			case GpuUpload::Type::MESH:				return waitedOn(this->meshTrackers.get(u.tracker));
+			case GpuUpload::Type::TEXTURE:			return waitedOn(this->textureTrackers.get(u.tracker));
+			case GpuUpload::Type::INFINITE_CUBEMAP:	return waitedOn(this->infiniteCubemapTrackers.get(u.tracker));
+			}
+
+			return false;
+		});
+	}
+
+	size_t AssetManager::getQueuedGpuBytes() const
+	{
+		return this->gpuUploads.getQueuedBytes();
+	}
+
+	size_t AssetManager::getQueuedGpuBytes(GpuUpload::Priority p) const
+	{
+		return this->gpuUploads.getQueuedBytes(p);
+	}
+
+	// called with registryMutex held exclusively, the upload takes the priority of the scene being loaded on this thread
+	void AssetManager::queueGpuUpload(GpuUpload::Type type, sac_handle tracker, size_t firstStepBytes, size_t totalBytes)
+	{
+		GpuUpload u;
+		u.type = type;
+		u.tracker = tracker;
+		u.priority = GpuUploadScheduler::getThreadPriority();
+		u.stepBytes = firstStepBytes;
+		u.remainingBytes = totalBytes;
+		this->gpuUploads.push(u);
+	}
+
+	GpuUpload::Step AssetManager::sendGpuUploadStep(GpuUpload& u)
+	{
+#ifdef HEADLESS_BUILD
+		return GpuUpload::Step::MISSING;
+#else
+		VEL_ZONE("AssetManager::sendNextToGpu");
+
+		// the registry is only locked to find the tracker and to mark it loaded, never across the gpu work, so
+		// loader threads aren't held up by an upload. Assets are only removed on this thread, so the tracker
+		// stays valid in between, and gpuSteps (only read when removing) needs no lock
+		auto find = [this](auto& trackers, sac_handle h) {
+			std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+			return trackers.get(h);
+		};
+
+		auto loaded = [this](auto* t, size_t bytes) {
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+			t->gpuLoaded = true;
+			this->notifyGpuLoadWatchers(t->gpuLoadWatchers, bytes);
+		};
+
+		switch (u.type)
 		{
-			auto meshTracker = this->meshesThatNeedGpuLoad.at(0);
-			this->gpu->loadMesh(meshTracker->ptr);
-			meshTracker->gpuLoaded = true;
-			this->meshesThatNeedGpuLoad.pop_front();
-			return;
+		case GpuUpload::Type::SHADER:
+			if (auto t = find(this->shaderTrackers, u.tracker))
+			{
+				this->gpu->loadShader(t->ptr);
+				loaded(t, 0);
+				return GpuUpload::Step::DONE;
+			}
+			break;
+
+		case GpuUpload::Type::MESH:
+			if (auto t = find(this->meshTrackers, u.tracker))
+			{
+				this->gpu->loadMesh(t->ptr);
+				loaded(t, meshBytes(t->ptr));
+				return GpuUpload::Step::DONE;
+			}
+			break;
+
+		case GpuUpload::Type::TEXTURE:
+			// one mip level per step, the base level first, so a large texture is spread over several calls
+			if (auto t = find(this->textureTrackers, u.tracker))
+			{
+				this->gpu->loadTextureLevel(t->ptr, u.step);
+				t->gpuSteps++;
+
+				if (u.step < t->ptr->mips.size())
+				{
+					u.remainingBytes -= u.stepBytes;
+					u.step++;
+					u.stepBytes = imageBytes(t->ptr->mips.at(u.step - 1));
+					return GpuUpload::Step::MORE;
+				}
+
+				loaded(t, textureBytes(t->ptr));
+				return GpuUpload::Step::DONE;
+			}
+			break;
+
+		case GpuUpload::Type::INFINITE_CUBEMAP:
+			// the ibl precompute is spread over several calls too, see GPU::loadInfiniteCubemapStep()
+			if (auto t = find(this->infiniteCubemapTrackers, u.tracker))
+			{
+				this->gpu->loadInfiniteCubemapStep(t->ptr, u.step);
+				t->gpuSteps++;
+
+				if (u.step + 1 < GPU::INFINITE_CUBEMAP_STEPS)
+				{
+					u.remainingBytes -= u.stepBytes;
+					u.step++;
+					u.stepBytes = infiniteCubemapStepBytes(t->ptr, u.step);
+					return GpuUpload::Step::MORE;
+				}
+
+				loaded(t, infiniteCubemapBytes(t->ptr));
+				return GpuUpload::Step::DONE;
+			}
+			break;
 		}
 
-		if (this->texturesThatNeedGpuLoad.size() > 0)
+		// asset was removed before it was uploaded
+		return GpuUpload::Step::MISSING;
+#endif
+	}
+
+	void AssetManager::notifyGpuLoadWatchers(std::vector<std::shared_ptr<LoadProgress>>& watchers, size_t bytes)
+	{
+		for (auto& w : watchers)
 		{
-			auto textureTracker = this->texturesThatNeedGpuLoad.at(0);
-			this->gpu->loadTexture(textureTracker->ptr);
-			textureTracker->gpuLoaded = true;
-			this->texturesThatNeedGpuLoad.pop_front();
-			return;
+			w->bytesUploaded += bytes;
+			w->gpuAssetsUploaded++;
 		}
-        
-        if (this->infiniteCubemapsThatNeedGpuLoad.size() > 0)
+
+		watchers.clear();
+	}
+
+	// registers progress to be counted once the named asset reaches the gpu, if it already has it is
+	// counted right away. The asset must already have been loaded (sac::get() exits otherwise)
+	void AssetManager::watchGpuLoad(GpuUpload::Type type, Name name, std::shared_ptr<LoadProgress> progress)
+	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+		auto watch = [&](auto* tracker) {
+			progress->gpuAssetsRequested++;
+
+			if (tracker->gpuLoaded)
+			{
+				progress->gpuAssetsUploaded++;
+				return;
+			}
+
+			// the upload may have been queued by a scene loading in the background
+			if (progress->blocking)
+				this->gpuPrioritiesStale = true;
+
+			tracker->gpuLoadWatchers.push_back(progress);
+		};
+
+		switch (type)
 		{
-			auto hdrTracker = this->infiniteCubemapsThatNeedGpuLoad.at(0);
-			this->gpu->loadInfiniteCubemap(hdrTracker->ptr);
-			hdrTracker->gpuLoaded = true;
-			this->infiniteCubemapsThatNeedGpuLoad.pop_front();
-			return;
+		case GpuUpload::Type::SHADER:			watch(this->shaderTrackers.get(name)); break;
+		case GpuUpload::Type::MESH:				watch(this->meshTrackers.get(name)); break;
+		case GpuUpload::Type::TEXTURE:			watch(this->textureTrackers.get(name)); break;
+		case GpuUpload::Type::INFINITE_CUBEMAP:	watch(this->infiniteCubemapTrackers.get(name)); break;
 		}
 	}
 
@@ -96,29 +296,17 @@ namespace vel
 	--------------------------------------------------*/
 	std::string AssetManager::loadShader(std::string name, std::string vertFile, std::string fragFile)
 	{
+		// shaders are only compiled once they reach the gpu, so there is nothing expensive to do here
+		// and the whole load can happen under the registry lock
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 		if (this->shaderTrackers.exists(name))
 		{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Shader, bypass reload: " + name);
 #endif
-			
-			// if usage count is not greater than zero then the asset is being deleted on the main thread
-			// so we will need to re-create it. This could still potentially be a race condition, although
-			// I would think it would be unlikely, putting a TODO here until we thoroughly test some 
-			// real world use cases to verify
-			if(this->shaderTrackers.get(name)->usageCount > 0)
-			{
-				this->shaderTrackers.get(name)->usageCount++;
-				return name;
-			}
-			// if name exists in map, AND usage count IS EQUAL TO 0, then we must have called this method
-			// from a thread other than the main thread. Therefore, let us poll until the name no longer 
-			// exists within the map so we do not recreate the asset while it's being deleted
-			else
-			{
-				std::this_thread::sleep_for(100ms);
-				return this->loadShader(name, vertFile, fragFile);
-			}			
+			this->shaderTrackers.get(name)->usageCount++;
+			return name;
 		}
 		
 #ifdef DEBUG_LOG
@@ -130,19 +318,26 @@ namespace vel
 		s.vertFile = vertFile;
 		s.fragFile = fragFile;
 
-		auto shaderPtr = this->shaders.insert(name, s);
+		Name shaderName = Name::interned(name);
+		auto shaderPtr = this->shaders.insert(shaderName, std::move(s));
 		
 		ShaderTracker t;
 		t.ptr = shaderPtr;
 		t.usageCount++;
+		t.gpuLoaded = this->gpu == nullptr; // headless there is no upload to wait for, same for every asset below
 	
-		this->shadersThatNeedGpuLoad.push_back(this->shaderTrackers.insert(name, t));
+		sac_handle trackerHandle;
+		this->shaderTrackers.insert(shaderName, t, &trackerHandle);
+		if (this->gpu != nullptr)
+			this->queueGpuUpload(GpuUpload::Type::SHADER, trackerHandle, 0, 0);
 
 		return name;
 	}
 
-	Shader* AssetManager::getShader(std::string name)
+	Shader* AssetManager::getShader(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 if (!this->shaderTrackers.exists(name))
     Log::crash("AssetManager::getShader(): Attempting to get shader that does not exist: " + name);
@@ -151,8 +346,10 @@ if (!this->shaderTrackers.exists(name))
 		return this->shaderTrackers.get(name)->ptr;
 	}
 
-	bool AssetManager::shaderIsGpuLoaded(std::string name)
+	bool AssetManager::shaderIsGpuLoaded(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->shaderTrackers.exists(name))
 		Log::crash("AssetManager::shaderIsGpuLoaded(): Attempting to get shader that does not exist: " + name);
@@ -163,6 +360,8 @@ if (!this->shaderTrackers.exists(name))
 
 	void AssetManager::removeShader(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 if (!this->shaderTrackers.exists(name))
     Log::crash("AssetManager::removeShader(): Attempting to remove shader that does not exist: " + name);
@@ -177,12 +376,11 @@ if (!this->shaderTrackers.exists(name))
 	Log::toCliAndFile("Full remove Shader: " + name);
 #endif	
 			
-			if (!t->gpuLoaded)
-				for (size_t i = 0; i < this->shadersThatNeedGpuLoad.size(); i++)
-					if (this->shadersThatNeedGpuLoad.at(i) == t)
-						this->shadersThatNeedGpuLoad.erase(this->shadersThatNeedGpuLoad.begin() + i);
-			else
+			// if it has not been uploaded yet, it's entry in gpuUploads goes stale once the tracker is erased
+#ifndef HEADLESS_BUILD
+			if (t->gpuLoaded && this->gpu != nullptr)
 				this->gpu->clearShader(t->ptr);
+#endif
 			
 			this->shaders.erase(name);
 			this->shaderTrackers.erase(name);
@@ -198,60 +396,106 @@ if (!this->shaderTrackers.exists(name))
 	--------------------------------------------------*/
 	std::pair<std::vector<std::string>, std::string> AssetManager::loadMesh(std::string path)
 	{
+		std::shared_ptr<InFlightLoad<std::pair<std::vector<std::string>, std::string>>> load;
+		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+			// another thread is already importing this file, wait for it rather than importing it twice. The
+			// importing thread takes references to every mesh/armature in the file on our behalf
+			auto it = this->meshFilesInFlight.find(path);
+			if (it != this->meshFilesInFlight.end())
+			{
+				it->second->waiters++;
+				auto ready = it->second->ready;
+				lock.unlock();
+				return ready.get();
+			}
+
+			load = std::make_shared<InFlightLoad<std::pair<std::vector<std::string>, std::string>>>();
+			this->meshFilesInFlight[path] = load;
+		}
+
 		auto al = AssetLoaderV2(this, path);
 		al.load();
 
 		std::pair<std::vector<std::string>, std::string> out;
 		auto trackers = al.getTrackers();
 
-		for (auto& mt : trackers.first)
-			out.first.push_back(mt->ptr->getName());
+		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
 
-		out.second = trackers.second == nullptr ? "" : trackers.second->ptr->getName();
+			for (auto& mt : trackers.first)
+			{
+				mt->usageCount += load->waiters;
+				out.first.push_back(mt->ptr->getName());
+			}
+
+			if (trackers.second != nullptr)
+				trackers.second->usageCount += load->waiters;
+
+			out.second = trackers.second == nullptr ? "" : trackers.second->ptr->getName();
+
+			this->meshFilesInFlight.erase(path);
+		}
+
+		load->promise.set_value(out);
 
 		return out;
 	}
 
 	MeshTracker* AssetManager::addMesh(Mesh m)
 	{
-		// AssetLoader checks for existing mesh by name, therefore if we have
-		// made it this far, assume that m is a new Mesh
-		
-		auto meshPtr = this->meshes.insert(m.getName(), m);
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+		Name meshName = Name::interned(m.getName());
+
+		// AssetLoader checks for an existing mesh by name before importing it, but another file containing
+		// a mesh of the same name could have been imported by another thread in the meantime
+		if (this->meshTrackers.exists(meshName))
+		{
+			auto t = this->meshTrackers.get(meshName);
+			t->usageCount++;
+			return t;
+		}
+
+		auto meshPtr = this->meshes.insert(meshName, std::move(m));
 		
 		MeshTracker t;
 		t.ptr = meshPtr;
 		t.usageCount++;
+		t.gpuLoaded = this->gpu == nullptr;
 		
-		auto meshTrackerPtr = this->meshTrackers.insert(m.getName(), t);
+		sac_handle trackerHandle;
+		auto meshTrackerPtr = this->meshTrackers.insert(meshName, t, &trackerHandle);
 
-		this->meshesThatNeedGpuLoad.push_back(meshTrackerPtr);
+		if (this->gpu != nullptr)
+		{
+			size_t bytes = meshBytes(meshPtr);
+			this->queueGpuUpload(GpuUpload::Type::MESH, trackerHandle, bytes, bytes);
+		}
 
 		return meshTrackerPtr;
 	}
 
+	// returns the tracker of an existing mesh with a reference already taken for the caller, or nullptr
 	MeshTracker* AssetManager::getMeshTracker(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 		if(this->meshTrackers.exists(name))
 		{
 			auto t = this->meshTrackers.get(name);
-			if(t->usageCount > 0)
-			{
-				t->usageCount++;
-				return t;
-			}
-			else
-			{
-				std::this_thread::sleep_for(100ms); //tf? Guessing I did this as some form of ghetto thread-safety?
-				return this->getMeshTracker(name);
-			}
+			t->usageCount++;
+			return t;
 		}
 		
 		return nullptr;
 	}
 
-	Mesh* AssetManager::getMesh(std::string name)
+	Mesh* AssetManager::getMesh(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 if (!this->meshTrackers.exists(name))
     Log::crash("AssetManager::getMesh(): Attempting to get mesh that does not exist: " + name);
@@ -259,13 +503,17 @@ if (!this->meshTrackers.exists(name))
 		return this->meshTrackers.get(name)->ptr;	
 	}
 
-	bool AssetManager::meshIsGpuLoaded(std::string name)
+	bool AssetManager::meshIsGpuLoaded(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 		return this->meshTrackers.get(name)->gpuLoaded;
 	}
 	
 	void AssetManager::removeMesh(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->meshTrackers.exists(name))
 		Log::crash("AssetManager::removeMesh(): Attempting to remove mesh that does not exist: " + name);
@@ -278,12 +526,10 @@ if (!this->meshTrackers.exists(name))
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Full remove Mesh: " + name);
 #endif
-			if(!t->gpuLoaded)
-				for (size_t i = 0; i < this->meshesThatNeedGpuLoad.size(); i++)
-					if (this->meshesThatNeedGpuLoad.at(i) == t)
-						this->meshesThatNeedGpuLoad.erase(this->meshesThatNeedGpuLoad.begin() + i);
-			else
+#ifndef HEADLESS_BUILD
+			if (t->gpuLoaded && this->gpu != nullptr)
 				this->gpu->clearMesh(t->ptr);
+#endif
 			
 			this->meshes.erase(name);
 			this->meshTrackers.erase(name);
@@ -299,22 +545,33 @@ if (!this->meshTrackers.exists(name))
 	--------------------------------------------------*/
 	std::string AssetManager::loadTexture(std::string name, std::string type, std::string path, std::vector<std::string> mips)
 	{	
-		if (this->textureTrackers.exists(name))
+		std::shared_ptr<InFlightLoad<void>> load;
 		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+			if (this->textureTrackers.exists(name))
+			{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Texture, bypass reload: " + name);
 #endif
-			auto t = this->textureTrackers.get(name);
-			if(t->usageCount > 0)
-			{
-				t->usageCount++;
+				this->textureTrackers.get(name)->usageCount++;
 				return name;
 			}
-			else
+
+			// another thread is decoding this texture, wait on it's decode instead of starting our own, the
+			// decoding thread takes our reference when it publishes the texture
+			auto it = this->texturesInFlight.find(name);
+			if (it != this->texturesInFlight.end())
 			{
-				std::this_thread::sleep_for(100ms);
-				return this->loadTexture(name, type, path, mips);
-			}			
+				it->second->waiters++;
+				auto ready = it->second->ready;
+				lock.unlock();
+				ready.wait();
+				return name;
+			}
+
+			load = std::make_shared<InFlightLoad<void>>();
+			this->texturesInFlight[name] = load;
 		}
 
 #ifdef DEBUG_LOG
@@ -324,77 +581,96 @@ if (!this->meshTrackers.exists(name))
 		Texture texture;
 		texture.name = name;
 		texture.type = type;
-		texture.primaryImageData.data = stbi_load(
-			path.c_str(), 
-			&texture.primaryImageData.width, 
-			&texture.primaryImageData.height, 
-			&texture.primaryImageData.nrComponents, 
-			0
-		);
-
-#ifdef DEBUG_LOG
-	if (!texture.primaryImageData.data)
-		Log::crash("AssetManager::loadTexture(): Unable to load texture at path: " + path);
-	if (texture.primaryImageData.width != texture.primaryImageData.height)
-		Log::crash("AssetManager::loadTexture(): Texture not square: " + name);
-	if (!isPowerOfTwo(texture.primaryImageData.width))
-		Log::crash("AssetManager::loadTexture(): Texture not power of two: " + name);
-#endif
-
-        if (texture.primaryImageData.nrComponents == 1)
-        {
-            texture.alphaChannel = false;
-            texture.primaryImageData.format = GL_RED;
-        }
-        else if (texture.primaryImageData.nrComponents == 3)
-        {
-            texture.alphaChannel = false;
-            texture.primaryImageData.format = GL_RGB;
-        }
-        else if (texture.primaryImageData.nrComponents == 4)
-        {
-            texture.alphaChannel = true;
-            texture.primaryImageData.format = GL_RGBA;
-        }
-
-        for (auto& m : mips)
-        {
-			//Log::toCliAndFile("mip:" + m);
-            ImageData id;
-            id.data = stbi_load(m.c_str(), &id.width, &id.height, &id.nrComponents, 0);
-
-#ifdef DEBUG_LOG
-	if (!id.data)
-		Log::crash("AssetManager::loadTexture(): Unable to load texture at path: " + m);
-#endif
-
-            if (id.nrComponents == 1)
-                id.format = GL_RED;
-            else if (id.nrComponents == 3)
-                id.format = GL_RGB;
-            else if (id.nrComponents == 4)
-                id.format = GL_RGBA;
-
-            texture.mips.push_back(id);
+
+		// headless nothing ever samples the image data, only the name and type are registered
+		if (this->gpu != nullptr)
+		{
+			texture.primaryImageData.data = stbi_load(
+				path.c_str(), 
+				&texture.primaryImageData.width, 
+				&texture.primaryImageData.height, 
+				&texture.primaryImageData.nrComponents, 
+				0
+			);
+
+#ifdef DEBUG_LOG
+		if (!texture.primaryImageData.data)
+			Log::crash("AssetManager::loadTexture(): Unable to load texture at path: " + path);
+		if (texture.primaryImageData.width != texture.primaryImageData.height)
+			Log::crash("AssetManager::loadTexture(): Texture not square: " + name);
+		if (!isPowerOfTwo(texture.primaryImageData.width))
+			Log::crash("AssetManager::loadTexture(): Texture not power of two: " + name);
+#endif
+
+	        if (texture.primaryImageData.nrComponents == 1)
+	        {
+	            texture.alphaChannel = false;
+	            texture.primaryImageData.format = GL_RED;
+	        }
+	        else if (texture.primaryImageData.nrComponents == 3)
+	        {
+	            texture.alphaChannel = false;
+	            texture.primaryImageData.format = GL_RGB;
+	        }
+	        else if (texture.primaryImageData.nrComponents == 4)
+	        {
+	            texture.alphaChannel = true;
+	            texture.primaryImageData.format = GL_RGBA;
+	        }
+
+	        for (auto& m : mips)
+	        {
+				//Log::toCliAndFile("mip:" + m);
+	            ImageData id;
+	            id.data = stbi_load(m.c_str(), &id.width, &id.height, &id.nrComponents, 0);
+
+#ifdef DEBUG_LOG
+		if (!id.data)
+			Log::crash("AssetManager::loadTexture(): Unable to load texture at path: " + m);
+#endif
+
+	            if (id.nrComponents == 1)
+	                id.format = GL_RED;
+	            else if (id.nrComponents == 3)
+	                id.format = GL_RGB;
+	            else if (id.nrComponents == 4)
+	                id.format = GL_RGBA;
+
+	            texture.mips.push_back(id);
             
-        }
-		
+	        }
+		}
 
 		/////////////////////////////////////////
 
-		auto texturePtr = this->textures.insert(texture.name, texture);
+		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+			Name textureName = Name::interned(texture.name);
+			auto texturePtr = this->textures.insert(textureName, std::move(texture));
 		
-		TextureTracker t;
-		t.ptr = texturePtr;
-		t.usageCount++;
+			TextureTracker t;
+			t.ptr = texturePtr;
+			t.usageCount = 1 + load->waiters;
+			t.gpuLoaded = this->gpu == nullptr;
+
+			sac_handle trackerHandle;
+			this->textureTrackers.insert(textureName, t, &trackerHandle);
+			if (this->gpu != nullptr)
+				this->queueGpuUpload(GpuUpload::Type::TEXTURE, trackerHandle, imageBytes(texturePtr->primaryImageData), textureBytes(texturePtr));
+
+			this->texturesInFlight.erase(textureName);
+		}
 
-		this->texturesThatNeedGpuLoad.push_back(this->textureTrackers.insert(texture.name, t));
+		load->promise.set_value();
 
 		return name;
 	}
 
-	Texture* AssetManager::getTexture(std::string name)
+	Texture* AssetManager::getTexture(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->textureTrackers.exists(name))
 		Log::crash("AssetManager::getTexture(): Attempting to get texture that does not exist: " + name);
@@ -403,13 +679,17 @@ if (!this->meshTrackers.exists(name))
 		return this->textureTrackers.get(name)->ptr;		
 	}
 
-	bool AssetManager::textureIsGpuLoaded(std::string name)
+	bool AssetManager::textureIsGpuLoaded(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 		return this->textureTrackers.get(name)->gpuLoaded;
 	}
 	
 	void AssetManager::removeTexture(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->textureTrackers.exists(name))
 		Log::crash("AssetManager::removeTexture(): Attempting to remove texture that does not exist: " + name);
@@ -422,12 +702,18 @@ if (!this->meshTrackers.exists(name))
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Full remove Texture: " + name);
 #endif
-			if (!t->gpuLoaded)
-				for (size_t i = 0; i < this->texturesThatNeedGpuLoad.size(); i++)
-					if (this->texturesThatNeedGpuLoad.at(i) == t)
-						this->texturesThatNeedGpuLoad.erase(this->texturesThatNeedGpuLoad.begin() + i);
-			else
-				this->gpu->clearTexture(t->ptr);
+#ifndef HEADLESS_BUILD
+			// an upload cut short has already created the texture, and the levels it didn't reach still hold their
+			// image data (all of it if the upload never started)
+			if (this->gpu != nullptr)
+			{
+				if (t->gpuSteps > 0)
+					this->gpu->clearTexture(t->ptr);
+
+				if (!t->gpuLoaded)
+					this->gpu->freeTextureLevels(t->ptr, t->gpuSteps);
+			}
+#endif
 			
 			this->textures.erase(name);
 			this->textureTrackers.erase(name);
@@ -442,22 +728,31 @@ if (!this->meshTrackers.exists(name))
 	--------------------------------------------------*/
     std::string AssetManager::loadInfiniteCubemap(std::string name, std::string path)
     {
-        if (this->infiniteCubemapTrackers.exists(name))
+		std::shared_ptr<InFlightLoad<void>> load;
 		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+			if (this->infiniteCubemapTrackers.exists(name))
+			{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Cubemap, bypass reload: " + name);
 #endif
-			auto h = this->infiniteCubemapTrackers.get(name);
-			if(h->usageCount > 0)
-			{
-				h->usageCount++;
+				this->infiniteCubemapTrackers.get(name)->usageCount++;
 				return name;
 			}
-			else
+
+			auto it = this->infiniteCubemapsInFlight.find(name);
+			if (it != this->infiniteCubemapsInFlight.end())
 			{
-				std::this_thread::sleep_for(100ms);
-				return this->loadInfiniteCubemap(name, path);
-			}			
+				it->second->waiters++;
+				auto ready = it->second->ready;
+				lock.unlock();
+				ready.wait();
+				return name;
+			}
+
+			load = std::make_shared<InFlightLoad<void>>();
+			this->infiniteCubemapsInFlight[name] = load;
 		}
         
 #ifdef DEBUG_LOG
@@ -466,43 +761,64 @@ if (!this->meshTrackers.exists(name))
 
         Cubemap hdr;
         hdr.name = name;
-        stbi_set_flip_vertically_on_load(true);
-        hdr.primaryImageData.dataf = stbi_loadf(
-			path.c_str(), 
-			&hdr.primaryImageData.width, 
-			&hdr.primaryImageData.height, 
-			&hdr.primaryImageData.nrComponents, 
-			0
-		);
-		stbi_set_flip_vertically_on_load(false);
+
+		if (this->gpu != nullptr) // headless, only the name is registered as with textures
+		{
+	        // thread local flag, textures may be decoding on other threads at the same time
+	        stbi_set_flip_vertically_on_load_thread(true);
+	        hdr.primaryImageData.dataf = stbi_loadf(
+				path.c_str(), 
+				&hdr.primaryImageData.width, 
+				&hdr.primaryImageData.height, 
+				&hdr.primaryImageData.nrComponents, 
+				0
+			);
+			stbi_set_flip_vertically_on_load_thread(false);
         
         
 #ifdef DEBUG_LOG
-	if (!hdr.primaryImageData.dataf)
-		Log::crash("AssetManager::loadInfiniteCubemap(): Unable to load hdr at path: " + path);
+		if (!hdr.primaryImageData.dataf)
+			Log::crash("AssetManager::loadInfiniteCubemap(): Unable to load hdr at path: " + path);
 #endif
 
-        if (hdr.primaryImageData.nrComponents == 1)
-            hdr.primaryImageData.format = GL_RED;
-        else if (hdr.primaryImageData.nrComponents == 3)
-            hdr.primaryImageData.format = GL_RGB;
-        else if (hdr.primaryImageData.nrComponents == 4)
-            hdr.primaryImageData.format = GL_RGBA;
-        
-        
-        auto hdrPtr = this->infiniteCubemaps.insert(hdr.name, hdr);
+	        if (hdr.primaryImageData.nrComponents == 1)
+	            hdr.primaryImageData.format = GL_RED;
+	        else if (hdr.primaryImageData.nrComponents == 3)
+	            hdr.primaryImageData.format = GL_RGB;
+	        else if (hdr.primaryImageData.nrComponents == 4)
+	            hdr.primaryImageData.format = GL_RGBA;
+		}
+
+		{
+			std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+			Name hdrName = Name::interned(hdr.name);
+			auto hdrPtr = this->infiniteCubemaps.insert(hdrName, std::move(hdr));
         
-        InfiniteCubemapTracker t;
-        t.ptr = hdrPtr;
-		t.usageCount++;
+			InfiniteCubemapTracker t;
+			t.ptr = hdrPtr;
+			t.usageCount = 1 + load->waiters;
+			t.gpuLoaded = this->gpu == nullptr;
         
-		this->infiniteCubemapsThatNeedGpuLoad.push_back(this->infiniteCubemapTrackers.insert(hdr.name, t));
+			sac_handle trackerHandle;
+			this->infiniteCubemapTrackers.insert(hdrName, t, &trackerHandle);
+			if (this->gpu != nullptr)
+			{
+				this->queueGpuUpload(GpuUpload::Type::INFINITE_CUBEMAP, trackerHandle, infiniteCubemapStepBytes(hdrPtr, 0), infiniteCubemapBytes(hdrPtr));
+			}
+
+			this->infiniteCubemapsInFlight.erase(hdrName);
+		}
+
+		load->promise.set_value();
 
 		return name;
     }
     
-    Cubemap* AssetManager::getInfiniteCubemap(std::string name)
+    Cubemap* AssetManager::getInfiniteCubemap(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->infiniteCubemapTrackers.exists(name))
 		Log::crash("AssetManager::getInfiniteCubemap(): Attempting to get Cubemap that does not exist: " + name);
@@ -511,13 +827,17 @@ if (!this->meshTrackers.exists(name))
 		return this->infiniteCubemapTrackers.get(name)->ptr;		
 	}
 
-	bool AssetManager::infiniteCubemapIsGpuLoaded(std::string name)
+	bool AssetManager::infiniteCubemapIsGpuLoaded(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 		return this->infiniteCubemapTrackers.get(name)->gpuLoaded;
 	}
     
     void AssetManager::removeInfiniteCubemap(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->infiniteCubemapTrackers.exists(name))
 		Log::crash("AssetManager::removeInfiniteCubemap(): Attempting to remove Cubemap that does not exist: " + name);
@@ -530,12 +850,17 @@ if (!this->meshTrackers.exists(name))
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Full remove Cubemap: " + name);
 #endif
-			if (!h->gpuLoaded)
-				for (size_t i = 0; i < this->infiniteCubemapsThatNeedGpuLoad.size(); i++)
-					if (this->infiniteCubemapsThatNeedGpuLoad.at(i) == h)
-						this->infiniteCubemapsThatNeedGpuLoad.erase(this->infiniteCubemapsThatNeedGpuLoad.begin() + i);
-			else
-				this->gpu->clearInfiniteCubemap(h->ptr);
+#ifndef HEADLESS_BUILD
+			// the ids of whatever an upload cut short never created are still 0, which glDeleteTextures ignores.
+			// The hdr data is freed by the first step
+			if (this->gpu != nullptr)
+			{
+				if (h->gpuSteps > 0)
+					this->gpu->clearInfiniteCubemap(h->ptr);
+				else
+					this->gpu->freeInfiniteCubemapData(h->ptr);
+			}
+#endif
 			
 			this->infiniteCubemaps.erase(name);
 			this->infiniteCubemapTrackers.erase(name);
@@ -551,22 +876,15 @@ if (!this->meshTrackers.exists(name))
 	--------------------------------------------------*/
 	std::string AssetManager::addMaterial(Material m)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 		if (this->materialTrackers.exists(m.name))
 		{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Material, bypass reload: " + m.name);
 #endif
-			auto t = this->materialTrackers.get(m.name);
-			if(t->usageCount > 0)
-			{
-				t->usageCount++;
-				return m.name;
-			}
-			else
-			{
-				std::this_thread::sleep_for(100ms);
-				return this->addMaterial(m);
-			}			
+			this->materialTrackers.get(m.name)->usageCount++;
+			return m.name;
 		}
 
 #ifdef DEBUG_LOG
@@ -609,19 +927,22 @@ if (!this->meshTrackers.exists(name))
         //    m.ao = this->getTexture("defaultAO");
         
 
-		auto materialPtr = this->materials.insert(m.name, m);
+		Name materialName = Name::interned(m.name);
+		auto materialPtr = this->materials.insert(materialName, std::move(m));
 		
 		MaterialTracker t;
 		t.ptr = materialPtr;
 		t.usageCount++;
 
-		this->materialTrackers.insert(m.name, t);
+		this->materialTrackers.insert(materialName, t);
 
-		return m.name;
+		return materialPtr->name;
 	}
 
-	Material* AssetManager::getMaterial(std::string name)
+	Material* AssetManager::getMaterial(Name name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->materialTrackers.exists(name))
 		Log::crash("AssetManager::getMaterial(): Attempting to get material that does not exist: " + name);
@@ -632,6 +953,8 @@ if (!this->meshTrackers.exists(name))
 	
 	void AssetManager::removeMaterial(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->materialTrackers.exists(name))
 		Log::crash("AssetManager::removeMaterial(): Attempting to remove material that does not exist: " + name);
@@ -657,48 +980,47 @@ if (!this->meshTrackers.exists(name))
 	--------------------------------------------------*/	
 	Animation* AssetManager::addAnimation(Animation a)
 	{
-		return this->animations.insert(a.name, a);
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+		Name animationName = Name::interned(a.name);
+		return this->animations.insert(animationName, std::move(a));
 	}
 
 	/* Renderables
 	--------------------------------------------------*/
 	std::string AssetManager::addRenderable(std::string name, Shader* shader, Mesh* mesh, Material* material)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 		if (this->renderableTrackers.exists(name))
 		{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Existing Renderable, bypass reload: " + name);
 #endif
-			auto t = this->renderableTrackers.get(name);
-			if(t->usageCount > 0)
-			{
-				t->usageCount++;
-				return name;
-			}
-			else
-			{
-				std::this_thread::sleep_for(100ms);
-				return this->addRenderable(name, shader, mesh, material);
-			}			
+			this->renderableTrackers.get(name)->usageCount++;
+			return name;
 		}
 
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Loading new Renderable: " + name);
 #endif	
 
-		auto renderablePtr = this->renderables.insert(name, Renderable(name, shader, mesh, material));
+		Name renderableName = Name::interned(name);
+		auto renderablePtr = this->renderables.emplace(renderableName, name, shader, mesh, material);
 		
 		RenderableTracker t;
 		t.ptr = renderablePtr;
 		t.usageCount++;
 		
-		this->renderableTrackers.insert(name, t);
+		this->renderableTrackers.insert(renderableName, t);
 
 		return name;
 	}
 
 	Renderable AssetManager::getRenderable(std::string name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->renderableTrackers.exists(name))
 		Log::crash("AssetManager::getRenderable(): Attempting to get renderable that does not exist: " + name);
@@ -709,6 +1031,8 @@ if (!this->meshTrackers.exists(name))
 	
 	void AssetManager::removeRenderable(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->renderableTrackers.exists(name))
 		Log::crash("AssetManager::removeRenderable(): Attempting to remove renderable that does not exist: " + name);
@@ -732,21 +1056,16 @@ if (!this->meshTrackers.exists(name))
 
 	/* Armatures
 	--------------------------------------------------*/
+	// returns the tracker of an existing armature with a reference already taken for the caller, or nullptr
 	ArmatureTracker* AssetManager::getArmatureTracker(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 		if(this->armatureTrackers.exists(name))
 		{
 			auto t = this->armatureTrackers.get(name);
-			if(t->usageCount > 0)
-			{
-				t->usageCount++;
-				return t;
-			}
-			else
-			{
-				std::this_thread::sleep_for(100ms);
-				return this->getArmatureTracker(name);
-			}
+			t->usageCount++;
+			return t;
 		}
 		
 		return nullptr;
@@ -754,17 +1073,22 @@ if (!this->meshTrackers.exists(name))
 	
 	ArmatureTracker* AssetManager::addArmature(Armature a)
 	{
-		auto armaturePtr = this->armatures.insert(a.getName(), a);
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
+		Name armatureName = Name::interned(a.getName());
+		auto armaturePtr = this->armatures.insert(armatureName, std::move(a));
 		
 		ArmatureTracker t;
 		t.ptr = armaturePtr;
 		t.usageCount++;
 		
-		return this->armatureTrackers.insert(a.getName(), t);
+		return this->armatureTrackers.insert(armatureName, t);
 	}
 
 	Armature AssetManager::getArmature(std::string name)
 	{
+		std::shared_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->armatureTrackers.exists(name))
 		Log::crash("AssetManager::getArmature(): Attempting to get armature that does not exist: " + name);
@@ -775,6 +1099,8 @@ if (!this->meshTrackers.exists(name))
 
 	void AssetManager::removeArmature(std::string name)
 	{
+		std::unique_lock<std::shared_mutex> lock(this->registryMutex);
+
 #ifdef DEBUG_LOG
 	if (!this->armatureTrackers.exists(name))
 		Log::crash("AssetManager::removeArmature(): Attempting to remove armature that does not exist: " + name);
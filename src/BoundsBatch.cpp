@@ -0,0 +1,96 @@
+#include "vel/BoundsBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEL_BOUNDS_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+
+namespace vel
+{
+	size_t BoundsBatch::size() const
+	{
+		return this->bounds[MIN_X].size();
+	}
+
+	void BoundsBatch::clear()
+	{
+		for (size_t c = 0; c < COUNT; c++)
+			this->bounds[c].clear();
+	}
+
+	void BoundsBatch::reserve(size_t n)
+	{
+		for (size_t c = 0; c < COUNT; c++)
+			this->bounds[c].reserve(n);
+	}
+
+	uint32_t BoundsBatch::push(const glm::vec3& min, const glm::vec3& max)
+	{
+		this->bounds[MIN_X].push_back(min.x);
+		this->bounds[MIN_Y].push_back(min.y);
+		this->bounds[MIN_Z].push_back(min.z);
+		this->bounds[MAX_X].push_back(max.x);
+		this->bounds[MAX_Y].push_back(max.y);
+		this->bounds[MAX_Z].push_back(max.z);
+
+		return (uint32_t)(this->size() - 1);
+	}
+
+	void BoundsBatch::cull(const std::array<glm::vec4, 6>& planes, uint8_t* visible) const
+	{
+		size_t n = this->size();
+		size_t i = 0;
+
+		// per plane, which component array holds the corner furthest along it's normal
+		const float* corner[6][3];
+		for (size_t p = 0; p < 6; p++)
+		{
+			corner[p][0] = (planes[p].x >= 0.0f ? this->bounds[MAX_X] : this->bounds[MIN_X]).data();
+			corner[p][1] = (planes[p].y >= 0.0f ? this->bounds[MAX_Y] : this->bounds[MIN_Y]).data();
+			corner[p][2] = (planes[p].z >= 0.0f ? this->bounds[MAX_Z] : this->bounds[MIN_Z]).data();
+		}
+
+#ifdef VEL_BOUNDS_BATCH_SSE
+		__m128 planeX[6], planeY[6], planeZ[6], planeW[6];
+		for (size_t p = 0; p < 6; p++)
+		{
+			planeX[p] = _mm_set1_ps(planes[p].x);
+			planeY[p] = _mm_set1_ps(planes[p].y);
+			planeZ[p] = _mm_set1_ps(planes[p].z);
+			planeW[p] = _mm_set1_ps(planes[p].w);
+		}
+
+		const __m128 zero = _mm_setzero_ps();
+
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 inside = _mm_castsi128_ps(_mm_set1_epi32(-1));
+			for (size_t p = 0; p < 6; p++)
+			{
+				__m128 d = _mm_add_ps(
+					_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(corner[p][0] + i), planeX[p]), _mm_mul_ps(_mm_loadu_ps(corner[p][1] + i), planeY[p])),
+					_mm_add_ps(_mm_mul_ps(_mm_loadu_ps(corner[p][2] + i), planeZ[p]), planeW[p]));
+				inside = _mm_and_ps(inside, _mm_cmpge_ps(d, zero));
+			}
+
+			int mask = _mm_movemask_ps(inside);
+			visible[i] = (uint8_t)(mask & 1);
+			visible[i + 1] = (uint8_t)((mask >> 1) & 1);
+			visible[i + 2] = (uint8_t)((mask >> 2) & 1);
+			visible[i + 3] = (uint8_t)((mask >> 3) & 1);
+		}
+#endif
+
+		for (; i < n; i++)
+		{
+			uint8_t inside = 1;
+			for (size_t p = 0; p < 6 && inside; p++)
+				if ((corner[p][0][i] * planes[p].x + corner[p][1][i] * planes[p].y) + (corner[p][2][i] * planes[p].z + planes[p].w) < 0.0f)
+					inside = 0;
+
+			visible[i] = inside;
+		}
+	}
+
+}
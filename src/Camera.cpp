@@ -4,6 +4,7 @@
 
 #include "vel/App.h"
 #include "vel/Camera.h"
+#include "vel/functions.h"
 
 
 
@@ -19,7 +20,8 @@ namespace vel
 		lookAt(glm::vec3(0.0f, 0.0f, 0.0f)),
 		up(glm::vec3(0.0f, 1.0f, 0.0f)),
 		viewMatrix(glm::mat4(1.0f)),
-		projectionMatrix(glm::mat4(1.0f))
+		projectionMatrix(glm::mat4(1.0f)),
+		frustumPlanes(vel::frustumPlanes(glm::mat4(1.0f)))
 	{
 
 	}
@@ -58,6 +60,7 @@ namespace vel
 	{
 		this->updateViewMatrix();
 		this->updateProjectionMatrix();
+		this->frustumPlanes = vel::frustumPlanes(this->projectionMatrix * this->viewMatrix);
 	}
 
 	glm::mat4 Camera::getViewMatrix()
@@ -70,6 +73,11 @@ namespace vel
 		return this->projectionMatrix;
 	}
 
+	const std::array<glm::vec4, 6>& Camera::getFrustumPlanes() const
+	{
+		return this->frustumPlanes;
+	}
+
 	void Camera::setPosition(float x, float y, float z)
 	{
 		this->position = glm::vec3(x, y, z);
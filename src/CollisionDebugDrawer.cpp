@@ -1,7 +1,5 @@
 #include <iostream>
 
-#include "glad/glad.h"
-
 #include "vel/CollisionDebugDrawer.h"
 
 
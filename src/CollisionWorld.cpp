@@ -1,3 +1,5 @@
+#include <chrono>
+#include <algorithm>
 
 #include "BulletCollision/CollisionDispatch/btInternalEdgeUtility.h"
 #include "glm/glm.hpp"
@@ -7,6 +9,7 @@
 #include "vel/functions.h"
 #include "vel/RaycastCallback.h"
 #include "vel/ConvexCastCallback.h"
+#include "vel/TickGraph.h"
 
 
 
@@ -20,6 +23,8 @@ namespace vel
 		overlappingPairCache(new btDbvtBroadphase()),
 		solver(new btSequentialImpulseConstraintSolver),
 		dynamicsWorld(new btDiscreteDynamicsWorld(dispatcher, overlappingPairCache, solver, collisionConfiguration)),
+		matchedManifoldCount(0),
+		stepTime(0.0),
 		camera(nullptr),
 		collisionDebugDrawer(nullptr)
 	{
@@ -107,23 +112,85 @@ namespace vel
 	//TODO feels terrible to be looping through every sensor for every contact manifold, there might
 	// be some way to hook into the collisions when they happen within the bullet api???? which in turn
 	// would be substantially quicker, but will require a complete reworking of our current "Sensors" logic
+	void CollisionWorld::step(float delta)
+	{
+		TickGraph::access(this, true);
+
+		auto start = std::chrono::high_resolution_clock::now();
+
+		// whatever moved last step has it's previous transform caught up, those still moving are set again below
+		// and the rest have come to rest, so this is all the interpolation bookkeeping sleeping bodies ever need
+		for (auto a : this->movedActors)
+			a->updatePreviousTransform();
+
+		this->movedActors.clear();
+
+		this->dynamicsWorld->stepSimulation(delta, 0);
+
+		this->stepTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+	}
+
+	double CollisionWorld::getStepTime() const
+	{
+		return this->stepTime;
+	}
+
+	void CollisionWorld::addMovedActor(Actor* a)
+	{
+		this->movedActors.push_back(a);
+	}
+
+	const std::vector<Actor*>& CollisionWorld::getMovedActors() const
+	{
+		return this->movedActors;
+	}
+
 	void CollisionWorld::processSensors()
 	{
-		for (int i = 0; i < this->dispatcher->getNumManifolds(); i++)
-		{
-			btPersistentManifold* contactManifold = this->dispatcher->getManifoldByIndexInternal(i);
-			if (contactManifold->getNumContacts() > 0)
+		this->matchSensors();
+		this->dispatchSensors();
+	}
+
+	// matching manifolds against sensors only reads bullet and sensor state so it is spread over the job system
+	void CollisionWorld::matchSensors()
+	{
+		TickGraph::access(this, true);
+
+		int manifoldCount = this->dispatcher->getNumManifolds();
+		if ((size_t)manifoldCount > this->manifoldSensorMatches.size())
+			this->manifoldSensorMatches.resize(manifoldCount);
+
+		this->matchedManifoldCount = manifoldCount;
+
+		auto& sensors = this->sensors.getAll();
+		App::get().getJobSystem().parallelFor((size_t)manifoldCount, 32, [this, &sensors](size_t begin, size_t end) {
+			for (size_t i = begin; i < end; i++)
 			{
-				for (auto sen : this->sensors.getAll())
-				{
-					if (!sen->matchingManifold(contactManifold->getBody0(), contactManifold->getBody1()))
-						continue;
+				auto& matches = this->manifoldSensorMatches[i];
+				matches.clear();
+
+				btPersistentManifold* contactManifold = this->dispatcher->getManifoldByIndexInternal((int)i);
+				if (contactManifold->getNumContacts() == 0)
+					continue;
 
-					sen->onContactDiscovered(contactManifold, sen->contactPair);
-				}
+				for (auto sen : sensors)
+					if (sen->matchingManifold(contactManifold->getBody0(), contactManifold->getBody1()))
+						matches.push_back(sen);
 			}
-		}
+		});
+	}
+
+	// the callbacks are user code, they run on the calling thread in manifold order
+	void CollisionWorld::dispatchSensors()
+	{
+		TickGraph::access(this, true);
 
+		for (int i = 0; i < this->matchedManifoldCount && i < this->dispatcher->getNumManifolds(); i++)
+		{
+			btPersistentManifold* contactManifold = this->dispatcher->getManifoldByIndexInternal(i);
+			for (auto sen : this->manifoldSensorMatches[i])
+				sen->onContactDiscovered(contactManifold, sen->contactPair);
+		}
 	}
 
 	void CollisionWorld::useDebugDrawer(Shader* s, int debugMode)
@@ -147,7 +214,8 @@ namespace vel
 
 	Sensor* CollisionWorld::addSensor(Sensor s)
 	{
-		return this->sensors.insert(s.name, s);
+		// sensors are only ever looked up by pointer, so no need to pay for the name index
+		return this->sensors.insert(s);
 	}
 
 	void CollisionWorld::removeSensor(Sensor* s)
@@ -163,6 +231,11 @@ namespace vel
 
 	void CollisionWorld::removeRigidBody(btRigidBody* rb)
 	{
+		// the actor may be about to be freed, don't leave it in the moved list
+		auto actor = static_cast<Actor*>(rb->getUserPointer());
+		if (actor != nullptr)
+			this->movedActors.erase(std::remove(this->movedActors.begin(), this->movedActors.end(), actor), this->movedActors.end());
+
 		if (rb->getMotionState())
 			delete rb->getMotionState();
 
@@ -236,8 +309,8 @@ namespace vel
 		
 		btScalar mass(0.0);
 		btVector3 localInertia(0, 0, 0);
-		btDefaultMotionState* defaultMotionState = new btDefaultMotionState();
-		btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, defaultMotionState, staticCollisionShape, localInertia);
+		ActorMotionState* motionState = new ActorMotionState(actor, this);
+		btRigidBody::btRigidBodyConstructionInfo rbInfo(mass, motionState, staticCollisionShape, localInertia);
 		btRigidBody* body = new btRigidBody(rbInfo);
 
 		///////// added below to handle jitter when objects sliding across faces
@@ -0,0 +1,114 @@
+#include <algorithm>
+#include <cmath>
+#include <iterator>
+
+#include "vel/FrameHistogram.h"
+
+
+namespace vel
+{
+	FrameHistogram::FrameHistogram()
+	{
+		this->reset();
+	}
+
+	size_t FrameHistogram::bucketIndex(uint64_t micros)
+	{
+		if (micros < exactBuckets)
+			return (size_t)micros;
+
+		size_t msb = 0;
+		while ((micros >> (msb + 1)) != 0)
+			msb++;
+
+		// top 6 bits of the value, 32 to 63, pick the bucket within this power of two
+		size_t shift = msb - 5;
+		size_t top = (size_t)(micros >> shift);
+
+		return exactBuckets + (msb - 6) * subBuckets + (top - subBuckets);
+	}
+
+	uint64_t FrameHistogram::bucketUpperBound(size_t index)
+	{
+		if (index < exactBuckets)
+			return index;
+
+		size_t k = index - exactBuckets;
+		size_t shift = (6 + k / subBuckets) - 5;
+		uint64_t top = subBuckets + k % subBuckets;
+
+		return ((top + 1) << shift) - 1;
+	}
+
+	void FrameHistogram::record(double seconds)
+	{
+		double micros = seconds * 1000000.0;
+		uint64_t limit = ((uint64_t)1 << (maxBit + 1)) - 1;
+		uint64_t v = micros <= 0.0 ? 0 : (micros >= (double)limit ? limit : (uint64_t)std::llround(micros));
+
+		this->counts[FrameHistogram::bucketIndex(v)]++;
+		this->count++;
+		this->sum += seconds;
+		this->maxValue = std::max(this->maxValue, v);
+	}
+
+	void FrameHistogram::reset()
+	{
+		std::fill(std::begin(this->counts), std::end(this->counts), (uint64_t)0);
+		this->count = 0;
+		this->sum = 0.0;
+		this->maxValue = 0;
+	}
+
+	uint64_t FrameHistogram::getCount() const
+	{
+		return this->count;
+	}
+
+	double FrameHistogram::getMean() const
+	{
+		return this->count > 0 ? this->sum / (double)this->count : 0.0;
+	}
+
+	double FrameHistogram::getMax() const
+	{
+		return (double)this->maxValue / 1000000.0;
+	}
+
+	// smallest value which at least p percent of recorded values are less than or equal to, reported as the top
+	// of it's bucket (but never above the largest value recorded)
+	double FrameHistogram::percentile(double p) const
+	{
+		if (this->count == 0)
+			return 0.0;
+
+		p = std::min(std::max(p, 0.0), 100.0);
+		uint64_t target = (uint64_t)std::ceil(p / 100.0 * (double)this->count);
+		if (target == 0)
+			target = 1;
+
+		uint64_t seen = 0;
+		for (size_t i = 0; i < bucketCount; i++)
+		{
+			seen += this->counts[i];
+			if (seen >= target)
+				return (double)std::min(FrameHistogram::bucketUpperBound(i), this->maxValue) / 1000000.0;
+		}
+
+		return this->getMax();
+	}
+
+	FrameHistogram::Summary FrameHistogram::summarize() const
+	{
+		Summary s;
+		s.count = this->count;
+		s.mean = this->getMean();
+		s.p50 = this->percentile(50.0);
+		s.p90 = this->percentile(90.0);
+		s.p99 = this->percentile(99.0);
+		s.p999 = this->percentile(99.9);
+		s.max = this->getMax();
+		return s;
+	}
+
+}
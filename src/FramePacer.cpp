@@ -0,0 +1,89 @@
+#include <thread>
+#include <cmath>
+#include <algorithm>
+
+#include "vel/FramePacer.h"
+
+
+namespace vel
+{
+	FramePacer::FramePacer(double slackSeconds) :
+		slack(std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(slackSeconds))),
+		oversleepEstimate(Clock::duration::zero()),
+		waits(0),
+		errorSum(0.0),
+		errorSquaredSum(0.0),
+		errorMax(0.0)
+	{}
+
+	void FramePacer::setSlack(double seconds)
+	{
+		this->slack = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(seconds));
+	}
+
+	double FramePacer::getSlack() const
+	{
+		return std::chrono::duration<double>(this->slack).count();
+	}
+
+	void FramePacer::waitUntil(Clock::time_point deadline, bool recordStats)
+	{
+		// coarse sleep, learning how far past it's target the os tends to wake us
+		auto sleepTarget = deadline - this->slack - this->oversleepEstimate;
+		if (Clock::now() < sleepTarget)
+		{
+			std::this_thread::sleep_until(sleepTarget);
+
+			// a preemption, suspend or debugger break isn't the scheduler's granularity, and left unclamped would
+			// put every later sleep target in the past
+			auto oversleep = std::min<Clock::duration>(Clock::now() - sleepTarget, FramePacer::maxOversleep);
+			if (oversleep > this->oversleepEstimate)
+				this->oversleepEstimate = oversleep; // react to a worse scheduler immediately
+			else
+				this->oversleepEstimate -= (this->oversleepEstimate - oversleep) / 16; // and relax slowly
+		}
+		else
+		{
+			// no sample this time, relax anyway so a skipped sleep can't keep the estimate up for good
+			this->oversleepEstimate -= this->oversleepEstimate / 16;
+		}
+
+		// fine wait for the last stretch
+		while (Clock::now() < deadline)
+			std::this_thread::yield();
+
+		if (!recordStats)
+			return;
+
+		double error = std::chrono::duration<double, std::milli>(Clock::now() - deadline).count();
+
+		this->waits++;
+		this->errorSum += error;
+		this->errorSquaredSum += error * error;
+		if (error > this->errorMax)
+			this->errorMax = error;
+	}
+
+	FramePacer::Stats FramePacer::getStats() const
+	{
+		Stats s;
+		if (this->waits == 0)
+			return s;
+
+		s.waits = this->waits;
+		s.meanError = this->errorSum / this->waits;
+		s.maxError = this->errorMax;
+		s.stdDevError = std::sqrt(std::fmax(0.0, this->errorSquaredSum / this->waits - s.meanError * s.meanError));
+
+		return s;
+	}
+
+	void FramePacer::resetStats()
+	{
+		this->waits = 0;
+		this->errorSum = 0.0;
+		this->errorSquaredSum = 0.0;
+		this->errorMax = 0.0;
+	}
+
+}
@@ -0,0 +1,158 @@
+#include <fstream>
+#include <iomanip>
+
+#include "vel/FrameTelemetry.h"
+
+
+namespace vel
+{
+	FrameTelemetry::FrameTelemetry(double hitchThreshold) :
+		hitchThreshold(hitchThreshold),
+		hitches(0),
+		worstHitch(0.0)
+	{}
+
+	const char* FrameTelemetry::phaseName(FramePhase p)
+	{
+		switch (p)
+		{
+		case FramePhase::GPU_UPLOAD:	return "gpuUpload";
+		case FramePhase::INPUT:			return "input";
+		case FramePhase::OUTER_LOOP:	return "outerLoop";
+		case FramePhase::DRAW:			return "draw";
+		case FramePhase::GUI:			return "gui";
+		case FramePhase::PRESENT:		return "present";
+		case FramePhase::SIM_WAIT:		return "simWait";
+		case FramePhase::WAIT:			return "wait";
+		default:						return "unknown";
+		}
+	}
+
+	void FrameTelemetry::recordFrame(double seconds)
+	{
+		this->frames.record(seconds);
+
+		if (seconds > this->hitchThreshold)
+		{
+			this->hitches++;
+			if (seconds > this->worstHitch)
+				this->worstHitch = seconds;
+		}
+	}
+
+	void FrameTelemetry::recordTick(double seconds)
+	{
+		this->ticks.record(seconds);
+	}
+
+	void FrameTelemetry::recordPhase(FramePhase p, double seconds)
+	{
+		this->phases[(size_t)p].record(seconds);
+	}
+
+	void FrameTelemetry::reset()
+	{
+		this->frames.reset();
+		this->ticks.reset();
+		for (auto& h : this->phases)
+			h.reset();
+
+		this->hitches = 0;
+		this->worstHitch = 0.0;
+	}
+
+	void FrameTelemetry::setHitchThreshold(double seconds)
+	{
+		this->hitchThreshold = seconds;
+	}
+
+	double FrameTelemetry::getHitchThreshold() const
+	{
+		return this->hitchThreshold;
+	}
+
+	uint64_t FrameTelemetry::getHitchCount() const
+	{
+		return this->hitches;
+	}
+
+	double FrameTelemetry::getWorstHitch() const
+	{
+		return this->worstHitch;
+	}
+
+	const FrameHistogram& FrameTelemetry::getFrames() const
+	{
+		return this->frames;
+	}
+
+	const FrameHistogram& FrameTelemetry::getTicks() const
+	{
+		return this->ticks;
+	}
+
+	const FrameHistogram& FrameTelemetry::getPhase(FramePhase p) const
+	{
+		return this->phases[(size_t)p];
+	}
+
+	bool FrameTelemetry::writeCsv(std::string path) const
+	{
+		std::ofstream out(path, std::ofstream::trunc);
+		if (!out.is_open())
+			return false;
+
+		out << std::fixed << std::setprecision(3);
+		out << "series,count,mean_ms,p50_ms,p90_ms,p99_ms,p99.9_ms,max_ms,hitches" << std::endl;
+
+		auto row = [&out](const std::string& name, const FrameHistogram& h, const std::string& hitches) {
+			auto s = h.summarize();
+			out << name << "," << s.count << "," << s.mean * 1000.0 << "," << s.p50 * 1000.0 << "," << s.p90 * 1000.0 << ","
+				<< s.p99 * 1000.0 << "," << s.p999 * 1000.0 << "," << s.max * 1000.0 << "," << hitches << std::endl;
+		};
+
+		row("frame", this->frames, std::to_string(this->hitches));
+		row("tick", this->ticks, "");
+		for (size_t i = 0; i < (size_t)FramePhase::COUNT; i++)
+			row(FrameTelemetry::phaseName((FramePhase)i), this->phases[i], "");
+
+		out.close();
+		return true;
+	}
+
+	bool FrameTelemetry::writeJson(std::string path) const
+	{
+		std::ofstream out(path, std::ofstream::trunc);
+		if (!out.is_open())
+			return false;
+
+		out << std::fixed << std::setprecision(3);
+
+		auto series = [&out](const FrameHistogram& h) {
+			auto s = h.summarize();
+			out << "{\"count\":" << s.count << ",\"meanMs\":" << s.mean * 1000.0 << ",\"p50Ms\":" << s.p50 * 1000.0
+				<< ",\"p90Ms\":" << s.p90 * 1000.0 << ",\"p99Ms\":" << s.p99 * 1000.0 << ",\"p999Ms\":" << s.p999 * 1000.0
+				<< ",\"maxMs\":" << s.max * 1000.0 << "}";
+		};
+
+		out << "{\"hitchThresholdMs\":" << this->hitchThreshold * 1000.0 << ",\"hitches\":" << this->hitches
+			<< ",\"worstHitchMs\":" << this->worstHitch * 1000.0 << ",\"frame\":";
+		series(this->frames);
+		out << ",\"tick\":";
+		series(this->ticks);
+		out << ",\"phases\":{";
+		for (size_t i = 0; i < (size_t)FramePhase::COUNT; i++)
+		{
+			if (i > 0)
+				out << ",";
+
+			out << "\"" << FrameTelemetry::phaseName((FramePhase)i) << "\":";
+			series(this->phases[i]);
+		}
+		out << "}}" << std::endl;
+
+		out.close();
+		return true;
+	}
+
+}
@@ -2,6 +2,7 @@
 #include <fstream>
 #include <sstream>
 #include <filesystem>
+#include <algorithm>
 
 #include "glad/glad.h"
 #include "GLFW/glfw3.h"
@@ -16,9 +17,24 @@
 #include "vel/functions.h"
 #include "vel/App.h"
 #include "vel/Log.h"
+#include "vel/Profiler.h"
 
 namespace vel
 {
+	namespace
+	{
+		// std140 layout of the Camera block, the vec3 is padded to a vec4
+		struct CameraBlock
+		{
+			glm::mat4	projection;
+			glm::mat4	view;
+			glm::mat4	offset;
+			glm::vec4	position;
+		};
+
+		static_assert(sizeof(CameraBlock) == 208, "CameraBlock must match the std140 layout of the Camera block");
+	}
+
 	GPU::GPU(Window* w) :
 		window(w),
 		activeShader(nullptr),
@@ -30,7 +46,17 @@ namespace vel
         prefilterShader(nullptr),
         brdfShader(nullptr),
         backgroundShader(nullptr),
-		currentRenderMode(RenderMode::STATIC_DIFFUSE)
+		currentRenderMode(RenderMode::STATIC_DIFFUSE),
+		cameraUBO(0),
+		cameraVersion(0),
+		cameraProjection(1.0f),
+		cameraView(1.0f),
+		cameraOffset(1.0f),
+		cameraPosition(0.0f),
+		boneSSBO(0),
+		boneSSBOCapacity(0),
+		instanceSSBO(0),
+		instanceSSBOCapacity(0)
 	{
         this->enableDepthTest();
         this->enableCubeMapTextures();       
@@ -40,6 +66,15 @@ namespace vel
 
         glGenFramebuffers(1, &this->pbrCaptureFBO);
         glGenRenderbuffers(1, &this->pbrCaptureRBO);
+
+		glGenBuffers(1, &this->cameraUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, this->cameraUBO);
+		glBufferData(GL_UNIFORM_BUFFER, sizeof(CameraBlock), nullptr, GL_DYNAMIC_DRAW);
+		glBindBufferBase(GL_UNIFORM_BUFFER, GPU::CAMERA_BLOCK_BINDING, this->cameraUBO);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+
+		glGenBuffers(1, &this->boneSSBO);
+		glGenBuffers(1, &this->instanceSSBO);
 	}
 
 	GPU::~GPU(){}
@@ -85,6 +120,20 @@ namespace vel
 	{
 		glDeleteTextures(1, &t->id);
 	}
+
+	void GPU::freeTextureLevels(Texture* t, size_t firstLevel)
+	{
+		if (firstLevel == 0)
+			stbi_image_free(t->primaryImageData.data);
+
+		for (size_t level = std::max<size_t>(firstLevel, 1); level <= t->mips.size(); level++)
+			stbi_image_free(t->mips.at(level - 1).data);
+	}
+
+	void GPU::freeInfiniteCubemapData(Cubemap* h)
+	{
+		stbi_image_free(h->primaryImageData.dataf);
+	}
     
     void GPU::clearInfiniteCubemap(Cubemap* h)
     {
@@ -203,6 +252,77 @@ namespace vel
 
 
 		s->id = id;
+
+		this->resolveUniforms(s);
+	}
+
+	void GPU::resolveUniforms(Shader* s)
+	{
+		s->uniformLocations.clear();
+
+		GLint count = 0;
+		GLint maxLength = 0;
+		glGetProgramiv(s->id, GL_ACTIVE_UNIFORMS, &count);
+		glGetProgramiv(s->id, GL_ACTIVE_UNIFORM_MAX_LENGTH, &maxLength);
+
+		std::vector<char> buffer((size_t)maxLength + 1);
+		for (GLint i = 0; i < count; i++)
+		{
+			GLsizei length = 0;
+			GLint size = 0;
+			GLenum type;
+			glGetActiveUniform(s->id, (GLuint)i, (GLsizei)buffer.size(), &length, &size, &type, buffer.data());
+
+			std::string name(buffer.data(), (size_t)length);
+
+			// arrays are reported once by their first element, the bone palette for example, so add every element
+			if (size > 1 && name.size() > 3 && name.compare(name.size() - 3, 3, "[0]") == 0)
+			{
+				std::string base = name.substr(0, name.size() - 3);
+				for (GLint e = 0; e < size; e++)
+				{
+					std::string element = base + "[" + std::to_string(e) + "]";
+					s->uniformLocations[Name::interned(element)] = glGetUniformLocation(s->id, element.c_str());
+				}
+				continue;
+			}
+
+			// members of uniform blocks have no location
+			GLint location = glGetUniformLocation(s->id, name.c_str());
+			if (location >= 0)
+				s->uniformLocations[Name::interned(name)] = location;
+		}
+
+		auto find = [s](const Name& n) -> GLint {
+			auto it = s->uniformLocations.find(n);
+			return it == s->uniformLocations.end() ? -1 : it->second;
+		};
+
+		s->uniforms.model = find("model");
+		s->uniforms.projection = find("projection");
+		s->uniforms.view = find("view");
+		s->uniforms.camPos = find("camPos");
+		s->uniforms.camOffset = find("camOffset");
+		s->uniforms.bones = find("bones[0]");
+		s->uniforms.boneOffset = find("boneOffset");
+		s->uniforms.instanceOffset = find("instanceOffset");
+
+		GLuint block = glGetUniformBlockIndex(s->id, "Camera");
+		s->cameraBlock = block != GL_INVALID_INDEX;
+		if (s->cameraBlock)
+			glUniformBlockBinding(s->id, block, GPU::CAMERA_BLOCK_BINDING);
+
+		s->cameraVersion = 0;
+
+		GLuint boneBlock = glGetProgramResourceIndex(s->id, GL_SHADER_STORAGE_BLOCK, "Bones");
+		s->boneBlock = boneBlock != GL_INVALID_INDEX;
+		if (s->boneBlock)
+			glShaderStorageBlockBinding(s->id, boneBlock, GPU::BONE_BLOCK_BINDING);
+
+		GLuint instanceBlock = glGetProgramResourceIndex(s->id, GL_SHADER_STORAGE_BLOCK, "Instances");
+		s->instanceBlock = instanceBlock != GL_INVALID_INDEX;
+		if (s->instanceBlock)
+			glShaderStorageBlockBinding(s->id, instanceBlock, GPU::INSTANCE_BLOCK_BINDING);
 	}
 
 	void GPU::loadMesh(Mesh* m)
@@ -256,108 +376,83 @@ namespace vel
 
 	void GPU::loadTexture(Texture* t)
 	{
-		glGenTextures(1, &t->id);
-		glBindTexture(GL_TEXTURE_2D, t->id);
-		glTexImage2D(
-			GL_TEXTURE_2D, 
-			0, 
-			t->primaryImageData.format, 
-			t->primaryImageData.width, 
-			t->primaryImageData.height, 
-			0, 
-			t->primaryImageData.format, 
-			GL_UNSIGNED_BYTE,
-			t->primaryImageData.data
-		);
+		for (size_t level = 0; level <= t->mips.size(); level++)
+			this->loadTextureLevel(t, level);
+	}
 
-		if (t->mips.size() == 0)
+	// levels are sent in order and GL_TEXTURE_MAX_LEVEL follows the last one sent, so the texture is complete
+	// (and can be sampled) after every level, not just once all of them have arrived
+	void GPU::loadTextureLevel(Texture* t, size_t level)
+	{
+		if (level == 0)
 		{
+			glGenTextures(1, &t->id);
+			glBindTexture(GL_TEXTURE_2D, t->id);
+			glTexImage2D(
+				GL_TEXTURE_2D, 
+				0, 
+				t->primaryImageData.format, 
+				t->primaryImageData.width, 
+				t->primaryImageData.height, 
+				0, 
+				t->primaryImageData.format, 
+				GL_UNSIGNED_BYTE,
+				t->primaryImageData.data
+			);
+
+			if (t->mips.size() == 0)
+			{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Generating mipmaps");
 #endif
-			glGenerateMipmap(GL_TEXTURE_2D);
-		}
-		
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-
-		if (t->mips.size() > 0)
-		{
+				glGenerateMipmap(GL_TEXTURE_2D);
+			}
+			else
+			{
 #ifdef DEBUG_LOG
 	Log::toCliAndFile("Loading pre-computed mipmaps");
 #endif
+				glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, 0);
+			}
+		
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
 
-			int mipcount = (int)t->mips.size();
+			stbi_image_free(t->primaryImageData.data);
+			return;
+		}
 
-			glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, mipcount);
+		auto& mip = t->mips.at(level - 1);
 
-			while (mipcount > 0)
-			{
-				glTexImage2D(
-					GL_TEXTURE_2D, 
-					mipcount, 
-					t->mips.at((mipcount - 1)).format, 
-					t->mips.at((mipcount - 1)).width, 
-					t->mips.at((mipcount - 1)).height, 
-					0, 
-					t->mips.at((mipcount - 1)).format, 
-					GL_UNSIGNED_BYTE, 
-					t->mips.at((mipcount - 1)).data
-				);
-
-				stbi_image_free(t->mips.at((mipcount - 1)).data);
-				mipcount--;
-			}
-		}
-			
-		stbi_image_free(t->primaryImageData.data);
+		glBindTexture(GL_TEXTURE_2D, t->id);
+		glTexImage2D(
+			GL_TEXTURE_2D, 
+			(GLint)level, 
+			mip.format, 
+			mip.width, 
+			mip.height, 
+			0, 
+			mip.format, 
+			GL_UNSIGNED_BYTE, 
+			mip.data
+		);
+		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAX_LEVEL, (GLint)level);
+
+		stbi_image_free(mip.data);
 	}
 
-    void GPU::loadInfiniteCubemap(Cubemap* h)
-    {		
-        // pbr: reset framebuffers
-        // ------------------------
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-        glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->pbrCaptureRBO);
-		
-        
-        // pbr: load the HDR environment map
-        // ---------------------------------
-        glGenTextures(1, &h->hdrTexture);
-        glBindTexture(GL_TEXTURE_2D, h->hdrTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, h->primaryImageData.width, h->primaryImageData.height, 0, GL_RGB, GL_FLOAT, h->primaryImageData.dataf); // note how we specify the texture's data value to be float
-
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        stbi_image_free(h->primaryImageData.dataf);
-        
-        
-        // pbr: setup cubemap to render to and attach to framebuffer
-        // ---------------------------------------------------------
-        glGenTextures(1, &h->envCubemap);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-     
-     
-        // pbr: set up projection and view matrices for capturing data onto the 6 cubemap face directions
-        // ----------------------------------------------------------------------------------------------
-        glm::mat4 captureProjection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
-        glm::mat4 captureViews[] =
+    // projection and view matrices for capturing data onto the 6 cubemap face directions
+    static const glm::mat4& cubemapCaptureProjection()
+    {
+        static const glm::mat4 projection = glm::perspective(glm::radians(90.0f), 1.0f, 0.1f, 10.0f);
+        return projection;
+    }
+
+    static const glm::mat4* cubemapCaptureViews()
+    {
+        static const glm::mat4 views[] =
         {
             glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
             glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3(-1.0f,  0.0f,  0.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
@@ -366,146 +461,199 @@ namespace vel
             glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f,  1.0f), glm::vec3(0.0f, -1.0f,  0.0f)),
             glm::lookAt(glm::vec3(0.0f, 0.0f, 0.0f), glm::vec3( 0.0f,  0.0f, -1.0f), glm::vec3(0.0f, -1.0f,  0.0f))
         };
-        
-        
-        // pbr: convert HDR equirectangular environment map to cubemap equivalent
-        // ----------------------------------------------------------------------
-		this->useShader(this->equirectangularToCubemapShader);
-		this->setShaderInt("equirectangularMap", 0);
-		this->setShaderMat4("projection", captureProjection);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_2D, h->hdrTexture);
+        return views;
+    }
 
-        glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-			this->setShaderMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, h->envCubemap, 0);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+    // the ibl precompute is split so a frame can be drawn between any two steps, each step sets up the capture
+    // framebuffer itself and leaves the default one bound with the screen viewport
+    void GPU::loadInfiniteCubemapStep(Cubemap* h, size_t step)
+    {
+		VEL_ZONE("GPU::loadInfiniteCubemapStep");
 
-            this->drawCube();
-        }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
+        const glm::mat4& captureProjection = cubemapCaptureProjection();
+        const glm::mat4* captureViews = cubemapCaptureViews();
 
-        // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
-        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-        
-        
-        // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
-        // --------------------------------------------------------------------------------
-        glGenTextures(1, &h->irradianceMap);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->irradianceMap);
-        for (unsigned int i = 0; i < 6; ++i)
+        if (step == 0)
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
-        
-        
-        // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
-        // -----------------------------------------------------------------------------
-		this->useShader(this->irradianceShader);
-		this->setShaderInt("environmentMap", 0);
-		this->setShaderMat4("projection", captureProjection);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+            // pbr: reset framebuffers
+            // ------------------------
+            glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+            glFramebufferRenderbuffer(GL_FRAMEBUFFER, GL_DEPTH_ATTACHMENT, GL_RENDERBUFFER, this->pbrCaptureRBO);
 
-        glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        for (unsigned int i = 0; i < 6; ++i)
-        {
-			this->setShaderMat4("view", captureViews[i]);
-            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, h->irradianceMap, 0);
-            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
 
-            this->drawCube();
+            // pbr: load the HDR environment map
+            // ---------------------------------
+            glGenTextures(1, &h->hdrTexture);
+            glBindTexture(GL_TEXTURE_2D, h->hdrTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RGB16F, h->primaryImageData.width, h->primaryImageData.height, 0, GL_RGB, GL_FLOAT, h->primaryImageData.dataf); // note how we specify the texture's data value to be float
+
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            stbi_image_free(h->primaryImageData.dataf);
+
+
+            // pbr: setup cubemap to render to and attach to framebuffer
+            // ---------------------------------------------------------
+            glGenTextures(1, &h->envCubemap);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+            for (unsigned int i = 0; i < 6; ++i)
+            {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 512, 512, 0, GL_RGB, GL_FLOAT, nullptr);
+            }
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // enable pre-filter mipmap sampling (combatting visible dots artifact)
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+
+            // pbr: convert HDR equirectangular environment map to cubemap equivalent
+            // ----------------------------------------------------------------------
+            this->useShader(this->equirectangularToCubemapShader);
+            this->setShaderInt("equirectangularMap", 0);
+            this->setShaderMat4("projection", captureProjection);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_2D, h->hdrTexture);
+
+            glViewport(0, 0, 512, 512); // don't forget to configure the viewport to the capture dimensions.
+            glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
+            for (unsigned int i = 0; i < 6; ++i)
+            {
+                this->setShaderMat4("view", captureViews[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, h->envCubemap, 0);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                this->drawCube();
+            }
+            glBindFramebuffer(GL_FRAMEBUFFER, 0);
+
+            // then let OpenGL generate mipmaps from first mip face (combatting visible dots artifact)
+            glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+            glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        
-        
-        // pbr: create a pre-filter cubemap, and re-scale capture FBO to pre-filter scale.
-        // --------------------------------------------------------------------------------
-        glGenTextures(1, &h->prefilterMap);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->prefilterMap);
-        for (unsigned int i = 0; i < 6; ++i)
+        else if (step == 1)
         {
-            glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
-        }
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
-        glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-        // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
-        glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
-        
-        
-        // pbr: run a quasi monte-carlo simulation on the environment lighting to create a prefilter (cube)map.
-        // ----------------------------------------------------------------------------------------------------
-		this->useShader(this->prefilterShader);
-		this->setShaderInt("environmentMap", 0);
-		this->setShaderMat4("projection", captureProjection);
-        glActiveTexture(GL_TEXTURE0);
-        glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+            // pbr: create an irradiance cubemap, and re-scale capture FBO to irradiance scale.
+            // --------------------------------------------------------------------------------
+            glGenTextures(1, &h->irradianceMap);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, h->irradianceMap);
+            for (unsigned int i = 0; i < 6; ++i)
+            {
+                glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 32, 32, 0, GL_RGB, GL_FLOAT, nullptr);
+            }
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 32, 32);
 
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        unsigned int maxMipLevels = 5;
-        for (unsigned int mip = 0; mip < maxMipLevels; ++mip)
+
+            // pbr: solve diffuse integral by convolution to create an irradiance (cube)map.
+            // -----------------------------------------------------------------------------
+            this->useShader(this->irradianceShader);
+            this->setShaderInt("environmentMap", 0);
+            this->setShaderMat4("projection", captureProjection);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+
+            glViewport(0, 0, 32, 32); // don't forget to configure the viewport to the capture dimensions.
+            for (unsigned int i = 0; i < 6; ++i)
+            {
+                this->setShaderMat4("view", captureViews[i]);
+                glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, h->irradianceMap, 0);
+                glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+
+                this->drawCube();
+            }
+        }
+        else if (step < 2 + GPU::PREFILTER_MIP_LEVELS)
         {
+            unsigned int mip = (unsigned int)(step - 2);
+
+            // pbr: create a pre-filter cubemap with the first mip level
+            // ----------------------------------------------------------
+            if (mip == 0)
+            {
+                glGenTextures(1, &h->prefilterMap);
+                glBindTexture(GL_TEXTURE_CUBE_MAP, h->prefilterMap);
+                for (unsigned int i = 0; i < 6; ++i)
+                {
+                    glTexImage2D(GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, 0, GL_RGB16F, 128, 128, 0, GL_RGB, GL_FLOAT, nullptr);
+                }
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_WRAP_R, GL_CLAMP_TO_EDGE);
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR); // be sure to set minification filter to mip_linear 
+                glTexParameteri(GL_TEXTURE_CUBE_MAP, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+                // generate mipmaps for the cubemap so OpenGL automatically allocates the required memory.
+                glGenerateMipmap(GL_TEXTURE_CUBE_MAP);
+            }
+
+
+            // pbr: run a quasi monte-carlo simulation on the environment lighting to create one mip level of the
+            // prefilter (cube)map.
+            // ----------------------------------------------------------------------------------------------------
+            this->useShader(this->prefilterShader);
+            this->setShaderInt("environmentMap", 0);
+            this->setShaderMat4("projection", captureProjection);
+            glActiveTexture(GL_TEXTURE0);
+            glBindTexture(GL_TEXTURE_CUBE_MAP, h->envCubemap);
+
+            glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
+
             // resize framebuffer according to mip-level size.
-            unsigned int mipWidth = 128 * std::pow(0.5, mip);
-            unsigned int mipHeight = 128 * std::pow(0.5, mip);
+            unsigned int mipWidth = 128 >> mip;
+            unsigned int mipHeight = 128 >> mip;
             glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
             glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, mipWidth, mipHeight);
             glViewport(0, 0, mipWidth, mipHeight);
 
-            float roughness = (float)mip / (float)(maxMipLevels - 1);
-			this->setShaderFloat("roughness", roughness);
+            float roughness = (float)mip / (float)(GPU::PREFILTER_MIP_LEVELS - 1);
+            this->setShaderFloat("roughness", roughness);
             for (unsigned int i = 0; i < 6; ++i)
             {
-				this->setShaderMat4("view", captureViews[i]);
+                this->setShaderMat4("view", captureViews[i]);
                 glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_CUBE_MAP_POSITIVE_X + i, h->prefilterMap, mip);
 
                 glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
                 this->drawCube();
             }
         }
-        glBindFramebuffer(GL_FRAMEBUFFER, 0);
-        
-        
-        // pbr: generate a 2D LUT from the BRDF equations used.
-        // ----------------------------------------------------
-        glGenTextures(1, &h->brdfLUTTexture);
-
-        // pre-allocate enough memory for the LUT texture.
-        glBindTexture(GL_TEXTURE_2D, h->brdfLUTTexture);
-        glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
-        // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-
-        // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
-        glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
-        glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
-        glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
-        glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, h->brdfLUTTexture, 0);
-
-        glViewport(0, 0, 512, 512);
-		this->useShader(this->brdfShader);
-        glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
-        this->drawQuad();
+        else
+        {
+            // pbr: generate a 2D LUT from the BRDF equations used.
+            // ----------------------------------------------------
+            glGenTextures(1, &h->brdfLUTTexture);
+
+            // pre-allocate enough memory for the LUT texture.
+            glBindTexture(GL_TEXTURE_2D, h->brdfLUTTexture);
+            glTexImage2D(GL_TEXTURE_2D, 0, GL_RG16F, 512, 512, 0, GL_RG, GL_FLOAT, 0);
+            // be sure to set wrapping mode to GL_CLAMP_TO_EDGE
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+            glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+
+            // then re-configure capture framebuffer object and render screen-space quad with BRDF shader.
+            glBindFramebuffer(GL_FRAMEBUFFER, this->pbrCaptureFBO);
+            glBindRenderbuffer(GL_RENDERBUFFER, this->pbrCaptureRBO);
+            glRenderbufferStorage(GL_RENDERBUFFER, GL_DEPTH_COMPONENT24, 512, 512);
+            glFramebufferTexture2D(GL_FRAMEBUFFER, GL_COLOR_ATTACHMENT0, GL_TEXTURE_2D, h->brdfLUTTexture, 0);
+
+            glViewport(0, 0, 512, 512);
+            this->useShader(this->brdfShader);
+            glClear(GL_COLOR_BUFFER_BIT | GL_DEPTH_BUFFER_BIT);
+            this->drawQuad();
+        }
 
 
         // re-bind OG framebuffer and reset viewport dimensions to screen dimensions
@@ -540,52 +688,133 @@ namespace vel
 		glUseProgram(s->id);
 	}
 
-	void GPU::setShaderBool(const std::string& name, bool value) const
+	GLint GPU::uniformLocation(const Name& name) const
+	{
+		auto& locations = this->activeShader->uniformLocations;
+		auto it = locations.find(name);
+		if (it != locations.end())
+			return it->second;
+
+		// every active uniform was resolved at link time, so this one is unused or misspelled. Remembered so
+		// it's a single lookup next time too
+		locations.emplace(name, -1);
+		return -1;
+	}
+
+	void GPU::setShaderBool(const Name& name, bool value) const
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		glUniform1i(this->uniformLocation(name), (int)value);
+	}
 
-		glUniform1i(this->activeShader->uniformLocations[name], (int)value);
+	void GPU::setShaderInt(const Name& name, int value) const
+	{
+		glUniform1i(this->uniformLocation(name), value);
 	}
 
-	void GPU::setShaderInt(const std::string& name, int value) const
+	void GPU::setShaderFloat(const Name& name, float value) const
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		glUniform1f(this->uniformLocation(name), value);
+	}
 
-		glUniform1i(this->activeShader->uniformLocations[name], value);
+	void GPU::setShaderMat4(const Name& name, glm::mat4 value) const
+	{
+		glUniformMatrix4fv(this->uniformLocation(name), 1, GL_FALSE, glm::value_ptr(value));
 	}
 
-	void GPU::setShaderFloat(const std::string& name, float value) const
+	void GPU::setShaderVec3(const Name& name, glm::vec3 value) const
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		glUniform3fv(this->uniformLocation(name), 1, &value[0]);
+	}
 
-		glUniform1f(this->activeShader->uniformLocations[name], value);
+	void GPU::setShaderVec4(const Name& name, glm::vec4 value) const
+	{
+		glUniform4fv(this->uniformLocation(name), 1, &value[0]);
 	}
 
-	void GPU::setShaderMat4(const std::string& name, glm::mat4 value) const
+	void GPU::setShaderMat4(GLint location, const glm::mat4& value) const
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		if (location >= 0)
+			glUniformMatrix4fv(location, 1, GL_FALSE, glm::value_ptr(value));
+	}
 
-		glUniformMatrix4fv(this->activeShader->uniformLocations[name], 1, GL_FALSE, glm::value_ptr(value));
+	void GPU::setShaderVec3(GLint location, const glm::vec3& value) const
+	{
+		if (location >= 0)
+			glUniform3fv(location, 1, &value[0]);
 	}
 
-	void GPU::setShaderVec3(const std::string &name, glm::vec3 value) const
+	void GPU::setCamera(const glm::mat4& projection, const glm::mat4& view, const glm::vec3& position, const glm::mat4& offset)
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		this->cameraVersion++;
+		this->cameraProjection = projection;
+		this->cameraView = view;
+		this->cameraOffset = offset;
+		this->cameraPosition = position;
+
+		CameraBlock block = { projection, view, offset, glm::vec4(position, 1.0f) };
+		glBindBuffer(GL_UNIFORM_BUFFER, this->cameraUBO);
+		glBufferSubData(GL_UNIFORM_BUFFER, 0, sizeof(CameraBlock), &block);
+		glBindBuffer(GL_UNIFORM_BUFFER, 0);
+	}
 
-		glUniform3fv(this->activeShader->uniformLocations[name], 1, &value[0]);
+	void GPU::applyCamera()
+	{
+		Shader* s = this->activeShader;
+		if (s->cameraBlock || s->cameraVersion == this->cameraVersion)
+			return;
+
+		// uniforms are program state, so they stay set until the camera changes
+		s->cameraVersion = this->cameraVersion;
+		this->setShaderMat4(s->uniforms.projection, this->cameraProjection);
+		this->setShaderMat4(s->uniforms.view, this->cameraView);
+		this->setShaderMat4(s->uniforms.camOffset, this->cameraOffset);
+		this->setShaderVec3(s->uniforms.camPos, this->cameraPosition);
 	}
 
-	void GPU::setShaderVec4(const std::string &name, glm::vec4 value) const
+	void GPU::uploadStorage(unsigned int buffer, size_t& capacity, unsigned int binding, const void* data, size_t size)
 	{
-		if (!this->activeShader->uniformLocations.count(name) == 1)
-			this->activeShader->uniformLocations[name] = glGetUniformLocation(this->activeShader->id, name.c_str());
+		if (size == 0)
+			return;
 
-		glUniform4fv(this->activeShader->uniformLocations[name], 1, &value[0]);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, buffer);
+
+		// reallocating also orphans last frame's storage, otherwise overwrite it in place
+		if (size > capacity)
+		{
+			capacity = std::max(size, capacity * 2);
+			glBufferData(GL_SHADER_STORAGE_BUFFER, capacity, nullptr, GL_DYNAMIC_DRAW);
+			glBindBufferBase(GL_SHADER_STORAGE_BUFFER, binding, buffer);
+		}
+
+		glBufferSubData(GL_SHADER_STORAGE_BUFFER, 0, size, data);
+		glBindBuffer(GL_SHADER_STORAGE_BUFFER, 0);
+	}
+
+	void GPU::setBonePalette(const std::vector<glm::mat4>& palette)
+	{
+		this->uploadStorage(this->boneSSBO, this->boneSSBOCapacity, GPU::BONE_BLOCK_BINDING, palette.data(), palette.size() * sizeof(glm::mat4));
+	}
+
+	void GPU::useBones(const std::vector<glm::mat4>& palette, uint32_t begin, uint32_t end)
+	{
+		if (begin == end)
+			return;
+
+		if (this->activeShader->boneBlock)
+		{
+			if (this->activeShader->uniforms.boneOffset >= 0)
+				glUniform1i(this->activeShader->uniforms.boneOffset, (GLint)begin);
+		}
+		else if (this->activeShader->uniforms.bones >= 0)
+		{
+			// array elements have consecutive locations, so the palette goes in as one array
+			glUniformMatrix4fv(this->activeShader->uniforms.bones, (GLsizei)(end - begin), GL_FALSE, glm::value_ptr(palette[begin]));
+		}
+	}
+
+	void GPU::setInstanceMatrices(const std::vector<glm::mat4>& matrices)
+	{
+		this->uploadStorage(this->instanceSSBO, this->instanceSSBOCapacity, GPU::INSTANCE_BLOCK_BINDING, matrices.data(), matrices.size() * sizeof(glm::mat4));
 	}
 
 
@@ -692,6 +921,12 @@ namespace vel
 		glDrawElements(GL_TRIANGLES, this->activeMesh->getGpuMesh()->indiceCount, GL_UNSIGNED_INT, 0);
 	}
 
+	void GPU::drawGpuMeshInstanced(uint32_t begin, uint32_t count)
+	{
+		glUniform1i(this->activeShader->uniforms.instanceOffset, (GLint)begin);
+		glDrawElementsInstanced(GL_TRIANGLES, this->activeMesh->getGpuMesh()->indiceCount, GL_UNSIGNED_INT, 0, (GLsizei)count);
+	}
+
     void GPU::enableCubeMapTextures()
     {
         glEnable(GL_TEXTURE_CUBE_MAP_SEAMLESS);
@@ -0,0 +1,154 @@
+#include <chrono>
+
+#include "vel/GpuUploadScheduler.h"
+#include "vel/Profiler.h"
+
+
+namespace vel
+{
+	thread_local GpuUpload::Priority GpuUploadScheduler::threadPriority = GpuUpload::Priority::BLOCKING;
+
+	GpuUploadScheduler::GpuUploadScheduler()
+	{
+		for (size_t i = 0; i < priorityCount; i++)
+		{
+			this->queuedBytes[i].store(0, std::memory_order_relaxed);
+			this->queuedUploads[i].store(0, std::memory_order_relaxed);
+		}
+	}
+
+	void GpuUploadScheduler::setThreadPriority(GpuUpload::Priority p)
+	{
+		GpuUploadScheduler::threadPriority = p;
+	}
+
+	GpuUpload::Priority GpuUploadScheduler::getThreadPriority()
+	{
+		return GpuUploadScheduler::threadPriority;
+	}
+
+	void GpuUploadScheduler::push(GpuUpload u)
+	{
+		this->queuedBytes[(size_t)u.priority].fetch_add(u.remainingBytes, std::memory_order_relaxed);
+		this->queuedUploads[(size_t)u.priority].fetch_add(1, std::memory_order_relaxed);
+		this->incoming.push(u);
+	}
+
+	size_t GpuUploadScheduler::run(double seconds, size_t bytes, const UploadFn& upload)
+	{
+		VEL_ZONE("GpuUploadScheduler::run");
+
+		GpuUpload u;
+		while (this->incoming.pop(u))
+			this->queues[(size_t)u.priority].push_back(u);
+
+		auto start = std::chrono::steady_clock::now();
+		size_t steps = 0;
+		size_t bytesSent = 0;
+
+		for (size_t p = 0; p < priorityCount; p++)
+		{
+			auto& queue = this->queues[p];
+			while (!queue.empty())
+			{
+				auto& next = queue.front();
+
+				if (steps > 0)
+				{
+					if (bytesSent + next.stepBytes > bytes)
+						return steps;
+
+					if (std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count() >= seconds)
+						return steps;
+				}
+
+				size_t remaining = next.remainingBytes;
+				size_t stepBytes = next.stepBytes;
+				auto result = upload(next);
+
+				if (result == GpuUpload::Step::MORE)
+				{
+					this->queuedBytes[p].fetch_sub(remaining - next.remainingBytes, std::memory_order_relaxed);
+				}
+				else
+				{
+					this->queuedBytes[p].fetch_sub(remaining, std::memory_order_relaxed);
+					this->queuedUploads[p].fetch_sub(1, std::memory_order_relaxed);
+					queue.pop_front();
+				}
+
+				if (result != GpuUpload::Step::MISSING)
+				{
+					steps++;
+					bytesSent += stepBytes;
+				}
+			}
+		}
+
+		return steps;
+	}
+
+	size_t GpuUploadScheduler::promote(const std::function<bool(const GpuUpload& u)>& blocking)
+	{
+		GpuUpload u;
+		while (this->incoming.pop(u))
+			this->queues[(size_t)u.priority].push_back(u);
+
+		const size_t target = (size_t)GpuUpload::Priority::BLOCKING;
+		size_t moved = 0;
+
+		for (size_t p = target + 1; p < priorityCount; p++)
+		{
+			auto& queue = this->queues[p];
+			for (auto it = queue.begin(); it != queue.end();)
+			{
+				if (!blocking(*it))
+				{
+					it++;
+					continue;
+				}
+
+				this->queuedBytes[p].fetch_sub(it->remainingBytes, std::memory_order_relaxed);
+				this->queuedUploads[p].fetch_sub(1, std::memory_order_relaxed);
+				this->queuedBytes[target].fetch_add(it->remainingBytes, std::memory_order_relaxed);
+				this->queuedUploads[target].fetch_add(1, std::memory_order_relaxed);
+
+				it->priority = GpuUpload::Priority::BLOCKING;
+				this->queues[target].push_back(*it);
+				it = queue.erase(it);
+				moved++;
+			}
+		}
+
+		return moved;
+	}
+
+	bool GpuUploadScheduler::empty() const
+	{
+		for (auto& q : this->queues)
+			if (!q.empty())
+				return false;
+
+		return this->incoming.empty();
+	}
+
+	size_t GpuUploadScheduler::getQueuedBytes(GpuUpload::Priority p) const
+	{
+		return this->queuedBytes[(size_t)p].load(std::memory_order_relaxed);
+	}
+
+	size_t GpuUploadScheduler::getQueuedBytes() const
+	{
+		size_t total = 0;
+		for (auto& b : this->queuedBytes)
+			total += b.load(std::memory_order_relaxed);
+
+		return total;
+	}
+
+	size_t GpuUploadScheduler::getQueuedUploads(GpuUpload::Priority p) const
+	{
+		return this->queuedUploads[(size_t)p].load(std::memory_order_relaxed);
+	}
+
+}
@@ -0,0 +1,262 @@
+#include <limits>
+#include <cstdint>
+
+#include "vel/JobSystem.h"
+#include "vel/Profiler.h"
+
+
+namespace vel
+{
+	// which JobSystem (if any) the current thread is a worker of, and the index of it's deque
+	static thread_local const JobSystem*	localOwner = nullptr;
+	static thread_local size_t				localIndex = 0;
+
+	/* JobArena
+	--------------------------------------------------*/
+	JobArena& JobArena::local()
+	{
+		static thread_local JobArena arena;
+		return arena;
+	}
+
+	void* JobArena::allocate(size_t bytes, size_t align)
+	{
+		while (true)
+		{
+			if (this->block < this->blocks.size())
+			{
+				auto base = reinterpret_cast<uintptr_t>(this->blocks[this->block].get());
+				uintptr_t aligned = (base + this->offset + align - 1) & ~(uintptr_t)(align - 1);
+				size_t end = (size_t)(aligned - base) + bytes;
+
+				if (end <= this->blockSizes[this->block])
+				{
+					this->offset = end;
+					return reinterpret_cast<void*>(aligned);
+				}
+
+				// current block is exhausted, move on to the next one if it exists and is big enough
+				this->block++;
+				this->offset = 0;
+
+				if (this->block < this->blocks.size() && this->blockSizes[this->block] >= bytes + align)
+					continue;
+			}
+
+			// insert a new block at the current position, blocks after it stay around for reuse
+			size_t size = bytes + align > defaultBlockSize ? bytes + align : defaultBlockSize;
+			this->blocks.insert(this->blocks.begin() + this->block, std::unique_ptr<unsigned char[]>(new unsigned char[size]));
+			this->blockSizes.insert(this->blockSizes.begin() + this->block, size);
+			this->offset = 0;
+		}
+	}
+
+	JobArena::Marker JobArena::mark() const
+	{
+		return Marker{ this->block, this->offset };
+	}
+
+	void JobArena::release(Marker m)
+	{
+		this->block = m.block;
+		this->offset = m.offset;
+	}
+
+	/* JobSystem
+	--------------------------------------------------*/
+	JobSystem::JobSystem(size_t workerThreads)
+	{
+		if (workerThreads == 0)
+		{
+			size_t cores = std::thread::hardware_concurrency();
+			workerThreads = cores > 1 ? cores - 1 : 1;
+		}
+
+		for (size_t i = 0; i < workerThreads + 1; i++)
+			this->queues.push_back(std::make_unique<WorkerQueue>());
+
+		localOwner = this;
+		localIndex = 0;
+
+		for (size_t i = 1; i < workerThreads + 1; i++)
+			this->threads.emplace_back(&JobSystem::workerLoop, this, i);
+	}
+
+	JobSystem::~JobSystem()
+	{
+		{
+			std::lock_guard<std::mutex> lock(this->sleepMutex);
+			this->shutdown = true;
+		}
+		this->sleepCondition.notify_all();
+
+		// jobs still queued at this point are dropped, anything which matters should have been waited on
+		for (auto& t : this->threads)
+			t.join();
+
+		if (localOwner == this)
+			localOwner = nullptr;
+	}
+
+	size_t JobSystem::getThreadCount() const
+	{
+		return this->queues.size();
+	}
+
+	size_t JobSystem::localQueueIndex() const
+	{
+		if (localOwner == this)
+			return localIndex;
+
+		return std::numeric_limits<size_t>::max();
+	}
+
+	void JobSystem::push(Job j)
+	{
+		size_t index = this->localQueueIndex();
+		if (index == std::numeric_limits<size_t>::max())
+			index = this->submitIndex.fetch_add(1, std::memory_order_relaxed) % this->queues.size();
+
+		{
+			std::lock_guard<std::mutex> lock(this->queues[index]->mutex);
+			this->queues[index]->jobs.push_back(std::move(j));
+		}
+		this->queuedJobs.fetch_add(1, std::memory_order_release);
+
+		// taking the sleep lock means a worker can't check queuedJobs and then miss this notify
+		{
+			std::lock_guard<std::mutex> lock(this->sleepMutex);
+		}
+		this->sleepCondition.notify_one();
+	}
+
+	bool JobSystem::tryPop(Job& out)
+	{
+		if (this->queuedJobs.load(std::memory_order_acquire) == 0)
+			return false;
+
+		size_t count = this->queues.size();
+		size_t self = this->localQueueIndex();
+
+		// newest job from our own deque first, it's the most likely to still be in cache
+		if (self < count)
+		{
+			auto& q = *this->queues[self];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (!q.jobs.empty())
+			{
+				out = std::move(q.jobs.back());
+				q.jobs.pop_back();
+				this->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		// otherwise steal the oldest job from someone else
+		size_t start = self < count ? self + 1 : 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			size_t victim = (start + i) % count;
+			if (victim == self)
+				continue;
+
+			auto& q = *this->queues[victim];
+			std::lock_guard<std::mutex> lock(q.mutex);
+			if (!q.jobs.empty())
+			{
+				out = std::move(q.jobs.front());
+				q.jobs.pop_front();
+				this->queuedJobs.fetch_sub(1, std::memory_order_relaxed);
+				return true;
+			}
+		}
+
+		return false;
+	}
+
+	void JobSystem::execute(Job j)
+	{
+		j.fn();
+
+		if (j.signal != nullptr)
+			this->signalDone(j.signal);
+	}
+
+	void JobSystem::signalDone(JobCounter* c)
+	{
+		// the decrement happens under the lock so that wait() can tell when we are done touching the counter,
+		// and so run() either sees it above zero and adds a continuation that ends up in ready, or sees zero
+		std::vector<Job> ready;
+		{
+			std::lock_guard<std::mutex> lock(c->continuationMutex);
+			if (c->pending.fetch_sub(1, std::memory_order_acq_rel) != 1)
+				return;
+
+			ready.swap(c->continuations);
+		}
+
+		for (auto& j : ready)
+			this->push(std::move(j));
+	}
+
+	void JobSystem::run(std::function<void()> fn, JobCounter* signal, JobCounter* dependsOn)
+	{
+		if (signal != nullptr)
+			signal->pending.fetch_add(1, std::memory_order_relaxed);
+
+		Job j{ std::move(fn), signal };
+
+		if (dependsOn != nullptr)
+		{
+			std::lock_guard<std::mutex> lock(dependsOn->continuationMutex);
+			if (dependsOn->pending.load(std::memory_order_acquire) > 0)
+			{
+				dependsOn->continuations.push_back(std::move(j));
+				return;
+			}
+		}
+
+		this->push(std::move(j));
+	}
+
+	void JobSystem::wait(JobCounter& c)
+	{
+		Job j;
+		while (!c.isDone())
+		{
+			if (this->tryPop(j))
+				this->execute(std::move(j));
+			else
+				std::this_thread::yield();
+		}
+
+		// the job which brought the counter to zero may still hold it's lock, the caller is free to destroy
+		// the counter once we return
+		std::lock_guard<std::mutex> lock(c.continuationMutex);
+	}
+
+	void JobSystem::workerLoop(size_t index)
+	{
+		localOwner = this;
+		localIndex = index;
+
+		Profiler::setThreadName("Job worker " + std::to_string(index));
+
+		Job j;
+		while (true)
+		{
+			if (this->tryPop(j))
+			{
+				this->execute(std::move(j));
+				continue;
+			}
+
+			std::unique_lock<std::mutex> lock(this->sleepMutex);
+			this->sleepCondition.wait(lock, [this] { return this->shutdown || this->queuedJobs.load(std::memory_order_acquire) > 0; });
+
+			if (this->shutdown)
+				return;
+		}
+	}
+
+}
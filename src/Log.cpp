@@ -35,6 +35,7 @@ namespace vel
 
     void Log::publishLog()
     {
+        std::lock_guard<std::mutex> lock(this->fileMutex);
         std::ofstream outStream(this->filePath, std::ofstream::trunc);
 
         for (auto& l : this->fileBuffer)
@@ -45,7 +46,9 @@ namespace vel
 
     void Log::toFile(std::string msg)
     {
-        Log::get().fileBuffer.push_back(msg);
+        auto& l = Log::get();
+        std::lock_guard<std::mutex> lock(l.fileMutex);
+        l.fileBuffer.push_back(std::move(msg));
     }
 
     void Log::toCli(std::string msg)
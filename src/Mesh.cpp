@@ -8,7 +8,9 @@ namespace vel
 {
 
     Mesh::Mesh(std::string name) :
-        name(name)
+        name(name),
+		boundsMin(0.0f),
+		boundsMax(0.0f)
     {}
 
 	const std::vector<MeshBone>& Mesh::getBones() const
@@ -31,6 +33,22 @@ namespace vel
 		return this->bones.at(index);
 	}
 
+	void Mesh::setBounds(glm::vec3 min, glm::vec3 max)
+	{
+		this->boundsMin = min;
+		this->boundsMax = max;
+	}
+
+	const glm::vec3& Mesh::getBoundsMin() const
+	{
+		return this->boundsMin;
+	}
+
+	const glm::vec3& Mesh::getBoundsMax() const
+	{
+		return this->boundsMax;
+	}
+
 	glm::mat4 Mesh::getGlobalInverseMatrix()
 	{
 		return this->globalInverseMatrix;
@@ -69,16 +87,31 @@ namespace vel
 		this->vertices = vertices;
 	}
 
+	void Mesh::setVertices(std::vector<Vertex>&& vertices)
+	{
+		this->vertices = std::move(vertices);
+	}
+
 	void Mesh::setIndices(std::vector<unsigned int>& indices)
 	{
 		this->indices = indices;
 	}
 
+	void Mesh::setIndices(std::vector<unsigned int>&& indices)
+	{
+		this->indices = std::move(indices);
+	}
+
 	void Mesh::setBones(std::vector<MeshBone>& bones)
 	{
 		this->bones = bones;
 	}
 
+	void Mesh::setBones(std::vector<MeshBone>&& bones)
+	{
+		this->bones = std::move(bones);
+	}
+
     void Mesh::setGpuMesh(GpuMesh gm)
     {
 		this->gpuMesh = gm;
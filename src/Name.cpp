@@ -0,0 +1,70 @@
+#include <mutex>
+#include <cstdio>
+#include <unordered_map>
+
+#include "vel/Name.h"
+#include "vel/Log.h"
+
+
+namespace vel
+{
+	// function local statics so the table is usable from other static initializers
+	static std::unordered_map<uint64_t, std::string>& internTable()
+	{
+		static std::unordered_map<uint64_t, std::string> table;
+		return table;
+	}
+
+	static std::mutex& internMutex()
+	{
+		static std::mutex m;
+		return m;
+	}
+
+	Name Name::interned(const std::string& s)
+	{
+		uint64_t hash = Name::hashString(s.data(), s.size());
+
+		// names are interned from the main thread and the loading threads
+		std::lock_guard<std::mutex> lock(internMutex());
+
+		auto& table = internTable();
+		auto it = table.find(hash);
+		if (it == table.end())
+			it = table.emplace(hash, s).first;
+		else if (it->second != s)
+			Log::crash("Name::interned(): hash collision between '" + it->second + "' and '" + s + "'");
+
+		// unordered_map nodes are never moved, and interned strings are never modified, so this stays valid
+		return Name(hash, it->second.c_str());
+	}
+
+	const char* Name::lookup(uint64_t hash)
+	{
+		std::lock_guard<std::mutex> lock(internMutex());
+
+		auto& table = internTable();
+		auto it = table.find(hash);
+		return it != table.end() ? it->second.c_str() : nullptr;
+	}
+
+	const char* Name::c_str() const
+	{
+		if (this->text != nullptr)
+			return this->text;
+
+		const char* t = Name::lookup(this->hash);
+		return t != nullptr ? t : "";
+	}
+
+	std::string Name::str() const
+	{
+		const char* t = this->text != nullptr ? this->text : Name::lookup(this->hash);
+		if (t != nullptr)
+			return std::string(t);
+
+		char buffer[20];
+		std::snprintf(buffer, sizeof(buffer), "#%016llx", (unsigned long long)this->hash);
+		return std::string(buffer);
+	}
+}
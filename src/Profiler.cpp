@@ -0,0 +1,208 @@
+#include <fstream>
+#include <chrono>
+#include <algorithm>
+#include <iomanip>
+
+#include "vel/Profiler.h"
+
+
+namespace vel
+{
+	thread_local Profiler::ThreadBuffer* Profiler::local = nullptr;
+
+	Profiler::Profiler() :
+		frameStarts(std::make_unique<std::atomic<int64_t>[]>(Profiler::frameCapacity))
+	{}
+
+	Profiler& Profiler::get()
+	{
+		static Profiler p;
+		return p;
+	}
+
+	int64_t Profiler::now()
+	{
+		return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+	}
+
+	Profiler::ThreadBuffer& Profiler::localBuffer()
+	{
+		if (Profiler::local != nullptr)
+			return *Profiler::local;
+
+		auto& p = Profiler::get();
+		auto b = std::make_shared<ThreadBuffer>();
+
+		{
+			std::lock_guard<std::mutex> lock(p.registryMutex);
+			b->capacity = p.eventsPerThread > 0 ? p.eventsPerThread : 1;
+			b->events = std::make_unique<Event[]>(b->capacity);
+			b->id = (uint32_t)p.buffers.size();
+			b->name = "Thread " + std::to_string(b->id);
+			p.buffers.push_back(b);
+		}
+
+		Profiler::local = b.get();
+
+		return *b;
+	}
+
+	void Profiler::record(const char* name, int64_t start, int64_t end)
+	{
+		auto& b = Profiler::localBuffer();
+
+		uint64_t index = b.written.load(std::memory_order_relaxed);
+		auto& e = b.events[index % b.capacity];
+
+		// a dump reading this slot while we overwrite it sees the fence once it reads any of the new values,
+		// and then sees written >= index, which is how it knows to throw the slot away
+		std::atomic_thread_fence(std::memory_order_release);
+
+		e.name.store(name, std::memory_order_relaxed);
+		e.start.store(start, std::memory_order_relaxed);
+		e.end.store(end, std::memory_order_relaxed);
+
+		b.written.store(index + 1, std::memory_order_release);
+	}
+
+	void Profiler::setEventsPerThread(size_t count)
+	{
+		auto& p = Profiler::get();
+		std::lock_guard<std::mutex> lock(p.registryMutex);
+		p.eventsPerThread = count;
+	}
+
+	void Profiler::setThreadName(std::string name)
+	{
+		auto& b = Profiler::localBuffer();
+		auto& p = Profiler::get();
+		std::lock_guard<std::mutex> lock(p.registryMutex);
+		b.name = std::move(name);
+	}
+
+	// returns a pointer to a copy of name which lives as long as the program, for zones named at runtime
+	const char* Profiler::intern(const std::string& name)
+	{
+		auto& p = Profiler::get();
+
+		{
+			std::shared_lock<std::shared_mutex> lock(p.internMutex);
+			auto it = p.internedNames.find(name);
+			if (it != p.internedNames.end())
+				return it->c_str();
+		}
+
+		std::unique_lock<std::shared_mutex> lock(p.internMutex);
+		return p.internedNames.insert(name).first->c_str();
+	}
+
+	// called by the main loop at the start of every frame, from a single thread
+	void Profiler::markFrame()
+	{
+		auto& p = Profiler::get();
+		uint64_t index = p.frameCount.load(std::memory_order_relaxed);
+		p.frameStarts[index % Profiler::frameCapacity].store(Profiler::now(), std::memory_order_relaxed);
+		p.frameCount.store(index + 1, std::memory_order_release);
+	}
+
+	static std::string escapeJson(const char* s)
+	{
+		std::string out;
+		for (; *s != '\0'; s++)
+		{
+			if (*s == '"' || *s == '\\')
+				out += '\\';
+
+			if ((unsigned char)*s < 0x20)
+				continue;
+
+			out += *s;
+		}
+		return out;
+	}
+
+	// writes every zone which ended during the last frames frames (capped to the last 1024) in chrome's trace
+	// event format, returns false if path could not be opened. Can be called from any thread while zones
+	// are still being recorded
+	bool Profiler::writeChromeTrace(std::string path, size_t frames)
+	{
+		auto& p = Profiler::get();
+
+		uint64_t frameCount = p.frameCount.load(std::memory_order_acquire);
+		frames = std::min({ frames, (size_t)frameCount, Profiler::frameCapacity });
+
+		// with no frames marked yet everything recorded so far is written
+		int64_t from = frames > 0 ? p.frameStarts[(frameCount - frames) % Profiler::frameCapacity].load(std::memory_order_relaxed) : 0;
+
+		struct Zone
+		{
+			const char*	name;
+			int64_t		start;
+			int64_t		end;
+		};
+
+		std::vector<std::shared_ptr<ThreadBuffer>> buffers;
+		std::vector<std::string> names;
+		{
+			std::lock_guard<std::mutex> lock(p.registryMutex);
+			buffers = p.buffers;
+			for (auto& b : buffers)
+				names.push_back(b->name);
+		}
+
+		std::ofstream out(path, std::ofstream::trunc);
+		if (!out.is_open())
+			return false;
+
+		out << std::fixed << std::setprecision(3);
+		out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+		out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"tid\":0,\"args\":{\"name\":\"vellocet3d\"}}";
+
+		auto micros = [from](int64_t ns) { return (double)(ns - from) / 1000.0; };
+
+		for (size_t i = 0; i < frames; i++)
+		{
+			int64_t t = p.frameStarts[(frameCount - frames + i) % Profiler::frameCapacity].load(std::memory_order_relaxed);
+			out << ",\n{\"name\":\"Frame\",\"ph\":\"i\",\"s\":\"g\",\"pid\":1,\"tid\":0,\"ts\":" << micros(t) << "}";
+		}
+
+		std::vector<Zone> zones;
+		for (size_t bi = 0; bi < buffers.size(); bi++)
+		{
+			auto& b = *buffers[bi];
+
+			out << ",\n{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << b.id << ",\"args\":{\"name\":\"" << escapeJson(names[bi].c_str()) << "\"}}";
+
+			uint64_t last = b.written.load(std::memory_order_acquire);
+			uint64_t first = last > b.capacity ? last - b.capacity : 0;
+
+			zones.clear();
+			for (uint64_t i = first; i < last; i++)
+			{
+				auto& e = b.events[i % b.capacity];
+				zones.push_back(Zone{ e.name.load(std::memory_order_relaxed), e.start.load(std::memory_order_relaxed), e.end.load(std::memory_order_relaxed) });
+			}
+
+			// anything the owning thread has started overwriting since we read written may be torn, see record()
+			std::atomic_thread_fence(std::memory_order_acquire);
+			uint64_t overwritten = b.written.load(std::memory_order_relaxed);
+			uint64_t valid = overwritten >= b.capacity ? overwritten - b.capacity + 1 : 0;
+
+			for (uint64_t i = first; i < last; i++)
+			{
+				auto& z = zones[i - first];
+				if (i < valid || z.name == nullptr || z.end < from)
+					continue;
+
+				out << ",\n{\"name\":\"" << escapeJson(z.name) << "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << b.id
+					<< ",\"ts\":" << micros(z.start) << ",\"dur\":" << (double)(z.end - z.start) / 1000.0 << "}";
+			}
+		}
+
+		out << "\n]}\n";
+		out.close();
+
+		return true;
+	}
+
+}
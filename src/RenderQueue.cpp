@@ -0,0 +1,219 @@
+#include <cstring>
+
+#include "vel/RenderQueue.h"
+
+
+namespace vel
+{
+	namespace
+	{
+		// top bits of a multiplicative hash of the pointer, null is always 0
+		uint64_t pointerBits(const void* p, int bits)
+		{
+			if (p == nullptr)
+				return 0;
+
+			return ((uint64_t)(uintptr_t)p * 0x9E3779B97F4A7C15ull) >> (64 - bits);
+		}
+
+		// the sign, exponent and top 2 mantissa bits of a non negative float order the same way as the float,
+		// which gives a coarse logarithmic depth
+		uint64_t depthBits(float depth)
+		{
+			if (!(depth > 0.0f))
+				return 0;
+
+			uint32_t bits;
+			std::memcpy(&bits, &depth, sizeof(bits));
+			return bits >> 21;
+		}
+	}
+
+	size_t RenderQueue::Stats::bindsAvoided() const
+	{
+		return this->draws * 3 + this->iblDraws - this->shaderBinds - this->iblBinds - this->materialBinds - this->meshBinds;
+	}
+
+	void RenderQueue::begin()
+	{
+		this->draws.clear();
+		this->keys[0].clear();
+		this->commands.clear();
+		this->instanceItems.clear();
+		this->stats = Stats();
+	}
+
+	void RenderQueue::push(const Shader* shader, const Cubemap* ibl, const Material* material, const Mesh* mesh, float depth, uint32_t item, Instancing instancing)
+	{
+		this->draws.push_back({ shader, ibl, material, mesh, item, instancing });
+		this->keys[0].push_back(
+			(pointerBits(shader, 14) << 50) |
+			(pointerBits(ibl, 8) << 42) |
+			(pointerBits(material, 16) << 26) |
+			(pointerBits(mesh, 14) << 12) |
+			((uint64_t)(instancing == INSTANCED) << 11) |
+			depthBits(depth));
+	}
+
+	// LSD radix sort of keys[0], 8 bits per pass. Every digit is counted in one read, passes where all keys share
+	// the digit are skipped, which with few shaders and materials is most of them
+	void RenderQueue::sortDraws()
+	{
+		size_t n = this->draws.size();
+		for (size_t b = 0; b < 2; b++)
+		{
+			this->keys[b].resize(n);
+			this->order[b].resize(n);
+		}
+
+		for (size_t i = 0; i < n; i++)
+			this->order[0][i] = (uint32_t)i;
+
+		uint32_t counts[8][256] = {};
+		for (size_t i = 0; i < n; i++)
+		{
+			uint64_t k = this->keys[0][i];
+			for (size_t d = 0; d < 8; d++)
+				counts[d][(k >> (d * 8)) & 0xFF]++;
+		}
+
+		size_t src = 0;
+		for (size_t d = 0; d < 8; d++)
+		{
+			uint64_t digit = (this->keys[src][0] >> (d * 8)) & 0xFF;
+			if (counts[d][digit] == n)
+				continue;
+
+			uint32_t offset = 0;
+			for (size_t b = 0; b < 256; b++)
+			{
+				uint32_t c = counts[d][b];
+				counts[d][b] = offset;
+				offset += c;
+			}
+
+			size_t dst = src ^ 1;
+			for (size_t i = 0; i < n; i++)
+			{
+				uint64_t k = this->keys[src][i];
+				uint32_t to = counts[d][(k >> (d * 8)) & 0xFF]++;
+				this->keys[dst][to] = k;
+				this->order[dst][to] = this->order[src][i];
+			}
+			src = dst;
+		}
+
+		if (src != 0)
+			this->order[0].swap(this->order[1]);
+	}
+
+	std::pair<size_t, size_t> RenderQueue::flush(bool sort)
+	{
+		size_t begin = this->commands.size();
+		size_t n = this->draws.size();
+
+		if (n > 0)
+		{
+			if (sort)
+			{
+				this->sortDraws();
+			}
+			else
+			{
+				this->order[0].resize(n);
+				for (size_t i = 0; i < n; i++)
+					this->order[0][i] = (uint32_t)i;
+			}
+
+			const Draw* current = nullptr;
+			for (size_t i = 0; i < n; i++)
+			{
+				const Draw& d = this->draws[this->order[0][i]];
+
+				// samplers and material uniforms belong to the program, so a new shader needs them set again, only
+				// the vertex array binding carries over
+				bool newShader = current == nullptr || current->shader != d.shader;
+				if (newShader)
+				{
+					this->commands.push_back({ USE_SHADER, d.item });
+					this->stats.shaderBinds++;
+				}
+
+				if (d.ibl != nullptr && (newShader || current->ibl != d.ibl))
+				{
+					this->commands.push_back({ USE_IBL, d.item });
+					this->stats.iblBinds++;
+				}
+
+				if (newShader || current->material != d.material)
+				{
+					this->commands.push_back({ USE_MATERIAL, d.item });
+					this->stats.materialBinds++;
+				}
+
+				if (current == nullptr || current->mesh != d.mesh)
+				{
+					this->commands.push_back({ USE_MESH, d.item });
+					this->stats.meshBinds++;
+				}
+
+				current = &d;
+
+				// the instanced draws sharing all of d's state which follow it, an instanced draw keeps the order of
+				// it's instances so this holds for transparents too
+				size_t run = 1;
+				if (d.instancing == INSTANCED)
+				{
+					while (i + run < n)
+					{
+						const Draw& next = this->draws[this->order[0][i + run]];
+						if (next.instancing != INSTANCED || next.shader != d.shader || next.ibl != d.ibl || next.material != d.material || next.mesh != d.mesh)
+							break;
+						run++;
+					}
+				}
+
+				if (d.instancing != NOT_INSTANCED)
+				{
+					Command c = { DRAW_INSTANCED, d.item, (uint32_t)this->instanceItems.size(), (uint32_t)run };
+					for (size_t r = 0; r < run; r++)
+						this->instanceItems.push_back(this->draws[this->order[0][i + r]].item);
+
+					this->commands.push_back(c);
+					this->stats.instancedDraws++;
+					this->stats.instances += run;
+				}
+				else
+				{
+					this->commands.push_back({ DRAW, d.item });
+				}
+
+				this->stats.draws += run;
+				if (d.ibl != nullptr)
+					this->stats.iblDraws += run;
+				i += run - 1;
+			}
+		}
+
+		this->draws.clear();
+		this->keys[0].clear();
+
+		return { begin, this->commands.size() };
+	}
+
+	const std::vector<RenderQueue::Command>& RenderQueue::getCommands() const
+	{
+		return this->commands;
+	}
+
+	const std::vector<uint32_t>& RenderQueue::getInstanceItems() const
+	{
+		return this->instanceItems;
+	}
+
+	const RenderQueue::Stats& RenderQueue::getStats() const
+	{
+		return this->stats;
+	}
+
+}
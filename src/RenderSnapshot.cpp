@@ -0,0 +1,71 @@
+#include "vel/RenderSnapshot.h"
+
+
+namespace vel
+{
+	void RenderSnapshot::clear()
+	{
+		this->skybox = nullptr;
+		this->debugWorlds.clear();
+		this->stages.clear();
+		this->items.clear();
+		this->nodes.clear();
+		this->nodeTransforms.clear();
+		this->boneTransforms.clear();
+		this->skinBones.clear();
+		this->capturedNodes.clear();
+		this->capturedBones.clear();
+	}
+
+	void RenderSnapshot::resolveMatrices()
+	{
+		static_assert(sizeof(glm::mat4) == 16 * sizeof(float), "TransformBatch writes matrices as 16 packed floats");
+
+		this->boneMatrices.resize(this->boneTransforms.size());
+		this->boneTransforms.interpolate(this->alpha, (float*)this->boneMatrices.data());
+
+		this->localMatrices.resize(this->nodeTransforms.size());
+		this->nodeTransforms.interpolate(this->alpha, (float*)this->localMatrices.data());
+
+		// same rules as Actor::getWorldRenderMatrix(), parents have lower indices so are already resolved
+		this->worldMatrices.resize(this->nodes.size());
+		for (size_t i = 0; i < this->nodes.size(); i++)
+		{
+			auto& n = this->nodes[i];
+			if (!n.interpolate)
+			{
+				this->worldMatrices[i] = n.matrix;
+				continue;
+			}
+
+			const glm::mat4& actorMatrix = n.local >= 0 ? this->localMatrices[n.local] : n.matrix;
+
+			if (n.parentNode >= 0)
+				this->worldMatrices[i] = this->worldMatrices[n.parentNode] * actorMatrix;
+			else if (n.parentBone >= 0)
+				this->worldMatrices[i] = this->boneMatrices[n.parentBone] * actorMatrix;
+			else
+				this->worldMatrices[i] = actorMatrix;
+		}
+
+		// every skinned item's palette ends up contiguous, so it's uploaded in one go
+		this->skinMatrices.resize(this->skinBones.size());
+		for (size_t i = 0; i < this->skinBones.size(); i++)
+			this->skinMatrices[i] = this->boneMatrices[this->skinBones[i].bone] * this->skinBones[i].offsetMatrix;
+	}
+
+	void RenderSnapshot::packTransform(const glm::vec3& t, const glm::quat& r, const glm::vec3& s, float* out)
+	{
+		out[TransformBatch::TX] = t.x;
+		out[TransformBatch::TY] = t.y;
+		out[TransformBatch::TZ] = t.z;
+		out[TransformBatch::RX] = r.x;
+		out[TransformBatch::RY] = r.y;
+		out[TransformBatch::RZ] = r.z;
+		out[TransformBatch::RW] = r.w;
+		out[TransformBatch::SX] = s.x;
+		out[TransformBatch::SY] = s.y;
+		out[TransformBatch::SZ] = s.z;
+	}
+
+}
@@ -3,10 +3,10 @@
 
 #define GLM_FORCE_ALIGNED_GENTYPES
 #include <glm/gtx/string_cast.hpp>
-#include "imgui/imgui.h"
 
 
 #include "vel/App.h"
+#include "vel/Profiler.h"
 #include "vel/Scene.h"
 #include "vel/Vertex.h"
 #include "vel/Texture.h"
@@ -27,12 +27,13 @@ namespace vel
 		mainMemoryloaded(false),
 		swapWhenLoaded(false),
 		animationTime(0.0),
-		fixedAnimationTime(0.0)
+		fixedAnimationTime(0.0),
+		loadProgress(std::make_shared<LoadProgress>())
 	{
-		this->sortedTransparentActors.reserve(1000); // reserve space for 1000 transparent actors (won't reallocate until that limit reached)
+		this->loadFuture = this->loadPromise.get_future().share();
 
 		// create a default camera for scene
-		this->sceneCamera = this->cameras.insert("defaultSceneCamera", Camera(CameraType::PERSPECTIVE, 0.1f, 250.0f, 60.0f));
+		this->sceneCamera = this->cameras.emplace("defaultSceneCamera", CameraType::PERSPECTIVE, 0.1f, 250.0f, 60.0f);
 		this->sceneCamera->setPosition(glm::vec3(0.0f, 2.0f, 0.0f));
 		this->sceneCamera->setLookAt(glm::vec3(0.0f, 0.0f, -1.0f));
 	}
@@ -74,7 +75,7 @@ namespace vel
 
 	Camera* Scene::addCamera(std::string name, Camera c)
 	{
-		return this->cameras.insert(name, c);
+		return this->cameras.insert(Name::interned(name), std::move(c));
 	}
 
 	Camera* Scene::getCamera(std::string name)
@@ -158,9 +159,9 @@ namespace vel
 		{
 			Camera* tmpCamPtr;
 			if (c["type"] == "perspective")
-				tmpCamPtr = this->cameras.insert(c["name"], Camera(CameraType::PERSPECTIVE, c["near"], c["far"], c["fov"]));
+				tmpCamPtr = this->cameras.insert(Name::interned(c["name"]), Camera(CameraType::PERSPECTIVE, c["near"], c["far"], c["fov"]));
 			else if (c["type"] == "orthographic")
-				tmpCamPtr = this->cameras.insert(c["name"], Camera(CameraType::ORTHOGRAPHIC, c["near"], c["far"], c["scale"]));
+				tmpCamPtr = this->cameras.insert(Name::interned(c["name"]), Camera(CameraType::ORTHOGRAPHIC, c["near"], c["far"], c["scale"]));
 #ifdef DEBUG_LOG
 			else
 				Log::crash("Scene::loadConfigFile(): config contains a camera type other than 'perspective' or 'orthographic'");
@@ -240,7 +241,7 @@ namespace vel
 			if (m.contains("heightScale") && m["heightScale"] != "" && !m["heightScale"].is_null())
 				mat.heightScale = m["heightScale"];
 
-			this->addMaterial(mat);
+			this->addMaterial(std::move(mat));
 		}
 
 		// Load renderables
@@ -336,6 +337,9 @@ namespace vel
 
 			if (s.contains("useSceneCameraPositionForLighting") && !s["useSceneCameraPositionForLighting"].is_null())
 				stage->setUseSceneCameraPositionForLighting(s["useSceneCameraPositionForLighting"]);
+
+			if (s.contains("frustumCulling") && !s["frustumCulling"].is_null())
+				stage->setFrustumCulling(s["frustumCulling"]);
 			
 			if (s.contains("activeInfiniteCubemap") && !s["activeInfiniteCubemap"].is_null() && s["activeInfiniteCubemap"] != "")
 				stage->setActiveInfiniteCubemap(this->getInfiniteCubemap(s["activeInfiniteCubemap"]));
@@ -347,7 +351,7 @@ namespace vel
 				act.setDynamic(a["dynamic"]);
 				act.setVisible(a["visible"]);
 				act.setAutoTransform(a["autoTransform"]);
-				act.addRenderable(this->getRenderable(a["renderable"]));//TODO: what if headless?
+				act.addRenderable(this->getRenderable(a["renderable"])); // headless renderables are still registered, just never uploaded
 
 				if (!a["transform"].is_null())
 				{
@@ -404,7 +408,7 @@ namespace vel
 				// must get final memory address of actor in order to pass userptr to rididbody or ghostobject, so we add actor to stage
 				// here, meaning everything above this line would be properties that the actor MUST HAVE before being added to stage,
 				// although at this time a Renderable is all that it needs to have before being added.
-				Actor* pActor = stage->addActor(act);
+				Actor* pActor = stage->addActor(std::move(act));
 
 
 				if (a.contains("collisionWorld") && !a["collisionWorld"].is_null() && a.contains("collisionObject") && !a["collisionObject"].is_null())
@@ -414,19 +418,19 @@ namespace vel
 					if ((a["collisionObject"] != "GENERATE_STATIC_RIGIDBODY") && (a["collisionObject"] != "GENERATE_STATIC_GHOST"))
 					{
 						auto& cot = pActor->getCollisionWorld()->getCollisionObjectTemplate(a["collisionObject"]);
-						auto actorTranslation = pActor->getTransform().getTranslation();
+						auto actorTranslation = static_cast<const Actor*>(pActor)->getTransform().getTranslation();
 
 						btTransform theTransform;
 						theTransform.setIdentity();
 						theTransform.setOrigin(btVector3(actorTranslation.x, actorTranslation.y, actorTranslation.z));
-						theTransform.setRotation(vel::glmToBulletQuat(pActor->getTransform().getRotation()));
+						theTransform.setRotation(vel::glmToBulletQuat(static_cast<const Actor*>(pActor)->getTransform().getRotation()));
 
 						if (cot.type == "rigidBody")
 						{
 							btVector3 theInertia(0.0f, 0.0f, 0.0f);
 							cot.collisionShape->calculateLocalInertia(cot.mass.value(), theInertia);
 
-							btDefaultMotionState* theMotionState = new btDefaultMotionState(theTransform);
+							ActorMotionState* theMotionState = new ActorMotionState(pActor, pActor->getCollisionWorld(), theTransform);
 							btRigidBody::btRigidBodyConstructionInfo theBodyInfo(cot.mass.value(), theMotionState, cot.collisionShape, theInertia);
 
 							// Add support for more properties as needed
@@ -572,22 +576,30 @@ namespace vel
 		if (!this->mainMemoryloaded)
 			return false;
 
-		// there is for sure a better way to handle this, but for the time being
-		// it is what it is until I at least get a working build again
+		// every gpu asset this scene loaded was registered with AssetManager::watchGpuLoad() during
+		// load(), so once main memory loading is done the requested count can no longer grow
+		return this->loadProgress->gpuAssetsUploaded == this->loadProgress->gpuAssetsRequested;
+	}
 
-		for (auto& s : this->shadersInUse)
-			if (!App::get().getAssetManager().shaderIsGpuLoaded(s))
-				return false;
-		
-		for (auto& m : this->meshesInUse)
-			if (!App::get().getAssetManager().meshIsGpuLoaded(m))
-				return false;
+	void Scene::setMainMemoryLoaded()
+	{
+		this->mainMemoryloaded = true;
+		this->loadPromise.set_value();
+	}
+
+	const LoadProgress& Scene::getLoadProgress() const
+	{
+		return *this->loadProgress;
+	}
 
-		for (auto& t : this->texturesInUse)
-			if (!App::get().getAssetManager().textureIsGpuLoaded(t))
-				return false;
+	void Scene::setBlocking()
+	{
+		this->loadProgress->blocking = true;
+	}
 
-		return true;
+	std::shared_future<void> Scene::getLoadFuture() const
+	{
+		return this->loadFuture;
 	}
 
 	CollisionWorld* Scene::addCollisionWorld(std::string name, float gravity)
@@ -595,7 +607,8 @@ namespace vel
 		// for some reason CollisionWorld has to be a pointer or bullet has read access violation issues
 		// delete in destructor
 		CollisionWorld* cw = new CollisionWorld(gravity);
-		this->collisionWorlds.insert(name, cw);
+		this->collisionWorlds.insert(Name::interned(name), cw);
+		this->tickGraphDirty = true;
 
 		return cw;
 	}
@@ -607,32 +620,47 @@ namespace vel
 
 	void Scene::loadShader(std::string name, std::string vertFile, std::string fragFile)
 	{
-		this->shadersInUse.push_back(App::get().getAssetManager().loadShader(name, vertFile, fragFile));
+		auto& am = App::get().getAssetManager();
+		this->shadersInUse.push_back(am.loadShader(name, vertFile, fragFile));
+		this->loadProgress->assetsDecoded++;
+		am.watchGpuLoad(GpuUpload::Type::SHADER, this->shadersInUse.back(), this->loadProgress);
 	}
 	
 	void Scene::loadMesh(std::string path)
 	{
-		auto tts = App::get().getAssetManager().loadMesh(path);
-		for(auto& t : tts.first)
+		auto& am = App::get().getAssetManager();
+		auto tts = am.loadMesh(path);
+		for (auto& t : tts.first)
+		{
 			this->meshesInUse.push_back(t);
+			am.watchGpuLoad(GpuUpload::Type::MESH, t, this->loadProgress);
+		}
 		
 		if(tts.second != "")
 			this->armaturesInUse.push_back(tts.second);
+
+		this->loadProgress->assetsDecoded++;
 	}
 	
 	void Scene::loadTexture(std::string name, std::string type, std::string path, std::vector<std::string> mips)
 	{
-		this->texturesInUse.push_back(App::get().getAssetManager().loadTexture(name, type, path, mips));
+		auto& am = App::get().getAssetManager();
+		this->texturesInUse.push_back(am.loadTexture(name, type, path, mips));
+		this->loadProgress->assetsDecoded++;
+		am.watchGpuLoad(GpuUpload::Type::TEXTURE, this->texturesInUse.back(), this->loadProgress);
 	}
     
     void Scene::loadInfiniteCubemap(std::string name, std::string path)
     {
-        this->infiniteCubemapsInUse.push_back(App::get().getAssetManager().loadInfiniteCubemap(name, path));
+		auto& am = App::get().getAssetManager();
+        this->infiniteCubemapsInUse.push_back(am.loadInfiniteCubemap(name, path));
+		this->loadProgress->assetsDecoded++;
+		am.watchGpuLoad(GpuUpload::Type::INFINITE_CUBEMAP, this->infiniteCubemapsInUse.back(), this->loadProgress);
     }
 	
 	void Scene::addMaterial(Material m)
 	{
-		this->materialsInUse.push_back(App::get().getAssetManager().addMaterial(m));
+		this->materialsInUse.push_back(App::get().getAssetManager().addMaterial(std::move(m)));
 	}
 	
 	void Scene::addRenderable(std::string name, Shader* shader, Mesh* mesh, Material* material)
@@ -640,27 +668,27 @@ namespace vel
 		this->renderablesInUse.push_back(App::get().getAssetManager().addRenderable(name, shader, mesh, material));
 	}
 
-	Shader* Scene::getShader(std::string name)
+	Shader* Scene::getShader(Name name)
 	{
 		return App::get().getAssetManager().getShader(name);
 	}
 
-	Mesh* Scene::getMesh(std::string name)
+	Mesh* Scene::getMesh(Name name)
 	{
 		return App::get().getAssetManager().getMesh(name);
 	}
 
-	Texture* Scene::getTexture(std::string name)
+	Texture* Scene::getTexture(Name name)
 	{
 		return App::get().getAssetManager().getTexture(name);
 	}
     
-    Cubemap* Scene::getInfiniteCubemap(std::string name)
+    Cubemap* Scene::getInfiniteCubemap(Name name)
     {
         return App::get().getAssetManager().getInfiniteCubemap(name);
     }
 
-	Material* Scene::getMaterial(std::string name)
+	Material* Scene::getMaterial(Name name)
 	{
 		return App::get().getAssetManager().getMaterial(name);
 	}
@@ -679,7 +707,8 @@ namespace vel
 	--------------------------------------------------*/
 	Stage* Scene::addStage(std::string name)
 	{
-		return this->stages.insert(name, Stage(name));
+		this->tickGraphDirty = true;
+		return this->stages.emplace(Name::interned(name), name);
 	}
 
 	Stage* Scene::getStage(std::string name)
@@ -688,6 +717,124 @@ namespace vel
 	}
 
 
+	/* Fixed tick
+	--------------------------------------------------*/
+	// the same pipeline as stepPhysics -> applyTransformations -> processSensors -> innerLoop -> updateFixedAnimations
+	// -> postPhysics, but split per stage and per collision world so that work which doesn't conflict runs in parallel
+	void Scene::buildTickGraph()
+	{
+		this->tickGraph.clear();
+
+		std::vector<const void*> worldResources;
+		for (auto cw : this->collisionWorlds.getAll())
+			worldResources.push_back(cw);
+
+		std::vector<const void*> stageResources;
+		for (auto s : this->stages.getAll())
+			stageResources.push_back(s);
+
+		if (this->parallelPhysics)
+		{
+			// every world steps concurrently and matches it's sensors without waiting on any other world. Actors of
+			// any stage may belong to a world, so the previous transforms of all stages are captured first
+			for (auto s : this->stages.getAll())
+				this->tickGraph.addTask("updatePreviousTransforms: " + s->getName(), [s] {
+					s->updatePreviousTransforms();
+				}, {}, { s });
+
+			for (auto cw : this->collisionWorlds.getAll())
+			{
+				// ActorMotionStates write the actors of the stages while stepping, but only those owned by this
+				// world so steps don't conflict with each other
+				this->tickGraph.addTask("stepPhysics", [this, cw] {
+					if (cw->getIsActive())
+						cw->step(this->tickDelta);
+				}, stageResources, { cw });
+
+				this->tickGraph.addTask("matchSensors", [cw] {
+					if (cw->getIsActive())
+						cw->matchSensors();
+				}, {}, { cw });
+			}
+
+			// rigidbodies without an ActorMotionState still have to be polled
+			for (auto s : this->stages.getAll())
+				this->tickGraph.addTask("syncRigidBodyTransforms: " + s->getName(), [s] {
+					s->syncRigidBodyTransforms();
+				}, worldResources, { s });
+		}
+		else
+		{
+			// stepping is chained through this token so worlds step one at a time
+			const void* serialPhysics = &this->collisionWorlds;
+
+			for (auto cw : this->collisionWorlds.getAll())
+				this->tickGraph.addTask("stepPhysics", [this, cw] {
+					if (cw->getIsActive())
+						cw->step(this->tickDelta);
+				}, stageResources, { cw, serialPhysics });
+
+			// actors don't declare which world their rigidbody lives in, so a stage reads them all
+			for (auto s : this->stages.getAll())
+				this->tickGraph.addTask("applyTransformations: " + s->getName(), [s] {
+					s->applyTransformations();
+				}, worldResources, { s });
+
+			for (auto cw : this->collisionWorlds.getAll())
+				this->tickGraph.addTask("matchSensors", [cw] {
+					if (cw->getIsActive())
+						cw->matchSensors();
+				}, {}, { cw });
+		}
+
+		// sensor callbacks are user code which may touch any actor, so they write every stage and run one world at a time
+		for (auto cw : this->collisionWorlds.getAll())
+		{
+			auto writes = stageResources;
+			writes.push_back(cw);
+
+			this->tickGraph.addTask("dispatchSensors", [cw] {
+				if (cw->getIsActive())
+					cw->dispatchSensors();
+			}, {}, writes);
+		}
+
+		this->tickGraph.addMainThreadTask("innerLoop", [this] {
+			this->innerLoop(this->tickDelta);
+		});
+
+		for (auto s : this->stages.getAll())
+			this->tickGraph.addTask("updateFixedAnimations: " + s->getName(), [this, s] {
+				s->updateFixedArmatureAnimations(this->fixedAnimationTime);
+			}, {}, { s });
+
+		this->tickGraph.addMainThreadTask("postPhysics", [this] {
+			this->postPhysics(this->tickDelta);
+		});
+
+		for (auto s : this->stages.getAll())
+			this->tickGraph.addTask("updateWorldMatrices: " + s->getName(), [this, s] {
+				s->updateWorldMatrices(this->collisionWorlds.getAll());
+			}, worldResources, { s });
+
+		this->tickGraphDirty = false;
+	}
+
+	void Scene::fixedTick(double delta)
+	{
+		VEL_ZONE("Scene::fixedTick");
+
+		if (this->tickGraphDirty)
+			this->buildTickGraph();
+
+		this->tickDelta = (float)delta;
+
+		// nothing reads fixedAnimationTime before the animation tasks, so advance it up front
+		this->fixedAnimationTime += delta;
+
+		this->tickGraph.run(App::get().getJobSystem());
+	}
+
 	/* Misc
 	--------------------------------------------------*/
 	void Scene::updateFixedAnimations(double delta)
@@ -711,9 +858,34 @@ namespace vel
 
 	void Scene::stepPhysics(float delta)
 	{
-		for(auto cw : this->collisionWorlds.getAll())
+		auto& worlds = this->collisionWorlds.getAll();
+
+		if (this->parallelPhysics)
+		{
+			App::get().getJobSystem().parallelForEach(worlds, 1, [delta](CollisionWorld* cw) {
+				if (cw->getIsActive())
+					cw->step(delta);
+			});
+			return;
+		}
+
+		for(auto cw : worlds)
 			if(cw->getIsActive())
-				cw->getDynamicsWorld()->stepSimulation(delta, 0);
+				cw->step(delta);
+	}
+
+	// when set, active collision worlds step concurrently and each one syncs it's actors and matches it's sensors
+	// as soon as it has stepped. Separate btDiscreteDynamicsWorlds share no state (the contact added callback
+	// installed for static bodies is stateless), so this only requires that worlds don't share collision shapes
+	void Scene::setParallelPhysics(bool b)
+	{
+		this->parallelPhysics = b;
+		this->tickGraphDirty = true;
+	}
+
+	bool Scene::getParallelPhysics() const
+	{
+		return this->parallelPhysics;
 	}
 
 	void Scene::postPhysics(float delta) {}
@@ -733,28 +905,35 @@ namespace vel
 
 	void Scene::draw(float alpha)
 	{
-		//Log::toCli("----------------------------------------------------");
-		//Log::toCli("NEW RENDER PASS");
-		//Log::toCli("----------------------------------------------------");
+		this->captureRenderSnapshot(this->renderSnapshot, alpha);
+		this->drawSnapshot(this->renderSnapshot);
+	}
 
-		auto gpu = App::get().getGPU(); // for convenience
+	// copies everything needed to draw the current state of the scene into snap, must not overlap a fixed tick
+	void Scene::captureRenderSnapshot(RenderSnapshot& snap, float alpha)
+	{
+		VEL_ZONE("Scene::captureRenderSnapshot");
 
-        gpu->disableBlend(); // disable blending for opaque objects
+		snap.clear();
+		snap.alpha = alpha;
 
 		// set scene camera values
 		this->sceneCamera->update();
-		this->cameraPosition = this->sceneCamera->getPosition();
-		this->cameraProjectionMatrix = this->sceneCamera->getProjectionMatrix();
-		this->cameraViewMatrix = this->sceneCamera->getViewMatrix();
+		glm::vec3 cameraPosition = this->sceneCamera->getPosition();
+		glm::mat4 cameraProjectionMatrix = this->sceneCamera->getProjectionMatrix();
+		glm::mat4 cameraViewMatrix = this->sceneCamera->getViewMatrix();
 		// these are for applying lighting to objects that are in screen space as if they were in world space, for example
 		// first person arms / weapons (allows us to use the view matrix of one camera only for lighting), set to scene camera defaults here
 		// only relevant for when stage has it's own camera AND useSceneCameraPositionForLighting is set to true
-		this->renderCameraPosition = this->cameraPosition;
-		this->renderCameraOffset = glm::mat4(1.0f);
+		glm::vec3 renderCameraPosition = cameraPosition;
+		glm::mat4 renderCameraOffset = glm::mat4(1.0f);
+
+		snap.projection = cameraProjectionMatrix;
+		snap.view = cameraViewMatrix;
 
 		// draw cubemap skybox if we should
 		if (this->getDrawSkybox() && this->getActiveInfiniteCubemap() != nullptr)
-			gpu->drawSkybox(this->cameraProjectionMatrix, this->cameraViewMatrix, this->getActiveInfiniteCubemap()->envCubemap);
+			snap.skybox = this->getActiveInfiniteCubemap();
 
 		// debug draw collision world
 #ifdef DEBUG_LOG
@@ -763,164 +942,324 @@ namespace vel
 			if (cw->getIsActive() && cw->getDebugDrawer() != nullptr)
 			{
 				cw->getDynamicsWorld()->debugDrawWorld(); // load vertices into associated CollisionDebugDrawer
-				gpu->useShader(cw->getDebugDrawer()->getShaderProgram());
-				gpu->setShaderMat4("vp", cw->getCamera()->getProjectionMatrix() * cw->getCamera()->getViewMatrix());
-				gpu->debugDrawCollisionWorld(cw->getDebugDrawer()); // draw all loaded vertices with a single call and clear
+				snap.debugWorlds.push_back({ cw->getDebugDrawer(), cw->getCamera()->getProjectionMatrix() * cw->getCamera()->getViewMatrix() });
 			}
 		}
 #endif
-		
+
 		// loop through all stages
 		for (auto s : this->stages.getAll())
 		{
 			if (!s->isVisible())
 				continue;
 
-			// send render mode used for this stage to gpu
-			gpu->setCurrentRenderMode(s->getRenderMode());
-
-			// clear depth buffer if flag set in stage
-			if (s->getClearDepthBuffer())
-				gpu->clearDepthBuffer();
-
 			// if stage has camera, use stage camera values
 			if (s->getCamera() != nullptr)
 			{
 				s->getCamera()->update();
-				this->cameraPosition = s->getCamera()->getPosition();
-				this->cameraProjectionMatrix = s->getCamera()->getProjectionMatrix();
-				this->cameraViewMatrix = s->getCamera()->getViewMatrix();
+				cameraPosition = s->getCamera()->getPosition();
+				cameraProjectionMatrix = s->getCamera()->getProjectionMatrix();
+				cameraViewMatrix = s->getCamera()->getViewMatrix();
 
 				// these are for applying lighting to objects that are in screen space as if they were in world space, for example
 				// first person arms / weapons (allows us to use the view matrix of one camera only for lighting)
-				this->renderCameraPosition = s->getUseSceneCameraPositionForLighting() == false ? this->cameraPosition : this->sceneCamera->getPosition();
-				this->renderCameraOffset = s->getUseSceneCameraPositionForLighting() == false ? glm::mat4(1.0f) : glm::inverse(this->sceneCamera->getViewMatrix());
+				renderCameraPosition = s->getUseSceneCameraPositionForLighting() == false ? cameraPosition : this->sceneCamera->getPosition();
+				renderCameraOffset = s->getUseSceneCameraPositionForLighting() == false ? glm::mat4(1.0f) : glm::inverse(this->sceneCamera->getViewMatrix());
+			}
+
+			RenderSnapshot::StagePass pass;
+#ifdef PROFILE_ZONES
+			pass.name = Profiler::intern(s->getName());
+#else
+			pass.name = nullptr;
+#endif
+			pass.renderMode = s->getRenderMode();
+			pass.clearDepthBuffer = s->getClearDepthBuffer();
+			pass.cameraPosition = cameraPosition;
+			pass.projection = cameraProjectionMatrix;
+			pass.view = cameraViewMatrix;
+			pass.renderCameraPosition = renderCameraPosition;
+			pass.renderCameraOffset = renderCameraOffset;
+
+			pass.ibl = nullptr;
+			if (s->getRenderMode() == RenderMode::PBR_IBL)
+			{
+				if (s->getActiveInfiniteCubemap() != nullptr)
+					pass.ibl = s->getActiveInfiniteCubemap();
+				else if (this->activeInfiniteCubemap != nullptr)
+					pass.ibl = this->activeInfiniteCubemap;
+				else
+					pass.ibl = App::get().getAssetManager().getInfiniteCubemap("defaultCubemap");
 			}
 
+			// only actors inside the frustum of the camera this stage is drawn with are captured
+			s->cull(s->getCamera() != nullptr ? s->getCamera()->getFrustumPlanes() : this->sceneCamera->getFrustumPlanes());
+			auto& renderables = s->getRenderables();
 
-			std::vector<Renderable*> transparentRenderables;
-			
-			for(auto r : s->getRenderables())
+			// opaques first, in renderable order so consecutive items share gpu state
+			pass.opaqueBegin = snap.items.size();
+			for (size_t i = 0; i < renderables.size(); i++)
 			{
-				if (r->getMaterialHasAlpha())
-				{
-					transparentRenderables.push_back(r); //TODO this reallocates on every insert
+				if (renderables[i]->getMaterialHasAlpha())
 					continue;
-				}
 
-				// DRAW OPAQUES
+				auto visible = s->getVisibleActors(i);
+				for (auto a = visible.first; a != visible.second; a++)
+					this->captureItem(snap, renderables[i], *a);
+			}
+			pass.opaqueEnd = snap.items.size();
 
-				// RESET GPU STATE FOR THIS RENDERABLE
-				gpu->useShader(r->getShader());
+			// then transparents, already back to front
+			pass.transparentBegin = snap.items.size();
+			for (auto& t : s->sortTransparents(cameraPosition))
+				this->captureItem(snap, t.renderable, t.actor);
+			pass.transparentEnd = snap.items.size();
 
-				if(s->getRenderMode() == RenderMode::PBR_IBL)
-					if(s->getActiveInfiniteCubemap() != nullptr)
-						gpu->useIBL(s->getActiveInfiniteCubemap());
-					else if(this->activeInfiniteCubemap != nullptr)
-						gpu->useIBL(this->activeInfiniteCubemap);
-					else
-						gpu->useIBL(App::get().getAssetManager().getInfiniteCubemap("defaultCubemap"));
+			snap.stages.push_back(pass);
+		}
+	}
 
-				gpu->useMesh(r->getMesh());
-				gpu->useMaterial(r->getMaterial());
-					
-				for (auto a : r->actors.getAll())
-					this->drawActor(a, alpha);
+	void Scene::captureItem(RenderSnapshot& snap, Renderable* r, Actor* a)
+	{
+		if (!a->isVisible())
+			return;
+
+		RenderSnapshot::Item item;
+		item.shader = r->getShader();
+		item.mesh = r->getMesh();
+		item.material = r->getMaterial();
+		item.node = this->captureNode(snap, a);
+		item.skinBegin = (uint32_t)snap.skinBones.size();
+
+		// If this actor is animated, keep the bone transforms of it's armature for the shader
+		if (a->isAnimated())
+		{
+			auto mesh = a->getMesh();
+			auto armature = a->getArmature();
+			bool interpolate = armature->getShouldInterpolate();
+
+			size_t boneIndex = 0;
+			for (auto& activeBone : a->getActiveBones())
+			{
+				uint32_t bone = this->captureBone(snap, armature->getBone(activeBone.first), interpolate);
+				snap.skinBones.push_back({ bone, mesh->getBone(boneIndex).offsetMatrix });
+				boneIndex++;
 			}
+		}
 
+		item.skinEnd = (uint32_t)snap.skinBones.size();
+		snap.items.push_back(item);
+	}
 
-			// DRAW TRANSPARENTS/TRANSLUCENTS
+	uint32_t Scene::captureNode(RenderSnapshot& snap, Actor* a)
+	{
+		auto captured = snap.capturedNodes.find(a);
+		if (captured != snap.capturedNodes.end())
+			return captured->second;
 
-			// TODO: not proud of this, but it gets the job done for the time being (can't use map since there's a chance keys could be the same,
-			// not that using map would make this anymore acceptable for a performance crucial application)
-            gpu->enableBlend();
-			this->sortedTransparentActors.clear();
-			for (auto& r : transparentRenderables)
+		RenderSnapshot::Node n;
+
+		// mirrors Actor::getWorldRenderMatrix(), actors which aren't interpolated are drawn at their world matrix
+		n.interpolate = a->isDynamic() && a->getPreviousTransform().has_value();
+		if (!n.interpolate)
+		{
+			n.matrix = a->getWorldMatrix();
+		}
+		else
+		{
+			auto& previous = a->getPreviousTransform().value();
+			auto& current = static_cast<const Actor*>(a)->getTransform();
+
+			// only moving actors go through the batch, the rest keep their cached local matrix
+			if (previous != current)
 			{
-				for (auto a : r->actors.getAll())
-				{
-					float dist = glm::length(this->cameraPosition - a->getTransform().getTranslation());
-					this->sortedTransparentActors.push_back(std::pair<float, Actor*>(dist, a));
-				}
+				float p[TransformBatch::COUNT];
+				float c[TransformBatch::COUNT];
+				RenderSnapshot::packTransform(previous.getTranslation(), previous.getRotation(), previous.getScale(), p);
+				RenderSnapshot::packTransform(current.getTranslation(), current.getRotation(), current.getScale(), c);
+				n.local = (int32_t)snap.nodeTransforms.push(p, c);
 			}
-				
-			std::sort(sortedTransparentActors.begin(), sortedTransparentActors.end(), [](auto &left, auto &right) {
-				return left.first < right.first;
-			});
-
-			for (std::vector<std::pair<float, Actor*>>::reverse_iterator it = sortedTransparentActors.rbegin(); it != sortedTransparentActors.rend(); ++it)
+			else
 			{
-				// Reset gpu state for this ACTOR and draw
-				auto r = it->second->getStageRenderable().value();
+				n.matrix = current.getMatrix();
+			}
 
-				gpu->useShader(r->getShader());
+			// bone parenting takes precedence over actor parenting, as in Actor::getWorldRenderMatrix()
+			if (a->getParentArmatureBone() != nullptr)
+				n.parentBone = (int32_t)this->captureBone(snap, *a->getParentArmatureBone(), a->getParentArmatureBone()->parentArmature->getShouldInterpolate());
+			else if (a->getParentActor() != nullptr)
+				n.parentNode = (int32_t)this->captureNode(snap, a->getParentActor());
+		}
 
-				if (s->getRenderMode() == RenderMode::PBR_IBL)
-					if (s->getActiveInfiniteCubemap() != nullptr)
-						gpu->useIBL(s->getActiveInfiniteCubemap());
-					else if (this->activeInfiniteCubemap != nullptr)
-						gpu->useIBL(this->activeInfiniteCubemap);
-					else
-						gpu->useIBL(App::get().getAssetManager().getInfiniteCubemap("defaultCubemap"));
+		snap.nodes.push_back(n);
 
-				gpu->useMesh(r->getMesh());
-				gpu->useMaterial(r->getMaterial());
+		uint32_t index = (uint32_t)(snap.nodes.size() - 1);
+		snap.capturedNodes.emplace(a, index);
+		return index;
+	}
+
+	uint32_t Scene::captureBone(RenderSnapshot& snap, ArmatureBone& b, bool interpolate)
+	{
+		auto captured = snap.capturedBones.find(&b);
+		if (captured != snap.capturedBones.end())
+			return captured->second;
+
+		float p[TransformBatch::COUNT];
+		float c[TransformBatch::COUNT];
+		RenderSnapshot::packTransform(b.translation, b.rotation, b.scale, c);
+
+		if (interpolate)
+			RenderSnapshot::packTransform(b.previousTranslation, b.previousRotation, b.previousScale, p);
+
+		uint32_t index = snap.boneTransforms.push(interpolate ? p : c, c);
+		snap.capturedBones.emplace(&b, index);
+		return index;
+	}
+
+	// only touches snap, the gpu and renderStats, so can run while the next fixed tick updates the scene
+	void Scene::drawSnapshot(RenderSnapshot& snap)
+	{
+#ifndef HEADLESS_BUILD
+		//Log::toCli("----------------------------------------------------");
+		//Log::toCli("NEW RENDER PASS");
+		//Log::toCli("----------------------------------------------------");
+
+		VEL_ZONE("Scene::draw");
+
+		auto gpu = App::get().getGPU(); // for convenience
+
+		snap.resolveMatrices();
+		gpu->setBonePalette(snap.skinMatrices);
+		snap.renderQueue.begin();
+
+        gpu->disableBlend(); // disable blending for opaque objects
+
+		// draw cubemap skybox if we should
+		if (snap.skybox != nullptr)
+			gpu->drawSkybox(snap.projection, snap.view, snap.skybox->envCubemap);
+
+		// debug draw collision worlds, vertices were loaded into each CollisionDebugDrawer during capture
+		for (auto& dw : snap.debugWorlds)
+		{
+			gpu->useShader(dw.drawer->getShaderProgram());
+			gpu->setShaderMat4("vp", dw.vp);
+			gpu->debugDrawCollisionWorld(dw.drawer); // draw all loaded vertices with a single call and clear
+		}
+		
+		// every stage's commands are built first, so the model matrices of all instanced draws go up in one upload
+		for (auto& pass : snap.stages)
+		{
+			// opaques, grouped by gpu state and front to back within it
+			for (size_t i = pass.opaqueBegin; i < pass.opaqueEnd; i++)
+			{
+				auto& item = snap.items[i];
+				glm::vec3 toItem = glm::vec3(snap.worldMatrices[item.node][3]) - pass.cameraPosition;
+				snap.renderQueue.push(item.shader, pass.ibl, item.material, item.mesh, glm::dot(toItem, toItem), (uint32_t)i, this->instancing(item));
+			}
+			pass.opaqueCommands = snap.renderQueue.flush(true);
 
-				this->drawActor(it->second, alpha);
+			// transparents/translucents, captured back to front
+			for (size_t i = pass.transparentBegin; i < pass.transparentEnd; i++)
+			{
+				auto& item = snap.items[i];
+				snap.renderQueue.push(item.shader, pass.ibl, item.material, item.mesh, 0.0f, (uint32_t)i, this->instancing(item));
 			}
-            
+			pass.transparentCommands = snap.renderQueue.flush(false);
 		}
 
+		auto& instanceItems = snap.renderQueue.getInstanceItems();
+		snap.instanceMatrices.resize(instanceItems.size());
+		for (size_t i = 0; i < instanceItems.size(); i++)
+			snap.instanceMatrices[i] = snap.worldMatrices[snap.items[instanceItems[i]].node];
+		gpu->setInstanceMatrices(snap.instanceMatrices);
+
+		for (auto& pass : snap.stages)
+		{
+			VEL_ZONE(pass.name);
+
+			// send render mode used for this stage to gpu
+			gpu->setCurrentRenderMode(pass.renderMode);
+
+			// clear depth buffer if flag set in stage
+			if (pass.clearDepthBuffer)
+				gpu->clearDepthBuffer();
+
+			// camera is constant over the stage, uploaded once here rather than per draw
+			gpu->setCamera(pass.projection, pass.view, pass.renderCameraPosition, pass.renderCameraOffset);
+
+			// DRAW OPAQUES
+			this->runRenderCommands(snap, pass, pass.opaqueCommands);
+
+			// DRAW TRANSPARENTS/TRANSLUCENTS
+            gpu->enableBlend();
+			this->runRenderCommands(snap, pass, pass.transparentCommands);
+		}
+
+		this->renderStats = snap.renderQueue.getStats();
+#endif
 	}
 
-	void Scene::drawActor(Actor* a, float alphaTime)
+	// shaders reading instance matrices always draw through them, a skinned item's palette is it's own though
+	RenderQueue::Instancing Scene::instancing(const RenderSnapshot::Item& item)
 	{
-		auto gpu = App::get().getGPU();
+		if (!item.shader->instanceBlock)
+			return RenderQueue::NOT_INSTANCED;
 
-		if (a->isVisible())
-		{
-			gpu->setShaderVec3("camPos", this->renderCameraPosition);
-			gpu->setShaderMat4("camOffset", this->renderCameraOffset);
+		return item.skinBegin == item.skinEnd ? RenderQueue::INSTANCED : RenderQueue::INSTANCED_ALONE;
+	}
 
-            gpu->setShaderMat4("projection", this->cameraProjectionMatrix);
-            gpu->setShaderMat4("view", this->cameraViewMatrix);
-            gpu->setShaderMat4("model", a->getWorldRenderMatrix(alphaTime));
+	const RenderQueue::Stats& Scene::getRenderStats() const
+	{
+		return this->renderStats;
+	}
 
-			// If this actor is animated, send the bone transforms of it's armature to the shader
-			if (a->isAnimated())
+	void Scene::runRenderCommands(const RenderSnapshot& snap, const RenderSnapshot::StagePass& pass, std::pair<size_t, size_t> commands)
+	{
+#ifndef HEADLESS_BUILD
+		auto gpu = App::get().getGPU();
+		auto& list = snap.renderQueue.getCommands();
+
+		for (size_t c = commands.first; c < commands.second; c++)
+		{
+			auto& item = snap.items[list[c].item];
+			switch (list[c].op)
 			{
-				auto mesh = a->getMesh();
-				auto armature = a->getArmature();
+			case RenderQueue::USE_SHADER:
+				gpu->useShader(item.shader);
+				gpu->applyCamera();
+				break;
+			case RenderQueue::USE_IBL:
+				gpu->useIBL(pass.ibl);
+				break;
+			case RenderQueue::USE_MATERIAL:
+				gpu->useMaterial(item.material);
+				break;
+			case RenderQueue::USE_MESH:
+				gpu->useMesh(item.mesh);
+				break;
+			case RenderQueue::DRAW:
+				this->drawItem(snap, item);
+				break;
+			case RenderQueue::DRAW_INSTANCED:
+				gpu->useBones(snap.skinMatrices, item.skinBegin, item.skinEnd); // only ever alone when skinned
+				gpu->drawGpuMeshInstanced(list[c].instanceBegin, list[c].instanceCount);
+				break;
+			}
+		}
+#endif
+	}
 
-				size_t boneIndex = 0;
-				if (armature->getShouldInterpolate())
-				{
-					for (auto& activeBone : a->getActiveBones())
-					{
-						//std::cout << activeBone.second << std::endl;
+	void Scene::drawItem(const RenderSnapshot& snap, const RenderSnapshot::Item& item)
+	{
+#ifndef HEADLESS_BUILD
+		auto gpu = App::get().getGPU();
 
-						// global inverse matrix does not seem to make any difference
-						//glm::mat4 meshBoneTransform = mesh->getGlobalInverseMatrix() * armature->getBone(activeBone.first).getRenderMatrixInterpolated(alphaTime) * mesh->getBone(boneIndex).offsetMatrix;
-						glm::mat4 meshBoneTransform = armature->getBone(activeBone.first).getRenderMatrixInterpolated(alphaTime) * mesh->getBone(boneIndex).offsetMatrix;
-						gpu->setShaderMat4(activeBone.second, meshBoneTransform);
-						boneIndex++;
-					}
-				}
-				else
-				{
-					for (auto& activeBone : a->getActiveBones())
-					{
-						//glm::mat4 meshBoneTransform = mesh->getGlobalInverseMatrix() * armature->getBone(activeBone.first).getRenderMatrix() * mesh->getBone(boneIndex).offsetMatrix;
-						glm::mat4 meshBoneTransform = armature->getBone(activeBone.first).getRenderMatrix() * mesh->getBone(boneIndex).offsetMatrix;
-						gpu->setShaderMat4(activeBone.second, meshBoneTransform);
-						boneIndex++;
-					}
-				}
+		gpu->setShaderMat4(item.shader->uniforms.model, snap.worldMatrices[item.node]);
 
-				
-			}
+		// If this item is animated, point the shader at it's armature's palette
+		gpu->useBones(snap.skinMatrices, item.skinBegin, item.skinEnd);
 
-			gpu->drawGpuMesh();
-		}
+		gpu->drawGpuMesh();
+#endif
 	}
-}
\ No newline at end of file
+}
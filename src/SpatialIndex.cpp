@@ -0,0 +1,325 @@
+#include <cmath>
+#include <algorithm>
+#include <utility>
+
+#include "vel/SpatialIndex.h"
+
+
+namespace vel
+{
+	namespace
+	{
+		// 21 bits per axis, cells further out than this are clamped onto the outermost ones
+		const int32_t CELL_LIMIT = (1 << 20) - 1;
+
+		float distanceSquared(const glm::vec3& p, const glm::vec3& min, const glm::vec3& max)
+		{
+			glm::vec3 d = glm::max(glm::max(min - p, p - max), glm::vec3(0.0f));
+			return glm::dot(d, d);
+		}
+
+		bool overlaps(const glm::vec3& aMin, const glm::vec3& aMax, const glm::vec3& bMin, const glm::vec3& bMax)
+		{
+			return aMin.x <= bMax.x && aMax.x >= bMin.x &&
+				aMin.y <= bMax.y && aMax.y >= bMin.y &&
+				aMin.z <= bMax.z && aMax.z >= bMin.z;
+		}
+
+		// false if the box is entirely behind any plane (tests the corner furthest along each plane's normal)
+		bool inFrustum(const std::array<glm::vec4, 6>& planes, const glm::vec3& min, const glm::vec3& max)
+		{
+			for (auto& p : planes)
+			{
+				glm::vec3 positive(p.x >= 0.0f ? max.x : min.x, p.y >= 0.0f ? max.y : min.y, p.z >= 0.0f ? max.z : min.z);
+				if (p.x * positive.x + p.y * positive.y + p.z * positive.z + p.w < 0.0f)
+					return false;
+			}
+			return true;
+		}
+
+		// per thread scratch for queryNearest() so concurrent queries don't allocate once warmed up
+		thread_local std::vector<std::pair<float, Actor*>> nearestScratch;
+	}
+
+	SpatialIndex::SpatialIndex(float cellSize) :
+		cellSize(cellSize)
+	{}
+
+	int32_t SpatialIndex::cellCoordinate(float v) const
+	{
+		float c = std::floor(v / this->cellSize);
+		if (!(c > (float)-CELL_LIMIT)) // also catches nan
+			return -CELL_LIMIT;
+		if (c > (float)CELL_LIMIT)
+			return CELL_LIMIT;
+		return (int32_t)c;
+	}
+
+	uint64_t SpatialIndex::cellKey(int32_t x, int32_t y, int32_t z) const
+	{
+		const uint64_t mask = (1u << 21) - 1;
+		return (((uint64_t)(x + CELL_LIMIT) & mask) << 42) | (((uint64_t)(y + CELL_LIMIT) & mask) << 21) | ((uint64_t)(z + CELL_LIMIT) & mask);
+	}
+
+	glm::ivec3 SpatialIndex::cellFromKey(uint64_t key) const
+	{
+		const uint64_t mask = (1u << 21) - 1;
+		return glm::ivec3((int32_t)((key >> 42) & mask) - CELL_LIMIT, (int32_t)((key >> 21) & mask) - CELL_LIMIT, (int32_t)(key & mask) - CELL_LIMIT);
+	}
+
+	void SpatialIndex::unlink(Entry& e)
+	{
+		auto& list = e.oversized ? this->oversized : this->cells[e.cell];
+
+		// swap the last entry of the list into this one's slot
+		uint32_t last = list.back();
+		list[e.slot] = last;
+		this->entries[last].slot = e.slot;
+		list.pop_back();
+
+		if (!e.oversized && list.empty())
+			this->cells.erase(e.cell);
+
+		e.cell = NO_CELL;
+	}
+
+	void SpatialIndex::link(uint32_t id)
+	{
+		auto& e = this->entries[id];
+		glm::vec3 extent = e.max - e.min;
+		e.oversized = extent.x > this->cellSize || extent.y > this->cellSize || extent.z > this->cellSize;
+
+		if (e.oversized)
+		{
+			e.cell = NO_CELL;
+			e.slot = (uint32_t)this->oversized.size();
+			this->oversized.push_back(id);
+			return;
+		}
+
+		glm::vec3 center = (e.min + e.max) * 0.5f;
+		e.cell = this->cellKey(this->cellCoordinate(center.x), this->cellCoordinate(center.y), this->cellCoordinate(center.z));
+
+		auto& list = this->cells[e.cell];
+		e.slot = (uint32_t)list.size();
+		list.push_back(id);
+	}
+
+	void SpatialIndex::setCellSize(float cellSize)
+	{
+		this->cellSize = cellSize;
+		this->cells.clear();
+		this->oversized.clear();
+
+		for (auto& it : this->entryOf)
+			this->link(it.second);
+	}
+
+	float SpatialIndex::getCellSize() const
+	{
+		return this->cellSize;
+	}
+
+	void SpatialIndex::update(Actor* a, const glm::vec3& min, const glm::vec3& max)
+	{
+		auto it = this->entryOf.find(a);
+		if (it == this->entryOf.end())
+		{
+			uint32_t id;
+			if (!this->freeEntries.empty())
+			{
+				id = this->freeEntries.back();
+				this->freeEntries.pop_back();
+			}
+			else
+			{
+				id = (uint32_t)this->entries.size();
+				this->entries.push_back(Entry());
+			}
+
+			this->entries[id] = { a, min, max, NO_CELL, false, 0 };
+			this->entryOf[a] = id;
+			this->link(id);
+			return;
+		}
+
+		auto& e = this->entries[it->second];
+		e.min = min;
+		e.max = max;
+
+		// most updates are small moves which stay within the same cell
+		glm::vec3 extent = max - min;
+		bool oversized = extent.x > this->cellSize || extent.y > this->cellSize || extent.z > this->cellSize;
+		if (!oversized && !e.oversized)
+		{
+			glm::vec3 center = (min + max) * 0.5f;
+			if (this->cellKey(this->cellCoordinate(center.x), this->cellCoordinate(center.y), this->cellCoordinate(center.z)) == e.cell)
+				return;
+		}
+		else if (oversized && e.oversized)
+		{
+			return;
+		}
+
+		this->unlink(e);
+		this->link(it->second);
+	}
+
+	void SpatialIndex::remove(Actor* a)
+	{
+		auto it = this->entryOf.find(a);
+		if (it == this->entryOf.end())
+			return;
+
+		auto& e = this->entries[it->second];
+		this->unlink(e);
+		e.actor = nullptr;
+
+		this->freeEntries.push_back(it->second);
+		this->entryOf.erase(it);
+	}
+
+	bool SpatialIndex::contains(Actor* a) const
+	{
+		return this->entryOf.count(a) > 0;
+	}
+
+	size_t SpatialIndex::size() const
+	{
+		return this->entryOf.size();
+	}
+
+	void SpatialIndex::clear()
+	{
+		this->entries.clear();
+		this->freeEntries.clear();
+		this->entryOf.clear();
+		this->cells.clear();
+		this->oversized.clear();
+	}
+
+	template<typename Fn>
+	void SpatialIndex::forEachCandidate(const glm::vec3& min, const glm::vec3& max, Fn&& fn) const
+	{
+		for (auto id : this->oversized)
+			fn(this->entries[id]);
+
+		if (this->cells.empty())
+			return;
+
+		// anything in a cell reaches at most half a cell outside of it
+		glm::vec3 loose(this->cellSize * 0.5f);
+		glm::vec3 lo = min - loose;
+		glm::vec3 hi = max + loose;
+
+		int32_t x0 = this->cellCoordinate(lo.x), y0 = this->cellCoordinate(lo.y), z0 = this->cellCoordinate(lo.z);
+		int32_t x1 = this->cellCoordinate(hi.x), y1 = this->cellCoordinate(hi.y), z1 = this->cellCoordinate(hi.z);
+
+		double covered = ((double)x1 - x0 + 1) * ((double)y1 - y0 + 1) * ((double)z1 - z0 + 1);
+		if (covered > (double)this->cells.size())
+		{
+			for (auto& cell : this->cells)
+			{
+				glm::ivec3 c = this->cellFromKey(cell.first);
+				if (c.x < x0 || c.x > x1 || c.y < y0 || c.y > y1 || c.z < z0 || c.z > z1)
+					continue;
+
+				for (auto id : cell.second)
+					fn(this->entries[id]);
+			}
+			return;
+		}
+
+		for (int32_t x = x0; x <= x1; x++)
+			for (int32_t y = y0; y <= y1; y++)
+				for (int32_t z = z0; z <= z1; z++)
+				{
+					auto it = this->cells.find(this->cellKey(x, y, z));
+					if (it == this->cells.end())
+						continue;
+
+					for (auto id : it->second)
+						fn(this->entries[id]);
+				}
+	}
+
+	void SpatialIndex::querySphere(const glm::vec3& center, float radius, std::vector<Actor*>& out) const
+	{
+		out.clear();
+
+		float radiusSquared = radius * radius;
+		this->forEachCandidate(center - glm::vec3(radius), center + glm::vec3(radius), [&](const Entry& e) {
+			if (distanceSquared(center, e.min, e.max) <= radiusSquared)
+				out.push_back(e.actor);
+		});
+	}
+
+	void SpatialIndex::queryAABB(const glm::vec3& min, const glm::vec3& max, std::vector<Actor*>& out) const
+	{
+		out.clear();
+
+		this->forEachCandidate(min, max, [&](const Entry& e) {
+			if (overlaps(min, max, e.min, e.max))
+				out.push_back(e.actor);
+		});
+	}
+
+	// a frustum has no cheap bounds of it's own, so every occupied cell's loose box is tested against it
+	void SpatialIndex::queryFrustum(const std::array<glm::vec4, 6>& planes, std::vector<Actor*>& out) const
+	{
+		out.clear();
+
+		for (auto id : this->oversized)
+			if (inFrustum(planes, this->entries[id].min, this->entries[id].max))
+				out.push_back(this->entries[id].actor);
+
+		glm::vec3 loose(this->cellSize * 0.5f);
+		for (auto& cell : this->cells)
+		{
+			glm::vec3 cellMin = glm::vec3(this->cellFromKey(cell.first)) * this->cellSize;
+			if (!inFrustum(planes, cellMin - loose, cellMin + glm::vec3(this->cellSize) + loose))
+				continue;
+
+			for (auto id : cell.second)
+				if (inFrustum(planes, this->entries[id].min, this->entries[id].max))
+					out.push_back(this->entries[id].actor);
+		}
+	}
+
+	// grows a search sphere from one cell until it holds k actors, which then must include the k nearest
+	void SpatialIndex::queryNearest(const glm::vec3& point, size_t k, std::vector<Actor*>& out, float maxDistance) const
+	{
+		out.clear();
+		if (k == 0 || this->entryOf.empty())
+			return;
+
+		auto& found = nearestScratch;
+		float radius = std::min(this->cellSize, maxDistance);
+
+		while (true)
+		{
+			found.clear();
+
+			float radiusSquared = radius * radius;
+			this->forEachCandidate(point - glm::vec3(radius), point + glm::vec3(radius), [&](const Entry& e) {
+				float d = distanceSquared(point, e.min, e.max);
+				if (d <= radiusSquared)
+					found.push_back({ d, e.actor });
+			});
+
+			if (found.size() >= k || radius >= maxDistance || found.size() == this->entryOf.size())
+				break;
+
+			radius = std::min(radius * 2.0f, maxDistance);
+		}
+
+		size_t count = std::min(k, found.size());
+		std::partial_sort(found.begin(), found.begin() + count, found.end(), [](const std::pair<float, Actor*>& a, const std::pair<float, Actor*>& b) {
+			return a.first < b.first;
+		});
+
+		for (size_t i = 0; i < count; i++)
+			out.push_back(found[i].second);
+	}
+
+}
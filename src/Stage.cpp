@@ -1,4 +1,5 @@
 #include <iostream>
+#include <algorithm>
 
 #include "assimp/Importer.hpp"
 #include "assimp/scene.h"
@@ -6,6 +7,9 @@
 
 #include "vel/App.h"
 #include "vel/Stage.h"
+#include "vel/TickGraph.h"
+#include "vel/Profiler.h"
+#include "vel/ActorMotionState.h"
 
 
 
@@ -22,7 +26,11 @@ namespace vel
 		camera(nullptr),
 		clearDepthBuffer(false),
 		name(name),
-		useSceneCameraPositionForLighting(true)
+		useSceneCameraPositionForLighting(true),
+		tickedActorsVersion(Actor::getSimulationVersion() - 1),
+		worldActorsVersion(Actor::getSimulationVersion() - 1),
+		frustumCulling(true),
+		culledCount(0)
 	{}
 
 	Stage::~Stage()
@@ -72,7 +80,8 @@ namespace vel
 
 	Armature* Stage::addArmature(Armature a, std::string defaultAnimation, std::vector<std::string> actorsIn)
 	{
-		Armature* sa = this->armatures.insert(a.getName(), a);
+		Name armatureName = Name::interned(a.getName());
+		Armature* sa = this->armatures.insert(armatureName, std::move(a));
 		sa->playAnimation(defaultAnimation);
 
 		for (auto& actorName : actorsIn)
@@ -80,11 +89,11 @@ namespace vel
 			auto act = this->actors.get(actorName);
 			act->setArmature(sa);
 
-			std::vector<std::pair<size_t, std::string>> activeBones;
+			std::vector<std::pair<size_t, Name>> activeBones;
 			size_t index = 0;
 			for (auto& meshBone : act->getMesh()->getBones())
 			{
-				activeBones.push_back(std::pair<size_t, std::string>(act->getArmature()->getBoneIndex(meshBone.name), "bones[" + std::to_string(index) + "]"));
+				activeBones.push_back(std::pair<size_t, Name>(act->getArmature()->getBoneIndex(meshBone.name), Name("bones[" + std::to_string(index) + "]")));
 				index++;
 			}
 
@@ -129,36 +138,339 @@ namespace vel
 		this->camera = c;
 	}
 
+	// armatures only write to their own bones, so they can be updated in parallel
 	void Stage::updateFixedArmatureAnimations(double runTime)
 	{
-		for (auto a : this->armatures.getAll())
-			if(a->getShouldInterpolate())
+		TickGraph::access(this, true);
+
+		App::get().getJobSystem().parallelForEach(this->armatures.getAll(), 8, [runTime](Armature* a) {
+			if (a->getShouldInterpolate())
 				a->updateAnimation(runTime);
+		});
 	}
 
 	void Stage::updateArmatureAnimations(double runTime)
 	{
-		for (auto a : this->armatures.getAll())
+		App::get().getJobSystem().parallelForEach(this->armatures.getAll(), 8, [runTime](Armature* a) {
 			if (!a->getShouldInterpolate())
 				a->updateAnimation(runTime);
+		});
 	}
 
-	void Stage::applyTransformations()
+	void Stage::refreshTickedActors()
 	{
+		auto version = Actor::getSimulationVersion();
+		if (version == this->tickedActorsVersion)
+			return;
+
+		this->tickedActorsVersion = version;
+		this->previousTransformActors.clear();
+		this->polledRigidBodyActors.clear();
+		this->posedActors.clear();
+		this->animatedActors.clear();
+
 		for (auto a : this->actors.getAll())
-			a->processTransform();
+		{
+			if (a->getParentArmatureBone() != nullptr)
+				this->posedActors.push_back(a);
+
+			if (a->isAnimated())
+				this->animatedActors.push_back(a);
+
+			if (ActorMotionState::drives(a))
+				continue;
+
+			if (a->isDynamic())
+				this->previousTransformActors.push_back(a);
+
+			if (a->getRigidBody() != nullptr && a->getAutoTransform())
+				this->polledRigidBodyActors.push_back(a);
+		}
+	}
+
+	// the first half of applyTransformations, used when collision worlds are stepped in parallel
+	void Stage::updatePreviousTransforms()
+	{
+		TickGraph::access(this, true);
+
+		this->refreshTickedActors();
+
+		App::get().getJobSystem().parallelForEach(this->previousTransformActors, 256, [](Actor* a) {
+			a->updatePreviousTransform();
+		});
+	}
+
+	// the second half of applyTransformations, each actor only reads it's own rigidbody and writes it's own transform
+	void Stage::syncRigidBodyTransforms()
+	{
+		TickGraph::access(this, true);
+
+		this->refreshTickedActors();
+
+		if (TickGraph::validating())
+			for (auto a : this->polledRigidBodyActors)
+				if (a->getCollisionWorld() != nullptr)
+					TickGraph::access(a->getCollisionWorld(), false);
+
+		App::get().getJobSystem().parallelForEach(this->polledRigidBodyActors, 256, [](Actor* a) {
+			a->syncRigidBodyTransform();
+		});
+	}
+
+	// per tick cost follows the dynamic actors not driven by bullet and the rigidbodies bullet actually moved (which
+	// were already written by their ActorMotionState during the step), not the number of actors in the stage
+	void Stage::applyTransformations()
+	{
+		this->updatePreviousTransforms();
+		this->syncRigidBodyTransforms();
+	}
+
+	// only visits the actors that can have moved since the last tick: dynamic ones, polled rigidbodies, those
+	// posed by a bone, those bullet moved and those which handed out their transform (see Actor::getTransform()),
+	// along with the children of whichever actually changed. Adding, removing or reparenting an actor bumps the
+	// simulation version, which falls back to walking down from every root actor once. Children in another stage
+	// are left to refresh themselves when read
+	void Stage::updateWorldMatrices(const std::vector<CollisionWorld*>& collisionWorlds)
+	{
+		TickGraph::access(this, true);
+
+		this->refreshTickedActors();
+
+		auto version = Actor::getSimulationVersion();
+		if (version != this->worldActorsVersion)
+		{
+			this->worldActorsVersion = version;
+
+			for (auto a : this->dirtyActors)
+				a->setWorldQueued(false);
+
+			this->dirtyActors.clear();
+
+			for (auto a : this->actors.getAll())
+				if (a->getParentActor() == nullptr)
+					this->updateWorldMatrices(a, true);
+
+			this->updatePoseBounds();
+			return;
+		}
+
+		for (auto a : this->previousTransformActors)
+			this->updateWorldMatrices(a, false);
+
+		for (auto a : this->polledRigidBodyActors)
+			this->updateWorldMatrices(a, false);
+
+		for (auto a : this->posedActors)
+			this->updateWorldMatrices(a, false);
+
+		for (auto a : this->dirtyActors)
+		{
+			a->setWorldQueued(false);
+			this->updateWorldMatrices(a, false);
+		}
+
+		this->dirtyActors.clear();
+
+		// moved lists hold the actors of every stage
+		for (auto cw : collisionWorlds)
+		{
+			TickGraph::access(cw, false);
+
+			for (auto a : cw->getMovedActors())
+				if (this->actors.get(a->getStageHandle()) == a)
+					this->updateWorldMatrices(a, false);
+		}
+
+		this->updatePoseBounds();
+	}
+
+	// the pose doesn't touch the world matrix, so skinned actors are re-indexed every tick whether they moved or not
+	void Stage::updatePoseBounds()
+	{
+		for (auto a : this->animatedActors)
+		{
+			a->refreshPoseBounds();
+			this->actorIndex.update(a, a->getWorldBoundsMin(), a->getWorldBoundsMax());
+		}
+	}
+
+	void Stage::updateWorldMatrices(Actor* a, bool wholeHierarchy)
+	{
+		// walks up the parents first, one which moved may not have been visited yet
+		a->getWorldMatrix();
+
+		// the matrix may have been rebuilt since the last tick by anything reading it, so compare versions. When it
+		// hasn't changed neither have the children, unless they moved themselves (and are visited on their own)
+		if (a->getWorldVersion() != a->getSpatialIndexVersion())
+		{
+			this->actorIndex.update(a, a->getWorldBoundsMin(), a->getWorldBoundsMax());
+			a->setSpatialIndexVersion(a->getWorldVersion());
+		}
+		else if (!wholeHierarchy)
+		{
+			return;
+		}
+
+		for (auto c : a->getChildActors())
+			if (this->actors.get(c->getStageHandle()) == c)
+				this->updateWorldMatrices(c, wholeHierarchy);
+	}
+
+	void Stage::markMoved(Actor* a)
+	{
+		TickGraph::access(this, true);
+
+		if (a->isWorldQueued())
+			return;
+
+		a->setWorldQueued(true);
+		this->dirtyActors.push_back(a);
+	}
+
+	void Stage::queryActors(const glm::vec3& center, float radius, std::vector<Actor*>& out) const
+	{
+		TickGraph::access(this, false);
+		this->actorIndex.querySphere(center, radius, out);
+	}
+
+	void Stage::queryActors(const glm::vec3& min, const glm::vec3& max, std::vector<Actor*>& out) const
+	{
+		TickGraph::access(this, false);
+		this->actorIndex.queryAABB(min, max, out);
+	}
+
+	void Stage::queryActors(const std::array<glm::vec4, 6>& frustumPlanes, std::vector<Actor*>& out) const
+	{
+		TickGraph::access(this, false);
+		this->actorIndex.queryFrustum(frustumPlanes, out);
+	}
+
+	void Stage::queryNearestActors(const glm::vec3& point, size_t k, std::vector<Actor*>& out, float maxDistance) const
+	{
+		TickGraph::access(this, false);
+		this->actorIndex.queryNearest(point, k, out, maxDistance);
+	}
+
+	const SpatialIndex& Stage::getSpatialIndex() const
+	{
+		return this->actorIndex;
+	}
+
+	void Stage::setSpatialIndexCellSize(float cellSize)
+	{
+		this->actorIndex.setCellSize(cellSize);
+	}
+
+	// bounds are gathered into a BoundsBatch so they can be tested four at a time. They are those of the last tick
+	// (or later, reading the world matrix refreshes them), so an interpolated actor right at the edge of the view
+	// may be drawn a fraction of a tick late
+	void Stage::cull(const std::array<glm::vec4, 6>& frustumPlanes)
+	{
+		VEL_ZONE("Stage::cull");
+
+		auto& renderables = this->renderables.getAll();
+
+		this->visibleActors.clear();
+		this->visibleRenderableEnds.clear();
+		this->culledCount = 0;
+		this->transparents.begin();
+
+		for (auto r : renderables)
+		{
+			this->cullCandidates.clear();
+			this->cullBounds.clear();
+
+			for (auto a : r->actors.getAll())
+			{
+				if (!a->isVisible())
+					continue;
+
+				if (!this->frustumCulling)
+				{
+					this->visibleActors.push_back(a);
+					continue;
+				}
+
+				// animations not on the fixed tick pose every frame, so skinned bounds are refreshed here too
+				a->getWorldMatrix();
+				a->refreshPoseBounds();
+				this->cullCandidates.push_back(a);
+				this->cullBounds.push(a->getWorldBoundsMin(), a->getWorldBoundsMax());
+			}
+
+			this->cullResults.resize(this->cullCandidates.size());
+			this->cullBounds.cull(frustumPlanes, this->cullResults.data());
+
+			for (size_t i = 0; i < this->cullCandidates.size(); i++)
+			{
+				if (this->cullResults[i])
+					this->visibleActors.push_back(this->cullCandidates[i]);
+				else
+					this->culledCount++;
+			}
+
+			if (r->getMaterialHasAlpha())
+				for (size_t i = this->visibleRenderableEnds.empty() ? 0 : this->visibleRenderableEnds.back(); i < this->visibleActors.size(); i++)
+					this->transparents.add(this->visibleActors[i], r);
+
+			this->visibleRenderableEnds.push_back(this->visibleActors.size());
+		}
+	}
+
+	const std::vector<TransparentDrawList::Entry>& Stage::sortTransparents(const glm::vec3& eye)
+	{
+		VEL_ZONE("Stage::sortTransparents");
+
+		this->transparents.sort(eye);
+		return this->transparents.getEntries();
+	}
+
+	std::pair<Actor* const*, Actor* const*> Stage::getVisibleActors(size_t renderableIndex) const
+	{
+		size_t begin = renderableIndex == 0 ? 0 : this->visibleRenderableEnds[renderableIndex - 1];
+		size_t end = this->visibleRenderableEnds[renderableIndex];
+		return { this->visibleActors.data() + begin, this->visibleActors.data() + end };
+	}
+
+	size_t Stage::getVisibleCount() const
+	{
+		return this->visibleActors.size();
+	}
+
+	size_t Stage::getCulledCount() const
+	{
+		return this->culledCount;
+	}
+
+	void Stage::setFrustumCulling(bool b)
+	{
+		this->frustumCulling = b;
+	}
+
+	bool Stage::getFrustumCulling() const
+	{
+		return this->frustumCulling;
 	}
 
 	Actor* Stage::addActor(Actor a)
 	{
-		auto actor = this->actors.insert(a.getName(), a);
+		Name actorName = Name::interned(a.getName());
+		sac_handle actorHandle;
+		auto actor = this->actors.insert(actorName, std::move(a), &actorHandle);
+		actor->setStage(this);
+		actor->setStageHandle(actorHandle);
+		Actor::bumpSimulationVersion();
+
+		actor->getWorldMatrix();
+		this->actorIndex.update(actor, actor->getWorldBoundsMin(), actor->getWorldBoundsMax());
+		actor->setSpatialIndexVersion(actor->getWorldVersion());
 		
 		if (actor->getTempRenderable())
 		{
 			auto& tempRenderable = actor->getTempRenderable().value();
 
 			if (!this->renderables.exists(tempRenderable.getName()))
-				this->renderables.insert(tempRenderable.getName(), tempRenderable);
+				this->renderables.insert(Name::interned(tempRenderable.getName()), tempRenderable);
 				
 			auto actorStageRenderable = this->renderables.get(tempRenderable.getName());
 
@@ -166,20 +478,20 @@ namespace vel
 			
 			actor->clearTempRenderable();
 			
-			actorStageRenderable->actors.insert(actor->getName(), actor);
+			actor->setStageRenderableHandle(actorStageRenderable->actors.insert(actor));
 		}
 		// if adding an actor that does not have a tempRenderable pointer, BUT DOES have a 
 		// stageRenderable value, then we assume that this actor was derived from an existing
 		// actor, and we simply need to add it to that existing stageRenderable.
 		else if(!actor->getTempRenderable().has_value() && actor->getStageRenderable().has_value())
 		{
-			actor->getStageRenderable().value()->actors.insert(actor->getName(), actor);
+			actor->setStageRenderableHandle(actor->getStageRenderable().value()->actors.insert(actor));
 		}
 
 		return actor;
 	}
 
-	Actor* Stage::getActor(std::string name)
+	Actor* Stage::getActor(Name name)
 	{
 		return this->actors.get(name);
 	}
@@ -188,7 +500,7 @@ namespace vel
 	{
 		// free actor slot in renderable
 		if(a->getStageRenderable())
-			a->getStageRenderable().value()->actors.erase(a->getName());
+			a->getStageRenderable().value()->actors.erase(a->getStageRenderableHandle());
 
 		// remove all sensors associated with this actor
 		for(auto s : a->getContactSensors())
@@ -211,9 +523,16 @@ namespace vel
 			a->setGhostObject(nullptr);
 		}
 
+		if (a->isWorldQueued())
+			this->dirtyActors.erase(std::remove(this->dirtyActors.begin(), this->dirtyActors.end(), a), this->dirtyActors.end());
+
+		a->setStage(nullptr);
+
 		// mark actor as deleted (since it's value will persist in memory) and "remove" from sac
 		a->setDeleted(true);
-		this->actors.erase(a->getName());
+		this->actorIndex.remove(a);
+		this->actors.erase(a->getStageHandle());
+		Actor::bumpSimulationVersion();
 	}
 
 	void Stage::removeActor(Actor* a)
@@ -0,0 +1,167 @@
+#include <algorithm>
+#include <sstream>
+
+#include "vel/TickGraph.h"
+#include "vel/Log.h"
+#include "vel/Profiler.h"
+
+
+namespace vel
+{
+	std::atomic<bool> TickGraph::validation(false);
+
+	// task the current thread is executing, only tracked while validating. Saved and restored around each
+	// task as a thread waiting inside one task can pick up another
+	static thread_local const void* currentTask = nullptr;
+
+	static bool intersects(const std::vector<const void*>& a, const std::vector<const void*>& b)
+	{
+		for (auto r : a)
+			if (std::find(b.begin(), b.end(), r) != b.end())
+				return true;
+
+		return false;
+	}
+
+	bool TickGraph::conflicts(const Task& a, const Task& b)
+	{
+		return intersects(a.writes, b.writes) || intersects(a.writes, b.reads) || intersects(a.reads, b.writes);
+	}
+
+	void TickGraph::clear()
+	{
+		this->tasks.clear();
+		this->segments.clear();
+	}
+
+	bool TickGraph::empty() const
+	{
+		return this->tasks.empty();
+	}
+
+	void TickGraph::addTask(std::string name, std::function<void()> fn, std::vector<const void*> reads, std::vector<const void*> writes)
+	{
+		Task t;
+		t.name = std::move(name);
+		t.zoneName = Profiler::intern(t.name);
+		t.fn = std::move(fn);
+		t.reads = std::move(reads);
+		t.writes = std::move(writes);
+
+		size_t index = this->tasks.size();
+
+		if (this->segments.empty() || this->segments.back().mainThread)
+			this->segments.push_back(Segment{ index, index, false });
+
+		// main thread tasks are barriers, so only tasks within the same segment can be running alongside
+		for (size_t i = this->segments.back().begin; i < index; i++)
+		{
+			if (TickGraph::conflicts(this->tasks[i], t))
+			{
+				this->tasks[i].dependents.push_back(index);
+				t.dependencyCount++;
+			}
+		}
+
+		this->tasks.push_back(std::move(t));
+		this->segments.back().end = index + 1;
+	}
+
+	void TickGraph::addMainThreadTask(std::string name, std::function<void()> fn)
+	{
+		Task t;
+		t.name = std::move(name);
+		t.zoneName = Profiler::intern(t.name);
+		t.fn = std::move(fn);
+
+		size_t index = this->tasks.size();
+		this->tasks.push_back(std::move(t));
+		this->segments.push_back(Segment{ index, index + 1, true });
+	}
+
+	void TickGraph::execute(size_t index)
+	{
+		VEL_ZONE(this->tasks[index].zoneName);
+
+		if (!TickGraph::validating())
+		{
+			this->tasks[index].fn();
+			return;
+		}
+
+		auto previous = currentTask;
+		currentTask = &this->tasks[index];
+		this->tasks[index].fn();
+		currentTask = previous;
+	}
+
+	void TickGraph::submit(size_t index, JobSystem& js, JobCounter& done)
+	{
+		js.run([this, index, &js, &done] {
+			this->execute(index);
+
+			// dependents are queued before this job signals done, so done can't reach zero early
+			for (auto d : this->tasks[index].dependents)
+				if (this->remaining[d].fetch_sub(1, std::memory_order_acq_rel) == 1)
+					this->submit(d, js, done);
+		}, &done);
+	}
+
+	void TickGraph::run(JobSystem& js)
+	{
+		if (this->remainingSize < this->tasks.size())
+		{
+			this->remaining = std::make_unique<std::atomic<size_t>[]>(this->tasks.size());
+			this->remainingSize = this->tasks.size();
+		}
+
+		for (auto& s : this->segments)
+		{
+			if (s.mainThread)
+			{
+				// touches everything, so there is nothing to validate against
+				VEL_ZONE(this->tasks[s.begin].zoneName);
+				auto previous = currentTask;
+				currentTask = nullptr;
+				this->tasks[s.begin].fn();
+				currentTask = previous;
+				continue;
+			}
+
+			for (size_t i = s.begin; i < s.end; i++)
+				this->remaining[i].store(this->tasks[i].dependencyCount, std::memory_order_relaxed);
+
+			JobCounter done;
+			for (size_t i = s.begin; i < s.end; i++)
+				if (this->tasks[i].dependencyCount == 0)
+					this->submit(i, js, done);
+
+			js.wait(done);
+		}
+	}
+
+	void TickGraph::setValidation(bool b)
+	{
+		TickGraph::validation.store(b, std::memory_order_relaxed);
+	}
+
+	void TickGraph::access(const void* resource, bool write)
+	{
+		if (!TickGraph::validating() || currentTask == nullptr)
+			return;
+
+		auto task = static_cast<const Task*>(currentTask);
+
+		bool declared = std::find(task->writes.begin(), task->writes.end(), resource) != task->writes.end();
+		if (!declared && !write)
+			declared = std::find(task->reads.begin(), task->reads.end(), resource) != task->reads.end();
+
+		if (!declared)
+		{
+			std::stringstream ss;
+			ss << "TickGraph::access(): task '" << task->name << "' made an undeclared " << (write ? "write" : "read") << " of resource " << resource;
+			Log::crash(ss.str());
+		}
+	}
+
+}
@@ -14,13 +14,45 @@ namespace vel
     Transform::Transform() :
         translation(glm::vec3(0.0f, 0.0f, 0.0f)),
         scale(glm::vec3(1.0f, 1.0f, 1.0f)),
-		rotation(glm::quat())
+		rotation(glm::quat()),
+		matrixDirty(true),
+		version(0)
     {}
 
     Transform::Transform(glm::vec3 t, glm::quat r, glm::vec3 s) :
         translation(t), 
         rotation(r), 
-        scale(s){}   
+        scale(s),
+		matrixDirty(true),
+		version(0){}   
+
+	// assigning over a transform is a change like any other, so the version moves on from our own rather than
+	// taking the other's (which could match a version something was built from before)
+	Transform& Transform::operator=(const Transform& other)
+	{
+		this->translation = other.translation;
+		this->rotation = other.rotation;
+		this->scale = other.scale;
+		this->matrix = other.matrix;
+		this->matrixDirty = other.matrixDirty;
+		this->version++;
+		return *this;
+	}
+
+	bool Transform::operator==(const Transform& other) const
+	{
+		return this->translation == other.translation && this->rotation == other.rotation && this->scale == other.scale;
+	}
+
+	bool Transform::operator!=(const Transform& other) const
+	{
+		return !(*this == other);
+	}
+
+	uint32_t Transform::getVersion() const
+	{
+		return this->version;
+	}
 
     void Transform::print()
     {
@@ -39,21 +71,29 @@ namespace vel
     void Transform::setTranslation(glm::vec3 translation) 
     {
         this->translation = translation;
+		this->matrixDirty = true;
+		this->version++;
     }
 
 	void Transform::setRotation(glm::quat rotation)
 	{
 		this->rotation = rotation;
+		this->matrixDirty = true;
+		this->version++;
 	}
 
     void Transform::setRotation(float angle, glm::vec3 axis)
     {
 		this->rotation = glm::angleAxis(glm::radians(angle), axis);
+		this->matrixDirty = true;
+		this->version++;
     }
 
     void Transform::setScale(glm::vec3 scale)
     {
         this->scale = scale;
+		this->matrixDirty = true;
+		this->version++;
     }
 
     const glm::vec3& Transform::getTranslation() const
@@ -71,13 +111,19 @@ namespace vel
         return this->scale;
     }
 
-    const glm::mat4 Transform::getMatrix() const
+    // only rebuilt after a change, note this means reading the matrix writes the cache
+    const glm::mat4& Transform::getMatrix() const
     {
-        glm::mat4 m = glm::mat4(1.0f);
-        m = glm::translate(m, this->translation);
-		m = m * glm::toMat4(this->rotation);
-        m = glm::scale(m, this->scale);
-        return m;
+		if (this->matrixDirty)
+		{
+			glm::mat4 m = glm::mat4(1.0f);
+			m = glm::translate(m, this->translation);
+			m = m * glm::toMat4(this->rotation);
+			m = glm::scale(m, this->scale);
+			this->matrix = m;
+			this->matrixDirty = false;
+		}
+        return this->matrix;
     }
 
 	glm::vec3 Transform::interpolateTranslations(const Transform& previousTransform, const Transform& currentTransform, float alpha)
@@ -0,0 +1,183 @@
+#include <cmath>
+
+#include "vel/TransformBatch.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEL_TRANSFORM_BATCH_SSE
+#include <emmintrin.h>
+#endif
+
+
+namespace vel
+{
+	size_t TransformBatch::size() const
+	{
+		return this->current[TX].size();
+	}
+
+	void TransformBatch::clear()
+	{
+		for (size_t c = 0; c < COUNT; c++)
+		{
+			this->previous[c].clear();
+			this->current[c].clear();
+		}
+	}
+
+	void TransformBatch::reserve(size_t n)
+	{
+		for (size_t c = 0; c < COUNT; c++)
+		{
+			this->previous[c].reserve(n);
+			this->current[c].reserve(n);
+		}
+	}
+
+	uint32_t TransformBatch::push(const float* previousTRS, const float* currentTRS)
+	{
+		for (size_t c = 0; c < COUNT; c++)
+		{
+			this->previous[c].push_back(previousTRS[c]);
+			this->current[c].push_back(currentTRS[c]);
+		}
+
+		return (uint32_t)(this->size() - 1);
+	}
+
+	void TransformBatch::interpolate(float alpha, float* out) const
+	{
+		size_t n = this->size();
+		size_t i = 0;
+
+#ifdef VEL_TRANSFORM_BATCH_SSE
+		const __m128 a = _mm_set1_ps(alpha);
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 two = _mm_set1_ps(2.0f);
+		const __m128 signBit = _mm_set1_ps(-0.0f);
+
+		for (; i + 4 <= n; i += 4)
+		{
+			auto lerp = [&](Component c) {
+				__m128 p = _mm_loadu_ps(this->previous[c].data() + i);
+				__m128 q = _mm_loadu_ps(this->current[c].data() + i);
+				return _mm_add_ps(p, _mm_mul_ps(_mm_sub_ps(q, p), a));
+			};
+
+			__m128 tx = lerp(TX), ty = lerp(TY), tz = lerp(TZ);
+			__m128 sx = lerp(SX), sy = lerp(SY), sz = lerp(SZ);
+
+			// nlerp, flipping the current rotation where it's more than 90 degrees away so the shortest arc is taken
+			__m128 px = _mm_loadu_ps(this->previous[RX].data() + i);
+			__m128 py = _mm_loadu_ps(this->previous[RY].data() + i);
+			__m128 pz = _mm_loadu_ps(this->previous[RZ].data() + i);
+			__m128 pw = _mm_loadu_ps(this->previous[RW].data() + i);
+			__m128 cx = _mm_loadu_ps(this->current[RX].data() + i);
+			__m128 cy = _mm_loadu_ps(this->current[RY].data() + i);
+			__m128 cz = _mm_loadu_ps(this->current[RZ].data() + i);
+			__m128 cw = _mm_loadu_ps(this->current[RW].data() + i);
+
+			__m128 dot = _mm_add_ps(_mm_add_ps(_mm_mul_ps(px, cx), _mm_mul_ps(py, cy)), _mm_add_ps(_mm_mul_ps(pz, cz), _mm_mul_ps(pw, cw)));
+			__m128 flip = _mm_and_ps(_mm_cmplt_ps(dot, zero), signBit);
+			cx = _mm_xor_ps(cx, flip);
+			cy = _mm_xor_ps(cy, flip);
+			cz = _mm_xor_ps(cz, flip);
+			cw = _mm_xor_ps(cw, flip);
+
+			__m128 rx = _mm_add_ps(px, _mm_mul_ps(_mm_sub_ps(cx, px), a));
+			__m128 ry = _mm_add_ps(py, _mm_mul_ps(_mm_sub_ps(cy, py), a));
+			__m128 rz = _mm_add_ps(pz, _mm_mul_ps(_mm_sub_ps(cz, pz), a));
+			__m128 rw = _mm_add_ps(pw, _mm_mul_ps(_mm_sub_ps(cw, pw), a));
+
+			__m128 length = _mm_sqrt_ps(_mm_add_ps(_mm_add_ps(_mm_mul_ps(rx, rx), _mm_mul_ps(ry, ry)), _mm_add_ps(_mm_mul_ps(rz, rz), _mm_mul_ps(rw, rw))));
+			__m128 inv = _mm_div_ps(one, length);
+			rx = _mm_mul_ps(rx, inv);
+			ry = _mm_mul_ps(ry, inv);
+			rz = _mm_mul_ps(rz, inv);
+			rw = _mm_mul_ps(rw, inv);
+
+			// rotation matrix of the quaternion (as glm::mat3_cast), columns scaled
+			__m128 xx = _mm_mul_ps(rx, rx), yy = _mm_mul_ps(ry, ry), zz = _mm_mul_ps(rz, rz);
+			__m128 xy = _mm_mul_ps(rx, ry), xz = _mm_mul_ps(rx, rz), yz = _mm_mul_ps(ry, rz);
+			__m128 wx = _mm_mul_ps(rw, rx), wy = _mm_mul_ps(rw, ry), wz = _mm_mul_ps(rw, rz);
+
+			__m128 c0[4] = {
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(yy, zz))), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xy, wz)), sx),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xz, wy)), sx),
+				zero
+			};
+			__m128 c1[4] = {
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(xy, wz)), sy),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, zz))), sy),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(yz, wx)), sy),
+				zero
+			};
+			__m128 c2[4] = {
+				_mm_mul_ps(_mm_mul_ps(two, _mm_add_ps(xz, wy)), sz),
+				_mm_mul_ps(_mm_mul_ps(two, _mm_sub_ps(yz, wx)), sz),
+				_mm_mul_ps(_mm_sub_ps(one, _mm_mul_ps(two, _mm_add_ps(xx, yy))), sz),
+				zero
+			};
+			__m128 c3[4] = { tx, ty, tz, one };
+
+			// each register holds one element for four transforms, transpose so each holds a column of one
+			__m128* columns[4] = { c0, c1, c2, c3 };
+			for (size_t c = 0; c < 4; c++)
+			{
+				__m128* col = columns[c];
+				_MM_TRANSPOSE4_PS(col[0], col[1], col[2], col[3]);
+				for (size_t lane = 0; lane < 4; lane++)
+					_mm_storeu_ps(out + (i + lane) * 16 + c * 4, col[lane]);
+			}
+		}
+#endif
+
+		for (; i < n; i++)
+		{
+			auto lerp = [&](Component c) { return this->previous[c][i] + (this->current[c][i] - this->previous[c][i]) * alpha; };
+
+			float tx = lerp(TX), ty = lerp(TY), tz = lerp(TZ);
+			float sx = lerp(SX), sy = lerp(SY), sz = lerp(SZ);
+
+			float px = this->previous[RX][i], py = this->previous[RY][i], pz = this->previous[RZ][i], pw = this->previous[RW][i];
+			float cx = this->current[RX][i], cy = this->current[RY][i], cz = this->current[RZ][i], cw = this->current[RW][i];
+			if (px * cx + py * cy + pz * cz + pw * cw < 0.0f)
+			{
+				cx = -cx;
+				cy = -cy;
+				cz = -cz;
+				cw = -cw;
+			}
+
+			float rx = px + (cx - px) * alpha;
+			float ry = py + (cy - py) * alpha;
+			float rz = pz + (cz - pz) * alpha;
+			float rw = pw + (cw - pw) * alpha;
+			float inv = 1.0f / std::sqrt(rx * rx + ry * ry + rz * rz + rw * rw);
+			rx *= inv;
+			ry *= inv;
+			rz *= inv;
+			rw *= inv;
+
+			float* m = out + i * 16;
+			m[0] = (1.0f - 2.0f * (ry * ry + rz * rz)) * sx;
+			m[1] = 2.0f * (rx * ry + rw * rz) * sx;
+			m[2] = 2.0f * (rx * rz - rw * ry) * sx;
+			m[3] = 0.0f;
+			m[4] = 2.0f * (rx * ry - rw * rz) * sy;
+			m[5] = (1.0f - 2.0f * (rx * rx + rz * rz)) * sy;
+			m[6] = 2.0f * (ry * rz + rw * rx) * sy;
+			m[7] = 0.0f;
+			m[8] = 2.0f * (rx * rz + rw * ry) * sz;
+			m[9] = 2.0f * (ry * rz - rw * rx) * sz;
+			m[10] = (1.0f - 2.0f * (rx * rx + ry * ry)) * sz;
+			m[11] = 0.0f;
+			m[12] = tx;
+			m[13] = ty;
+			m[14] = tz;
+			m[15] = 1.0f;
+		}
+	}
+
+}
@@ -0,0 +1,195 @@
+#include <cstring>
+
+#include "vel/TransparentDrawList.h"
+#include "vel/Actor.h"
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define VEL_TRANSPARENT_DRAW_LIST_SSE
+#include <emmintrin.h>
+#endif
+
+
+namespace vel
+{
+	void TransparentDrawList::begin()
+	{
+		this->frame++;
+		this->incoming.clear();
+	}
+
+	void TransparentDrawList::add(Actor* a, Renderable* r)
+	{
+		uint32_t slot = a->getStageHandle().index;
+		if (slot >= this->slotFrame.size())
+		{
+			this->slotFrame.resize(slot + 1, 0);
+			this->slotIncoming.resize(slot + 1, 0);
+		}
+
+		this->slotFrame[slot] = this->frame;
+		this->slotIncoming[slot] = (uint32_t)this->incoming.size();
+		this->incoming.push_back({ a, r, slot, false });
+	}
+
+	void TransparentDrawList::sort(const glm::vec3& eye)
+	{
+		// actors still visible keep last frame's order, the rest are appended. Entries of actors removed since
+		// last frame are never dereferenced, only their slot is looked at
+		this->nextEntries.clear();
+		for (auto& e : this->entries)
+		{
+			if (e.slot >= this->slotFrame.size() || this->slotFrame[e.slot] != this->frame)
+				continue;
+
+			auto& in = this->incoming[this->slotIncoming[e.slot]];
+			if (in.actor != e.actor || in.placed)
+				continue;
+
+			in.placed = true;
+			this->nextEntries.push_back({ in.actor, in.renderable, in.slot });
+		}
+
+		for (auto& in : this->incoming)
+			if (!in.placed)
+				this->nextEntries.push_back({ in.actor, in.renderable, in.slot });
+
+		this->entries.swap(this->nextEntries);
+
+		// squared distances to the eye, ordering by them is the same as ordering by distance
+		size_t n = this->entries.size();
+		for (size_t c = 0; c < 3; c++)
+			this->positions[c].resize(n);
+		this->keys.resize(n);
+
+		for (size_t i = 0; i < n; i++)
+		{
+			const glm::mat4& m = this->entries[i].actor->getWorldMatrix();
+			this->positions[0][i] = m[3].x;
+			this->positions[1][i] = m[3].y;
+			this->positions[2][i] = m[3].z;
+		}
+
+		size_t i = 0;
+#ifdef VEL_TRANSPARENT_DRAW_LIST_SSE
+		const __m128 ex = _mm_set1_ps(eye.x);
+		const __m128 ey = _mm_set1_ps(eye.y);
+		const __m128 ez = _mm_set1_ps(eye.z);
+		for (; i + 4 <= n; i += 4)
+		{
+			__m128 dx = _mm_sub_ps(_mm_loadu_ps(this->positions[0].data() + i), ex);
+			__m128 dy = _mm_sub_ps(_mm_loadu_ps(this->positions[1].data() + i), ey);
+			__m128 dz = _mm_sub_ps(_mm_loadu_ps(this->positions[2].data() + i), ez);
+			_mm_storeu_ps(this->keys.data() + i, _mm_add_ps(_mm_add_ps(_mm_mul_ps(dx, dx), _mm_mul_ps(dy, dy)), _mm_mul_ps(dz, dz)));
+		}
+#endif
+		for (; i < n; i++)
+		{
+			float dx = this->positions[0][i] - eye.x;
+			float dy = this->positions[1][i] - eye.y;
+			float dz = this->positions[2][i] - eye.z;
+			this->keys[i] = (dx * dx + dy * dy) + dz * dz;
+		}
+
+		// a few moves per entry covers the usual frame to frame drift
+		if (!this->insertionSort(n * 4 + 16))
+			this->radixSort();
+	}
+
+	// furthest first
+	bool TransparentDrawList::insertionSort(size_t maxMoves)
+	{
+		size_t moves = 0;
+
+		for (size_t i = 1; i < this->entries.size(); i++)
+		{
+			float key = this->keys[i];
+			Entry entry = this->entries[i];
+
+			size_t j = i;
+			while (j > 0 && this->keys[j - 1] < key)
+			{
+				this->keys[j] = this->keys[j - 1];
+				this->entries[j] = this->entries[j - 1];
+				j--;
+
+				if (++moves > maxMoves)
+				{
+					this->keys[j] = key;
+					this->entries[j] = entry;
+					return false;
+				}
+			}
+
+			this->keys[j] = key;
+			this->entries[j] = entry;
+		}
+
+		return true;
+	}
+
+	// LSD radix sort, 11 bits per pass. Keys are never negative so their bit patterns order the same way as their
+	// values, inverting them makes an ascending sort put the furthest first
+	void TransparentDrawList::radixSort()
+	{
+		const size_t bits = 11;
+		const size_t buckets = (size_t)1 << bits;
+
+		size_t n = this->entries.size();
+		for (size_t b = 0; b < 2; b++)
+		{
+			this->radixKeys[b].resize(n);
+			this->radixOrder[b].resize(n);
+		}
+
+		for (size_t i = 0; i < n; i++)
+		{
+			uint32_t k;
+			std::memcpy(&k, &this->keys[i], sizeof(k));
+			this->radixKeys[0][i] = ~k;
+			this->radixOrder[0][i] = (uint32_t)i;
+		}
+
+		size_t src = 0;
+		for (size_t shift = 0; shift < 32; shift += bits)
+		{
+			uint32_t counts[buckets] = {};
+			for (size_t i = 0; i < n; i++)
+				counts[(this->radixKeys[src][i] >> shift) & (buckets - 1)]++;
+
+			uint32_t offset = 0;
+			for (size_t b = 0; b < buckets; b++)
+			{
+				uint32_t c = counts[b];
+				counts[b] = offset;
+				offset += c;
+			}
+
+			size_t dst = src ^ 1;
+			for (size_t i = 0; i < n; i++)
+			{
+				uint32_t k = this->radixKeys[src][i];
+				uint32_t to = counts[(k >> shift) & (buckets - 1)]++;
+				this->radixKeys[dst][to] = k;
+				this->radixOrder[dst][to] = this->radixOrder[src][i];
+			}
+			src = dst;
+		}
+
+		this->nextEntries.resize(n);
+		for (size_t i = 0; i < n; i++)
+		{
+			this->nextEntries[i] = this->entries[this->radixOrder[src][i]];
+
+			uint32_t k = ~this->radixKeys[src][i];
+			std::memcpy(&this->keys[i], &k, sizeof(k));
+		}
+
+		this->entries.swap(this->nextEntries);
+	}
+
+	const std::vector<TransparentDrawList::Entry>& TransparentDrawList::getEntries() const
+	{
+		return this->entries;
+	}
+
+}
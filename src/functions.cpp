@@ -153,4 +153,25 @@ namespace vel
 		return (a * (1.0 - f)) + (b * f);
 	}
 
+	// Gribb/Hartmann, each plane is a row of the matrix added to or subtracted from the fourth. xyz is the normal,
+	// pointing into the frustum, and w the distance so a point p is inside when dot(xyz, p) + w >= 0
+	std::array<glm::vec4, 6> frustumPlanes(const glm::mat4& viewProjection)
+	{
+		auto row = [&viewProjection](int r) { return glm::vec4(viewProjection[0][r], viewProjection[1][r], viewProjection[2][r], viewProjection[3][r]); };
+
+		std::array<glm::vec4, 6> planes = {
+			row(3) + row(0),
+			row(3) - row(0),
+			row(3) + row(1),
+			row(3) - row(1),
+			row(3) + row(2),
+			row(3) - row(2)
+		};
+
+		for (auto& p : planes)
+			p /= glm::length(glm::vec3(p));
+
+		return planes;
+	}
+
 }
\ No newline at end of file